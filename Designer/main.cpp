@@ -5,57 +5,17 @@
  * @LastEditors: Ye Guosheng
  * @Description: CSP
  */
+#include "threadPool/channel.hpp"
+#include "threadPool/pipeline.hpp"
 #include <chrono>
 #include <condition_variable>
 #include <future>
 #include <iostream>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
-
-template <typename T> class Channel {
-public:
-    Channel(size_t capacity = 0)
-        : _capacity(capacity) {}
-    bool send(T value) {
-        std::unique_lock<std::mutex> lock(_mtx);
-        _condProducer.wait(lock, [this]() {
-            return (_capacity == 0 && _queue.empty()) ||
-                   _queue.size() < _capacity || _closed;
-        });
-
-        if (_closed) return false;
-
-        _queue.push(value);
-        _condComsumer.notify_one();
-        return true;
-    }
-    bool receive(T &value) {
-        std::unique_lock<std::mutex> lock(_mtx);
-        _condComsumer.wait(lock,
-                           [this]() { return !_queue.empty() || _closed; });
-        if (_closed && _queue.empty()) return false;
-
-        value = _queue.front();
-        _queue.pop();
-        _condProducer.notify_one();
-        return true;
-    };
-    void close() {
-        std::unique_lock<std::mutex> lock(_mtx);
-        _closed = true;
-        _condComsumer.notify_all();
-        _condProducer.notify_all();
-    }
-
-private:
-    std::queue<T>           _queue;
-    std::mutex              _mtx;
-    std::condition_variable _condProducer;
-    std::condition_variable _condComsumer;
-    size_t                  _capacity;
-    bool                    _closed = false;
-};
+#include <vector>
 
 void test_channel() {
     Channel<int> ch(10);
@@ -64,6 +24,7 @@ void test_channel() {
             ch.send(i);
             std::cout << "send: " << i << " " << std::endl;
         }
+        ch.close();
     });
     std::thread  comsumer([&]() {
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
@@ -77,7 +38,50 @@ void test_channel() {
     comsumer.join();
 }
 
+/// @brief 一个线程同时等待两个通道, 两个通道都关闭后结束
+void test_select() {
+    Channel<int>         numbers(16);
+    Channel<std::string> words(16);
+    std::thread          producer([&]() {
+        for (int i = 0; i < 5; ++i) {
+            numbers.send(i);
+            words.send("word" + std::to_string(i));
+        }
+        numbers.close();
+        words.close();
+    });
+
+    Select select;
+    select.on_receive(numbers, [](int value) { std::cout << "number: " << value << std::endl; })
+        .on_receive(words, [](std::string value) { std::cout << "word: " << value << std::endl; });
+    while (select.wait() != Select::kClosed) {
+    }
+    producer.join();
+}
+
+/// @brief producer -> parse -> enrich -> sink, 每个阶段声明并行度, 结束后打印各阶段吞吐和积压
+void test_pipeline() {
+    PipelineOptions options;
+    options.capacity = 256;
+    options.ordered  = true;
+
+    long checksum = 0;
+    auto pipeline = make_pipeline<std::string>(options)
+                        .stage("parse", 4, [](std::string line) { return std::stol(line); })
+                        .stage("enrich", 2, [](long value) { return value * 2 + 1; })
+                        .sink("sink", [&checksum](long value) { checksum = checksum * 31 + value; });
+
+    std::vector<std::string> lines;
+    for (int i = 0; i < 100000; ++i) {
+        lines.push_back(std::to_string(i));
+    }
+    PipelineStats stats = pipeline.run(lines.begin(), lines.end());
+    std::cout << "checksum: " << checksum << std::endl << stats.to_string();
+}
+
 int main() {
     test_channel();
+    // test_select();
+    // test_pipeline();
     return 0;
 }
\ No newline at end of file
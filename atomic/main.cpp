@@ -5,11 +5,15 @@
  * @LastEditors: Ye Guosheng
  i* @Description:
  */
+#include "threadPool/spin_lock.hpp"
 #include <atomic>
 #include <cassert>
 #include <iostream>
 #include <thread>
 #include <vector>
+
+// 最简单的自旋锁: 每轮自旋都是一次写, 缓存行在等待者之间来回搬, 没有退避也不公平.
+// 可伸缩的版本 (TTASLock / TicketLock / MCSLock / SpinThenParkLock) 见 threadPool/spin_lock.hpp
 class SpinkLock {
 public:
     void lock() {
@@ -22,8 +26,9 @@ private:
     std::atomic_flag _atoFlag = ATOMIC_FLAG_INIT;
 };
 
+template <typename Lock = SpinkLock>
 void test_spink_lock() {
-    SpinkLock   spinklock;
+    Lock        spinklock;
     std::thread t1([&spinklock]() {
         spinklock.lock();
         for (int i = 0; i < 10; ++i) {
@@ -239,6 +244,7 @@ void test_consume_dependency() {
 
 int main() {
     // test_spink_lock();
+    // test_spink_lock<MCSLock>();
     // test_memory_relaxed();
     // test_order_relaxed();
     // test_order_seq_cst()
@@ -0,0 +1,183 @@
+/***
+ * @Description: 容器基准: 队列/栈 (含有界环形队列) 的生产者消费者吞吐, 映射表的读写混合, 统计计数器的开销
+ */
+#include "bench_workloads.hpp"
+#include "circular_queue/circular_queue.hpp"
+#include "lock_free_queue/LockFreeQueue.hpp"
+#include "lock_free_stack/LockFreeStack.hpp"
+#include "threadPool/channel.hpp"
+#include "threadPool/distributed_shared_mutex.hpp"
+#include "threadPool/lock_free_thread_safe_queue.hpp"
+#include "threadPool/sharded_counter.hpp"
+#include "threadPool/thread_safe_queue.hpp"
+#include "thread_safe_stack_queue/thread_safe_queue_ht.hpp"
+#include "thread_safe_stack_queue/thread_safe_stack_wait.hpp"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#if __cplusplus >= 201703L
+#include "thread_safe_hash_table/ThreadSafeLookupTable.hpp" // 依赖 std::shared_mutex
+
+using DistributedLookUpTable = ThreadSafeLookUpTable<long, long, std::hash<long>, DistributedSharedMutex>;
+using BenchSharedMutex       = std::shared_mutex;
+constexpr char kSharedMutexLabel[] = "unordered_map+shared_mutex";
+#else
+using BenchSharedMutex = std::shared_timed_mutex; // C++14 没有 std::shared_mutex
+constexpr char kSharedMutexLabel[] = "unordered_map+shared_timed_mutex";
+#endif
+
+void run_mutex_queue_benchmarks(BenchOptions const &options_, BenchReport &report_);
+
+namespace {
+
+class BoundedChannel : public Channel<long> {
+public:
+    BoundedChannel()
+        : Channel<long>(1024) {}
+};
+
+/// 环形队列满时 push 返回 false, 生产者让出 CPU 后重试
+constexpr std::size_t kRingCapacity = 1024;
+
+using MutexRing       = CircularQueue<long, kRingCapacity>;
+using SeqRing         = CircularQueueSeq<long, kRingCapacity>;
+using LightweightRing = CircularQueueLightweight<long, kRingCapacity>;
+
+template <typename Ring>
+void push_until_accepted(Ring &ring_, long value_) {
+    while (!ring_.push(value_)) std::this_thread::yield();
+}
+
+/// 三种锁都配 unordered_map, 只比较锁本身
+struct MutexMap {
+    std::mutex                     mtx;
+    std::unordered_map<long, long> map;
+};
+
+struct SharedMutexMap {
+    BenchSharedMutex               mtx;
+    std::unordered_map<long, long> map;
+};
+
+struct DistributedMutexMap {
+    DistributedSharedMutex         mtx;
+    std::unordered_map<long, long> map;
+};
+
+struct AtomicCounter {
+    std::atomic<std::uint64_t> value{0};
+};
+
+void run_queue_benchmarks(BenchOptions const &options_, BenchReport &report_) {
+    bench_producer_consumer<ThreadSafeQueue<long>>(
+        "ThreadSafeQueue(head/tail)", options_, report_, [](ThreadSafeQueue<long> &q_, long v_) { q_.push(v_); },
+        [](ThreadSafeQueue<long> &q_, long &v_) { return q_.try_pop(v_); });
+    bench_producer_consumer<ThreadSafeQueueHT<long>>(
+        "ThreadSafeQueueHT", options_, report_, [](ThreadSafeQueueHT<long> &q_, long v_) { q_.push(v_); },
+        [](ThreadSafeQueueHT<long> &q_, long &v_) { return q_.try_pop(v_); });
+    bench_producer_consumer<LockFreeThreadSafeQueue<long>>(
+        "LockFreeThreadSafeQueue", options_, report_,
+        [](LockFreeThreadSafeQueue<long> &q_, long v_) { q_.push(v_); },
+        [](LockFreeThreadSafeQueue<long> &q_, long &v_) { return q_.try_pop(v_); });
+    bench_producer_consumer<LockFreeQueue<long>>(
+        "LockFreeQueue", options_, report_, [](LockFreeQueue<long> &q_, long v_) { q_.push(v_); },
+        [](LockFreeQueue<long> &q_, long &v_) {
+            std::unique_ptr<long> p = q_.pop();
+            if (!p) return false;
+            v_ = *p;
+            return true;
+        });
+    bench_producer_consumer<BoundedChannel>(
+        "Channel(1024)", options_, report_, [](BoundedChannel &c_, long v_) { c_.send(v_); },
+        [](BoundedChannel &c_, long &v_) { return c_.try_receive(v_) == ChannelStatus::Success; });
+    bench_producer_consumer<MutexRing>("CircularQueue(1024)", options_, report_, push_until_accepted<MutexRing>,
+                                       [](MutexRing &q_, long &v_) { return q_.pop(v_); });
+    bench_producer_consumer<SeqRing>("CircularQueueSeq(1024)", options_, report_, push_until_accepted<SeqRing>,
+                                     [](SeqRing &q_, long &v_) { return q_.pop(v_); });
+    bench_producer_consumer<LightweightRing>("CircularQueueLightweight(1024)", options_, report_,
+                                             push_until_accepted<LightweightRing>,
+                                             [](LightweightRing &q_, long &v_) { return q_.pop(v_); });
+    run_mutex_queue_benchmarks(options_, report_);
+
+    // 栈不保序, 只比较吞吐
+    bench_producer_consumer<ThreadSafeStackWaitable<long>>(
+        "ThreadSafeStackWaitable", options_, report_, [](ThreadSafeStackWaitable<long> &s_, long v_) { s_.push(v_); },
+        [](ThreadSafeStackWaitable<long> &s_, long &v_) { return s_.try_pop(v_); });
+    bench_producer_consumer<LockFreeStack<long>>(
+        "LockFreeStack", options_, report_, [](LockFreeStack<long> &s_, long v_) { s_.push(v_); },
+        [](LockFreeStack<long> &s_, long &v_) {
+            std::shared_ptr<long> p = s_.pop();
+            if (!p) return false;
+            v_ = *p;
+            return true;
+        });
+}
+
+void run_map_benchmarks(BenchOptions const &options_, BenchReport &report_) {
+    for (int readPercent : {99, 90, 50, 10}) {
+        bench_map_mix<MutexMap>(
+            "unordered_map+mutex", readPercent, options_, report_,
+            [](MutexMap &m_, long key_) {
+                std::lock_guard<std::mutex> lock(m_.mtx);
+                volatile bool               found = m_.map.find(key_) != m_.map.end();
+                (void)found;
+            },
+            [](MutexMap &m_, long key_, long value_) {
+                std::lock_guard<std::mutex> lock(m_.mtx);
+                m_.map[key_] = value_;
+            });
+        bench_map_mix<SharedMutexMap>(
+            kSharedMutexLabel, readPercent, options_, report_,
+            [](SharedMutexMap &m_, long key_) {
+                std::shared_lock<BenchSharedMutex> lock(m_.mtx);
+                volatile bool                      found = m_.map.find(key_) != m_.map.end();
+                (void)found;
+            },
+            [](SharedMutexMap &m_, long key_, long value_) {
+                std::unique_lock<BenchSharedMutex> lock(m_.mtx);
+                m_.map[key_] = value_;
+            });
+        bench_map_mix<DistributedMutexMap>(
+            "unordered_map+distributed", readPercent, options_, report_,
+            [](DistributedMutexMap &m_, long key_) {
+                std::shared_lock<DistributedSharedMutex> lock(m_.mtx);
+                volatile bool                            found = m_.map.find(key_) != m_.map.end();
+                (void)found;
+            },
+            [](DistributedMutexMap &m_, long key_, long value_) {
+                std::unique_lock<DistributedSharedMutex> lock(m_.mtx);
+                m_.map[key_] = value_;
+            });
+#if __cplusplus >= 201703L
+        bench_map_mix<ThreadSafeLookUpTable<long, long>>(
+            "ThreadSafeLookUpTable", readPercent, options_, report_,
+            [](ThreadSafeLookUpTable<long, long> &m_, long key_) {
+                volatile long value = m_.value_for(key_, -1);
+                (void)value;
+            },
+            [](ThreadSafeLookUpTable<long, long> &m_, long key_, long value_) { m_.add_or_update(key_, value_); });
+        bench_map_mix<DistributedLookUpTable>(
+            "ThreadSafeLookUpTable(distributed)", readPercent, options_, report_,
+            [](DistributedLookUpTable &m_, long key_) {
+                volatile long value = m_.value_for(key_, -1);
+                (void)value;
+            },
+            [](DistributedLookUpTable &m_, long key_, long value_) { m_.add_or_update(key_, value_); });
+#endif
+    }
+}
+
+void run_counter_benchmarks(BenchOptions const &options_, BenchReport &report_) {
+    bench_counter<AtomicCounter>("std::atomic", options_, report_,
+                                 [](AtomicCounter &c_) { c_.value.fetch_add(1, std::memory_order_relaxed); });
+    bench_counter<ShardedCounter>("ShardedCounter", options_, report_, [](ShardedCounter &c_) { c_.add(); });
+}
+
+} // namespace
+
+void run_container_benchmarks(BenchOptions const &options_, BenchReport &report_) {
+    run_queue_benchmarks(options_, report_);
+    run_map_benchmarks(options_, report_);
+    run_counter_benchmarks(options_, report_);
+}
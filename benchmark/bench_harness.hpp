@@ -0,0 +1,261 @@
+#ifndef __BENCH_HARNESS__
+#define __BENCH_HARNESS__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#define BENCH_CAN_FORK 1
+#endif
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// @brief 基准方法: 每项先预热 warmup 次, 再正式跑 runs 次, 报告中位数与 p99;
+/// 工作线程按序号绑核; 各线程池在独立子进程中测量 (单例池的空转线程不会干扰其他实现)
+struct BenchOptions {
+    int         warmup     = 1;
+    int         runs       = 10;
+    unsigned    maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t ops        = 100000; // 每项工作负载的基础操作数
+    bool        pin        = true;
+    std::string jsonPath;
+};
+
+/// @brief 调用线程绑到第 cpu_ % 核数 个核上, 不支持或失败时返回 false
+inline bool pin_to_cpu(unsigned cpu_) {
+#ifdef __linux__
+    unsigned const cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t      set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu_ % cores, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu_;
+    return false;
+#endif
+}
+
+/// @brief 单位: 微秒
+struct Summary {
+    double median = 0;
+    double p99    = 0;
+    double min    = 0;
+    double mean   = 0;
+};
+
+inline Summary summarize(std::vector<double> samples_) {
+    Summary summary;
+    if (samples_.empty()) return summary;
+    std::sort(samples_.begin(), samples_.end());
+    std::size_t const count = samples_.size();
+    summary.median          = count % 2 ? samples_[count / 2] : (samples_[count / 2 - 1] + samples_[count / 2]) / 2;
+    summary.p99             = samples_[static_cast<std::size_t>(std::ceil(0.99 * count)) - 1];
+    summary.min             = samples_.front();
+    double total            = 0;
+    for (double sample : samples_) total += sample;
+    summary.mean = total / count;
+    return summary;
+}
+
+/// @brief 预热 warmup 次后正式跑 runs 次
+/// @tparam Once double() 执行一次并返回耗时(微秒), 准备工作可放在计时之外
+template <typename Once>
+Summary measure(BenchOptions const &options_, Once once_) {
+    for (int i = 0; i < options_.warmup; ++i) once_();
+    std::vector<double> samples;
+    samples.reserve(options_.runs);
+    for (int i = 0; i < options_.runs; ++i) samples.push_back(once_());
+    return summarize(std::move(samples));
+}
+
+/// @brief threads_ 个线程各执行 body_(index), 全部就绪后同时开跑
+/// @return 从开跑到最后一个线程结束的微秒数, 不含线程创建
+template <typename Body>
+double run_parallel_us(unsigned threads_, bool pin_, Body body_) {
+    std::atomic<unsigned>    ready(0);
+    std::atomic<bool>        go(false);
+    std::vector<std::thread> threads;
+    threads.reserve(threads_);
+    for (unsigned i = 0; i < threads_; ++i) {
+        threads.emplace_back([&, i]() {
+            if (pin_) pin_to_cpu(i);
+            ready.fetch_add(1, std::memory_order_acq_rel);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            body_(i);
+        });
+    }
+    while (ready.load(std::memory_order_acquire) != threads_) std::this_thread::yield();
+    auto const start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &t : threads) t.join();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// @brief 1, 2, 4, ... 直到 max_ (max_ 总在其中)
+inline std::vector<unsigned> thread_counts(unsigned max_, unsigned min_ = 1) {
+    std::vector<unsigned> counts;
+    for (unsigned n = min_; n < max_; n *= 2) counts.push_back(n);
+    counts.push_back(std::max(min_, max_));
+    return counts;
+}
+
+struct BenchResult {
+    std::string workload;
+    std::string impl;
+    unsigned    threads = 0;
+    std::size_t ops     = 0;
+    Summary     us;
+
+    double ops_per_sec() const { return us.median > 0 ? ops / us.median * 1e6 : 0; }
+};
+
+/// @brief 收集结果: 边跑边打印表格, 最后可写 JSON
+class BenchReport {
+public:
+    explicit BenchReport(bool quiet_ = false)
+        : _quiet(quiet_) {}
+
+    void add(BenchResult result_) {
+        if (!_quiet) print(result_);
+        _results.push_back(std::move(result_));
+    }
+
+    std::vector<BenchResult> const &results() const { return _results; }
+
+    /// @brief 子进程把结果按行序列化交给父进程
+    std::string serialize() const {
+        std::ostringstream out;
+        out << std::setprecision(17);
+        for (auto const &r : _results) {
+            out << r.workload << '\t' << r.impl << '\t' << r.threads << '\t' << r.ops << '\t' << r.us.median << '\t'
+                << r.us.p99 << '\t' << r.us.min << '\t' << r.us.mean << '\n';
+        }
+        return out.str();
+    }
+
+    void merge_serialized(std::string const &text_) {
+        std::istringstream in(text_);
+        std::string        line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            BenchResult        r;
+            if (std::getline(fields, r.workload, '\t') && std::getline(fields, r.impl, '\t') &&
+                fields >> r.threads >> r.ops >> r.us.median >> r.us.p99 >> r.us.min >> r.us.mean) {
+                add(std::move(r));
+            }
+        }
+    }
+
+    bool write_json(std::string const &path_, BenchOptions const &options_) const {
+        std::ofstream out(path_);
+        if (!out) return false;
+        out << std::setprecision(6) << std::fixed;
+        out << "{\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+            << ",\n  \"warmup\": " << options_.warmup << ",\n  \"runs\": " << options_.runs
+            << ",\n  \"pinned\": " << (options_.pin ? "true" : "false") << ",\n  \"results\": [";
+        for (std::size_t i = 0; i < _results.size(); ++i) {
+            auto const &r = _results[i];
+            out << (i ? "," : "") << "\n    {\"workload\": \"" << r.workload << "\", \"impl\": \"" << r.impl
+                << "\", \"threads\": " << r.threads << ", \"ops\": " << r.ops << ", \"median_us\": " << r.us.median
+                << ", \"p99_us\": " << r.us.p99 << ", \"min_us\": " << r.us.min << ", \"mean_us\": " << r.us.mean
+                << ", \"ops_per_sec\": " << r.ops_per_sec() << "}";
+        }
+        out << "\n  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+private:
+    void print(BenchResult const &r_) {
+        if (r_.workload != _lastWorkload) {
+            _lastWorkload = r_.workload;
+            std::cout << "\n== " << r_.workload << " ==\n"
+                      << std::left << std::setw(28) << "impl" << std::right << std::setw(8) << "threads"
+                      << std::setw(14) << "median(us)" << std::setw(14) << "p99(us)" << std::setw(14) << "Mops/s"
+                      << '\n';
+        }
+        std::cout << std::left << std::setw(28) << r_.impl << std::right << std::setw(8) << r_.threads << std::fixed
+                  << std::setprecision(1) << std::setw(14) << r_.us.median << std::setw(14) << r_.us.p99
+                  << std::setprecision(3) << std::setw(14) << r_.ops_per_sec() / 1e6 << '\n';
+    }
+
+    bool                     _quiet;
+    std::string              _lastWorkload;
+    std::vector<BenchResult> _results;
+};
+
+/// @brief 在子进程中执行 fn_(BenchReport &), 结果并回 report_; 不支持 fork 时就地执行
+/// 调用时本进程不能有其他线程在运行
+template <typename Fn>
+void run_isolated(BenchReport &report_, Fn fn_) {
+#ifdef BENCH_CAN_FORK
+    std::cout.flush();
+    int fds[2];
+    if (pipe(fds) == 0) {
+        pid_t const pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            BenchReport child(true);
+            fn_(child);
+            std::string const text = child.serialize();
+            for (std::size_t written = 0; written < text.size();) {
+                ssize_t const n = write(fds[1], text.data() + written, text.size() - written);
+                if (n <= 0) break;
+                written += static_cast<std::size_t>(n);
+            }
+            close(fds[1]);
+            _exit(0); // 不析构单例线程池
+        }
+        close(fds[1]);
+        if (pid > 0) {
+            std::string text;
+            char        buffer[4096];
+            ssize_t     n;
+            while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) text.append(buffer, static_cast<std::size_t>(n));
+            close(fds[0]);
+            waitpid(pid, nullptr, 0);
+            report_.merge_serialized(text);
+            return;
+        }
+        close(fds[0]);
+    }
+#endif
+    fn_(report_);
+}
+
+/// @brief 每线程一个的小型随机数发生器 (xorshift64)
+class FastRandom {
+public:
+    explicit FastRandom(std::uint64_t seed_)
+        : _state(seed_ * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    std::uint64_t next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 7;
+        _state ^= _state << 17;
+        return _state;
+    }
+
+private:
+    std::uint64_t _state;
+};
+
+void run_pool_benchmarks(BenchOptions const &options_, BenchReport &report_);
+void run_container_benchmarks(BenchOptions const &options_, BenchReport &report_);
+void run_lock_benchmarks(BenchOptions const &options_, BenchReport &report_);
+
+#endif //__BENCH_HARNESS__
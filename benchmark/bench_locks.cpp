@@ -0,0 +1,52 @@
+/***
+ * @Description: 锁基准: 1..N 个线程争同一把锁, 临界区只改几个共享计数
+ */
+#include "bench_harness.hpp"
+#include "threadPool/spin_lock.hpp"
+#include <mutex>
+
+namespace {
+
+/// @brief 对照组: atomic/main.cpp 里最初的 SpinkLock, 每轮自旋都是一次写, 没有退避
+class TASLock {
+public:
+    void lock() {
+        while (_atoFlag.test_and_set(std::memory_order_acquire))
+            ;
+    }
+    void unlock() { _atoFlag.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag _atoFlag = ATOMIC_FLAG_INIT;
+};
+
+template <typename Lock>
+void bench_lock(char const *impl_, BenchOptions const &options_, BenchReport &report_) {
+    for (unsigned threads : thread_counts(options_.maxThreads)) {
+        std::size_t const perThread = std::max<std::size_t>(1, options_.ops / threads);
+        Summary const     us        = measure(options_, [&]() {
+            Lock          lock;
+            std::uint64_t shared[4] = {}; // 临界区写的共享数据, 与锁一起在线程间搬动
+            double const  elapsed   = run_parallel_us(threads, options_.pin, [&](unsigned) {
+                for (std::size_t i = 0; i < perThread; ++i) {
+                    std::lock_guard<Lock> guard(lock);
+                    for (auto &value : shared) ++value;
+                }
+            });
+            if (shared[0] != perThread * threads) std::cerr << impl_ << ": lost updates\n";
+            return elapsed;
+        });
+        report_.add({"lock/critical-section", impl_, threads, perThread * threads, us});
+    }
+}
+
+} // namespace
+
+void run_lock_benchmarks(BenchOptions const &options_, BenchReport &report_) {
+    bench_lock<std::mutex>("std::mutex", options_, report_);
+    bench_lock<TASLock>("TASLock(SpinkLock)", options_, report_);
+    bench_lock<TTASLock>("TTASLock", options_, report_);
+    bench_lock<TicketLock>("TicketLock", options_, report_);
+    bench_lock<MCSLock>("MCSLock", options_, report_);
+    bench_lock<SpinThenParkLock>("SpinThenParkLock", options_, report_);
+}
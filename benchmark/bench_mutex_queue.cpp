@@ -0,0 +1,12 @@
+/***
+ * @Description: 互斥锁版 ThreadSafeQueue 单独一个编译单元: 该头文件把 ThreadSafeQueue 定义为无锁队列的别名,
+ * 与 threadPool/thread_safe_queue.hpp 中的同名类不能同时包含
+ */
+#include "bench_workloads.hpp"
+#include "thread_safe_stack_queue/thread_safe_queue.hpp"
+
+void run_mutex_queue_benchmarks(BenchOptions const &options_, BenchReport &report_) {
+    bench_producer_consumer<MutexThreadSafeQueue<long>>(
+        "MutexThreadSafeQueue", options_, report_, [](MutexThreadSafeQueue<long> &q_, long v_) { q_.push(v_); },
+        [](MutexThreadSafeQueue<long> &q_, long &v_) { return q_.try_pop(v_); });
+}
@@ -0,0 +1,200 @@
+/***
+ * @Description: 线程池基准: 空任务调度开销 / fib 扇出 / 快速排序, 每个池在独立子进程中测量
+ */
+#include "bench_harness.hpp"
+#include "threadPool/future_thread_pool.hpp"
+#include "threadPool/notify_thread_pool.hpp"
+#include "threadPool/parallen_thread_pool.hpp"
+#include "threadPool/pool_future.hpp"
+#include "threadPool/simple_thread_pool.hpp"
+#include "threadPool/steal_thread_pool.hpp"
+#include "threadPool/thread_pool.hpp"
+#include "threadPool/wait_group.hpp"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// @brief 各线程池的统一提交方式: 一个 Batch 只由一个提交线程使用, submit 若干 void() 任务后 wait 等它们全部结束
+class SimplePoolBatch {
+public:
+    template <typename F>
+    void submit(F f_) {
+        SimpleThreadPool::instance().submit(std::move(f_), _group);
+    }
+    void wait() { _group.wait(); }
+
+private:
+    WaitGroup _group;
+};
+
+class StealPoolBatch {
+public:
+    template <typename F>
+    void submit(F f_) {
+        _group.add();
+        StealThreadPool::instance().post([this, f_]() mutable {
+            f_();
+            _group.done();
+        });
+    }
+    void wait() {
+        _group.wait([]() { return StealThreadPool::instance().run_pending_task(); });
+    }
+
+private:
+    WaitGroup _group;
+};
+
+/// @brief submit 返回 std::future 的池: FutureThreadPool / NotifyThreadPool / ParallenThreadPool
+template <typename Pool>
+class FuturePoolBatch {
+public:
+    template <typename F>
+    void submit(F f_) {
+        _futures.push_back(Pool::instance().submit(std::move(f_)));
+    }
+    void wait() {
+        for (auto &future : _futures) future.get();
+        _futures.clear();
+    }
+
+private:
+    std::vector<std::future<void>> _futures;
+};
+
+class ClassicPoolBatch {
+public:
+    template <typename F>
+    void submit(F f_) {
+        _futures.push_back(ThreadPool::instance().commit(std::move(f_)));
+    }
+    void wait() {
+        for (auto &future : _futures) future.get();
+        _futures.clear();
+    }
+
+private:
+    std::vector<std::future<void>> _futures;
+};
+
+long fib_serial(int n_) { return n_ < 2 ? n_ : fib_serial(n_ - 1) + fib_serial(n_ - 2); }
+
+/// @brief 把 fib(n_) 的递归树展开 depth_ 层, 叶子之和等于 fib(n_); 叶子互相独立, 任何池都不会因嵌套等待死锁
+void fib_leaves(int n_, int depth_, std::vector<int> &out_) {
+    if (depth_ == 0 || n_ < 2) {
+        out_.push_back(n_);
+        return;
+    }
+    fib_leaves(n_ - 1, depth_ - 1, out_);
+    fib_leaves(n_ - 2, depth_ - 1, out_);
+}
+
+/// @brief 嵌套版本: 子问题交给执行器, get() 等待时帮忙执行排队任务, 只适用于能帮忙的池
+long fib_nested(int n_, Executor &executor_) {
+    if (n_ < 22) return fib_serial(n_);
+    PoolFuture<long> left = pool_async([n_, &executor_]() { return fib_nested(n_ - 1, executor_); }, executor_);
+    long const       right = fib_nested(n_ - 2, executor_);
+    return left.get() + right;
+}
+
+/// @brief 在调用线程上递归划分, 直到每段不超过 grain_, 再把各段的 std::sort 作为独立任务提交
+template <typename Batch>
+void partition_sort(std::vector<int>::iterator first_, std::vector<int>::iterator last_, std::size_t grain_,
+                    Batch &batch_) {
+    while (static_cast<std::size_t>(last_ - first_) > grain_) {
+        auto const mid   = first_ + (last_ - first_) / 2;
+        int const  pivot = std::max(std::min(*first_, *mid), std::min(std::max(*first_, *mid), *(last_ - 1)));
+        auto const lower = std::partition(first_, last_, [pivot](int v_) { return v_ < pivot; });
+        auto const upper = std::partition(lower, last_, [pivot](int v_) { return !(pivot < v_); });
+        partition_sort(first_, lower, grain_, batch_);
+        first_ = upper; // 等于 pivot 的一段已就位
+    }
+    if (last_ - first_ > 1) batch_.submit([first_, last_]() { std::sort(first_, last_); });
+}
+
+template <typename Batch>
+void bench_pool(char const *name_, BenchOptions const &options_, BenchReport &report_) {
+    run_isolated(report_, [&](BenchReport &report) {
+        unsigned const workers = std::max(1u, std::thread::hardware_concurrency());
+
+        // 1..N 个线程同时提交空任务, 测的是入队、唤醒与完成通知的开销
+        for (unsigned threads : thread_counts(options_.maxThreads)) {
+            std::size_t const perThread = std::max<std::size_t>(1, options_.ops / threads);
+            Summary const     us        = measure(options_, [&]() {
+                return run_parallel_us(threads, options_.pin, [&](unsigned) {
+                    Batch batch;
+                    for (std::size_t i = 0; i < perThread; ++i) batch.submit([]() {});
+                    batch.wait();
+                });
+            });
+            report.add({"pool/empty_tasks", name_, threads, perThread * threads, us});
+        }
+
+        // fib(30) 展开成约 16 x 线程数 个独立叶子任务
+        int const        fibN  = 30;
+        int              depth = 0;
+        while ((1u << depth) < 16 * workers && depth < 12) ++depth;
+        std::vector<int> leaves;
+        fib_leaves(fibN, depth, leaves);
+        long             checksum = 0;
+        Summary const    fibUs    = measure(options_, [&]() {
+            std::atomic<long> sum(0);
+            auto const        start = std::chrono::steady_clock::now();
+            Batch             batch;
+            for (int leaf : leaves) batch.submit([&sum, leaf]() { sum += fib_serial(leaf); });
+            batch.wait();
+            double const us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            checksum        = sum.load();
+            return us;
+        });
+        if (checksum != fib_serial(fibN)) std::cerr << name_ << ": fib checksum mismatch\n";
+        report.add({"pool/fib30_fanout", name_, workers, leaves.size(), fibUs});
+
+        // 快速排序: 调用线程划分, 各段排序并行
+        std::size_t const length = options_.ops * 10;
+        std::vector<int>  input(length), datas;
+        std::mt19937      engine(2024);
+        for (auto &elem : input) elem = static_cast<int>(engine());
+        std::size_t const grain  = std::max<std::size_t>(1024, length / (8 * workers));
+        Summary const     sortUs = measure(options_, [&]() {
+            datas            = input;
+            auto const start = std::chrono::steady_clock::now();
+            Batch      batch;
+            partition_sort(datas.begin(), datas.end(), grain, batch);
+            batch.wait();
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        });
+        if (!std::is_sorted(datas.begin(), datas.end())) std::cerr << name_ << ": quicksort output not sorted\n";
+        report.add({"pool/quicksort", name_, workers, length, sortUs});
+    });
+}
+
+} // namespace
+
+void run_pool_benchmarks(BenchOptions const &options_, BenchReport &report_) {
+    bench_pool<SimplePoolBatch>("SimpleThreadPool", options_, report_);
+    bench_pool<FuturePoolBatch<FutureThreadPool>>("FutureThreadPool", options_, report_);
+    bench_pool<FuturePoolBatch<NotifyThreadPool>>("NotifyThreadPool", options_, report_);
+    bench_pool<FuturePoolBatch<ParallenThreadPool>>("ParallenThreadPool", options_, report_);
+    bench_pool<StealPoolBatch>("StealThreadPool", options_, report_);
+    bench_pool<ClassicPoolBatch>("ThreadPool", options_, report_);
+
+    // 嵌套分治只有能在等待时帮忙的执行器才不会死锁
+    run_isolated(report_, [&](BenchReport &report) {
+        Executor &executor = default_executor();
+        long      result   = 0;
+        Summary   us       = measure(options_, [&]() {
+            auto const start = std::chrono::steady_clock::now();
+            result           = fib_nested(30, executor);
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        });
+        if (result != fib_serial(30)) std::cerr << "fib_nested checksum mismatch\n";
+        report.add({"pool/fib30_nested", "StealThreadPool+PoolFuture", static_cast<unsigned>(executor.concurrency()),
+                    1, us});
+    });
+}
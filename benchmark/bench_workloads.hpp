@@ -0,0 +1,91 @@
+#ifndef __BENCH_WORKLOADS__
+#define __BENCH_WORKLOADS__
+
+#include "bench_harness.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+/// @brief 生产者/消费者: 2..N 个线程对半分 (生产者 threads/2), 共传递约 ops 个元素
+/// 消费者非阻塞轮询, 取空时让出 CPU, 各队列按同一方式比较
+/// @tparam Queue  可默认构造
+/// @tparam Push   void(Queue &, long)
+/// @tparam TryPop bool(Queue &, long &)
+template <typename Queue, typename Push, typename TryPop>
+void bench_producer_consumer(char const *impl_, BenchOptions const &options_, BenchReport &report_, Push push_,
+                             TryPop tryPop_) {
+    for (unsigned threads : thread_counts(std::max(2u, options_.maxThreads), 2)) {
+        unsigned const    producers   = threads / 2;
+        std::size_t const perProducer = std::max<std::size_t>(1, options_.ops / producers);
+        std::size_t const total       = perProducer * producers;
+        Summary const     us          = measure(options_, [&]() {
+            Queue                    queue;
+            std::atomic<std::size_t> consumed(0);
+            return run_parallel_us(threads, options_.pin, [&](unsigned index_) {
+                if (index_ < producers) {
+                    for (std::size_t i = 0; i < perProducer; ++i) push_(queue, static_cast<long>(i));
+                    return;
+                }
+                long value;
+                while (consumed.load(std::memory_order_relaxed) < total) {
+                    if (tryPop_(queue, value)) {
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        });
+        report_.add({"queue/producer_consumer", impl_, threads, total, us});
+    }
+}
+
+/// @brief 读写混合: 预先写入 kMapKeys 个键, 1..N 个线程按 readPercent_ 的比例随机读或写
+/// @tparam Map   可默认构造
+/// @tparam Read  void(Map &, long key)
+/// @tparam Write void(Map &, long key, long value)
+template <typename Map, typename Read, typename Write>
+void bench_map_mix(char const *impl_, int readPercent_, BenchOptions const &options_, BenchReport &report_, Read read_,
+                   Write write_) {
+    constexpr long    kMapKeys = 1 << 14;
+    std::string const workload = "map/read" + std::to_string(readPercent_);
+    for (unsigned threads : thread_counts(options_.maxThreads)) {
+        std::size_t const perThread = std::max<std::size_t>(1, options_.ops / threads);
+        Summary const     us        = measure(options_, [&]() {
+            Map map;
+            for (long key = 0; key < kMapKeys; ++key) write_(map, key, key);
+            return run_parallel_us(threads, options_.pin, [&](unsigned index_) {
+                FastRandom random(index_ + 1);
+                for (std::size_t i = 0; i < perThread; ++i) {
+                    std::uint64_t const r   = random.next();
+                    long const          key = static_cast<long>(r % kMapKeys);
+                    if (static_cast<int>((r >> 32) % 100) < readPercent_) {
+                        read_(map, key);
+                    } else {
+                        write_(map, key, static_cast<long>(i));
+                    }
+                }
+            });
+        });
+        report_.add({workload, impl_, threads, perThread * threads, us});
+    }
+}
+
+/// @brief 1..N 个线程只做计数, 衡量统计计数器本身在热路径上的开销
+/// @tparam Counter 可默认构造
+/// @tparam Add     void(Counter &)
+template <typename Counter, typename Add>
+void bench_counter(char const *impl_, BenchOptions const &options_, BenchReport &report_, Add add_) {
+    for (unsigned threads : thread_counts(options_.maxThreads)) {
+        std::size_t const perThread = std::max<std::size_t>(1, options_.ops / threads);
+        Summary const     us        = measure(options_, [&]() {
+            Counter counter;
+            return run_parallel_us(threads, options_.pin, [&](unsigned) {
+                for (std::size_t i = 0; i < perThread; ++i) add_(counter);
+            });
+        });
+        report_.add({"counter/increment", impl_, threads, perThread * threads, us});
+    }
+}
+
+#endif //__BENCH_WORKLOADS__
@@ -0,0 +1,278 @@
+/***
+ * @Description: 基准测试
+ *   algo:        并行算法 串行 / 每次新建线程 / 共享线程池, 输入规模 10^3 ~ 10^maxExponent
+ *   concurrency: 各线程池、容器与锁在 1..N 线程下的吞吐 (bench_pools.cpp / bench_containers.cpp / bench_locks.cpp)
+ * usage: benchmark [maxExponent = 8] [--suite=all|algo|concurrency] [--runs=10] [--warmup=1]
+ *                  [--threads=N] [--ops=100000] [--json=path] [--no-pin]
+ */
+#include "bench_harness.hpp"
+#include "spdlog/spdlog.h"
+#include "stl/parallel_find.cpp"
+#include "stl/parallel_for_each.cpp"
+#include "stl/parallel_sort.cpp"
+#include "stl/partial_sum.cpp"
+#include "stl/transform_reduce.cpp"
+#include "threadPool/executor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/// @brief 重复执行取中位数, 小规模多跑几次以平滑计时误差
+/// @return 单次耗时(微秒)
+template <typename Func>
+double median_us(std::size_t length_, Func f_) {
+    std::size_t const   repeat = std::max<std::size_t>(3, std::min<std::size_t>(1000, 10000000 / length_));
+    std::vector<double> samples;
+    samples.reserve(repeat);
+    for (std::size_t i = 0; i < repeat; ++i) {
+        auto const start = Clock::now();
+        f_();
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+struct BenchRow {
+    std::size_t length;
+    double      serialUs;
+    double      threadUs;
+    double      poolUs;
+};
+
+void print_rows(std::string const &name_, std::vector<BenchRow> const &rows_) {
+    std::cout << "\n== " << name_ << " ==\n";
+    std::cout << std::setw(12) << "n" << std::setw(14) << "serial(us)" << std::setw(14) << "thread(us)"
+              << std::setw(14) << "pool(us)" << std::setw(10) << "speedup" << '\n';
+    std::size_t crossover = 0;
+    for (auto const &row : rows_) {
+        std::cout << std::setw(12) << row.length << std::fixed << std::setprecision(1) << std::setw(14)
+                  << row.serialUs << std::setw(14) << row.threadUs << std::setw(14) << row.poolUs
+                  << std::setprecision(2) << std::setw(10) << row.serialUs / row.poolUs << '\n';
+        if (!crossover && row.poolUs < row.serialUs) crossover = row.length;
+    }
+    if (crossover)
+        std::cout << "pool path overtakes serial at n = " << crossover << '\n';
+    else
+        std::cout << "pool path never overtakes serial in this range\n";
+}
+
+/// @brief 三种实现各跑一遍, serial_/parallel_ 接收待处理的数据
+template <typename Serial, typename Parallel>
+std::vector<BenchRow> run_bench(int maxExponent_, Serial serial_, Parallel parallel_) {
+    std::vector<BenchRow> rows;
+    for (std::size_t length = 1000, e = 3; e <= static_cast<std::size_t>(maxExponent_); length *= 10, ++e) {
+        std::vector<uint32_t> datas(length);
+        std::iota(datas.begin(), datas.end(), 0u);
+
+        BenchRow row{length, 0, 0, 0};
+        row.serialUs = median_us(length, [&]() { serial_(datas); });
+        row.threadUs = median_us(length, [&]() { parallel_(datas, ThreadExecutor::instance()); });
+        row.poolUs   = median_us(length, [&]() { parallel_(datas, default_executor()); });
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+/// @brief 求和吞吐量 (GB/s): std::accumulate 对比单线程 SIMD 与线程池上的 parallel_reduce
+template <typename T>
+void bench_reduce_bandwidth(std::string const &name_, int maxExponent_) {
+    std::cout << "\n== reduce<" << name_ << "> GB/s ==\n";
+    std::cout << std::setw(12) << "n" << std::setw(14) << "accumulate" << std::setw(14) << "simd x1"
+              << std::setw(14) << "pool" << '\n';
+    Partitioner const singleWorker(PartitionKind::Auto, 0, 1);
+    for (std::size_t length = 1000, e = 3; e <= static_cast<std::size_t>(maxExponent_); length *= 10, ++e) {
+        std::vector<T> datas(length);
+        for (std::size_t i = 0; i < length; ++i)
+            datas[i] = static_cast<T>(i % 7);
+        volatile T sink;
+        double const accumulateUs =
+            median_us(length, [&]() { sink = std::accumulate(datas.begin(), datas.end(), T()); });
+        double const simdUs       = median_us(
+            length, [&]() { sink = parallel_reduce(datas.begin(), datas.end(), T(), std::plus<>(), singleWorker); });
+        double const poolUs = median_us(length, [&]() { sink = parallel_reduce(datas.begin(), datas.end(), T()); });
+        (void)sink;
+
+        // 字节数 / 微秒 / 1000 = GB/s
+        double const kBytes = static_cast<double>(length * sizeof(T)) / 1000.0;
+        std::cout << std::setw(12) << length << std::fixed << std::setprecision(2) << std::setw(14)
+                  << kBytes / accumulateUs << std::setw(14) << kBytes / simdUs << std::setw(14) << kBytes / poolUs
+                  << '\n';
+    }
+}
+
+/// @brief 随机 int 排序: 标准库版本对比并行版本, 每次排序前重新拷贝输入(不计时)
+/// @tparam Serial   void(std::vector<int> &)
+/// @tparam Parallel void(std::vector<int> &, Executor &)
+template <typename Serial, typename Parallel>
+void bench_sort(std::string const &name_, int maxExponent_, Serial serial_, Parallel parallel_) {
+    std::cout << "\n== " << name_ << " ==\n";
+    std::cout << std::setw(12) << "n" << std::setw(14) << "std(us)" << std::setw(14) << "thread(us)"
+              << std::setw(14) << "pool(us)" << std::setw(10) << "speedup" << '\n';
+    std::mt19937 engine(2024);
+    for (std::size_t length = 1000, e = 3; e <= static_cast<std::size_t>(maxExponent_); length *= 10, ++e) {
+        std::vector<int> input(length), datas;
+        for (auto &elem : input)
+            elem = static_cast<int>(engine());
+
+        std::size_t const repeat = std::max<std::size_t>(3, std::min<std::size_t>(100, 10000000 / length));
+        auto const        timed  = [&](std::function<void()> const &sort_) {
+            std::vector<double> samples;
+            for (std::size_t i = 0; i < repeat; ++i) {
+                datas            = input;
+                auto const start = Clock::now();
+                sort_();
+                samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            }
+            std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            return samples[samples.size() / 2];
+        };
+        double const stdUs    = timed([&]() { serial_(datas); });
+        double const threadUs = timed([&]() { parallel_(datas, ThreadExecutor::instance()); });
+        double const poolUs   = timed([&]() { parallel_(datas, default_executor()); });
+
+        std::cout << std::setw(12) << length << std::fixed << std::setprecision(1) << std::setw(14) << stdUs
+                  << std::setw(14) << threadUs << std::setw(14) << poolUs << std::setprecision(2) << std::setw(10)
+                  << stdUs / poolUs << '\n';
+    }
+}
+
+/// @brief 64 位时间戳排序: std::sort / parallel_sort (快速排序) / parallel_radix_sort
+/// 时间戳取一天内的纳秒, 高位基本相同, 基数排序会跳过这些趟
+void bench_radix(int maxExponent_) {
+    std::cout << "\n== sort<int64 timestamp> ==\n";
+    std::cout << std::setw(12) << "n" << std::setw(14) << "std(us)" << std::setw(14) << "quick(us)"
+              << std::setw(14) << "radix(us)" << std::setw(10) << "speedup" << '\n';
+    std::mt19937_64     engine(2024);
+    int64_t const       epochNs = 1700000000LL * 1000000000LL;
+    std::vector<double> samples;
+    for (std::size_t length = 1000, e = 3; e <= static_cast<std::size_t>(maxExponent_); length *= 10, ++e) {
+        std::vector<int64_t> input(length), datas;
+        for (auto &elem : input)
+            elem = epochNs + static_cast<int64_t>(engine() % 86400000000000ULL);
+
+        std::size_t const repeat = std::max<std::size_t>(3, std::min<std::size_t>(100, 10000000 / length));
+        auto const        timed  = [&](std::function<void()> const &sort_) {
+            samples.clear();
+            for (std::size_t i = 0; i < repeat; ++i) {
+                datas            = input;
+                auto const start = Clock::now();
+                sort_();
+                samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            }
+            std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            return samples[samples.size() / 2];
+        };
+        double const stdUs   = timed([&]() { std::sort(datas.begin(), datas.end()); });
+        double const quickUs = timed([&]() { parallel_sort(datas.begin(), datas.end()); });
+        double const radixUs = timed([&]() { parallel_radix_sort(datas.begin(), datas.end()); });
+
+        std::cout << std::setw(12) << length << std::fixed << std::setprecision(1) << std::setw(14) << stdUs
+                  << std::setw(14) << quickUs << std::setw(14) << radixUs << std::setprecision(2) << std::setw(10)
+                  << stdUs / radixUs << '\n';
+    }
+}
+
+void run_algorithm_benchmarks(int maxExponent_) {
+    auto const mix = [](uint32_t &x) { x = x * 2654435761u + 1; };
+
+    print_rows("for_each", run_bench(
+                               maxExponent_, [&](std::vector<uint32_t> &d) { std::for_each(d.begin(), d.end(), mix); },
+                               [&](std::vector<uint32_t> &d, Executor &executor) {
+                                   parallel_for_each(d.begin(), d.end(), mix, Partitioner(), executor);
+                               }));
+
+    // 查找不存在的值, 保证完整扫描
+    print_rows("find", run_bench(
+                           maxExponent_,
+                           [](std::vector<uint32_t> &d) {
+                               volatile bool found = std::find(d.begin(), d.end(), 0xFFFFFFFFu) != d.end();
+                               (void)found;
+                           },
+                           [](std::vector<uint32_t> &d, Executor &executor) {
+                               volatile bool found =
+                                   parallel_find(d.begin(), d.end(), 0xFFFFFFFFu, Partitioner(), executor) != d.end();
+                               (void)found;
+                           }));
+
+    print_rows("partial_sum", run_bench(
+                                  maxExponent_,
+                                  [](std::vector<uint32_t> &d) { std::partial_sum(d.begin(), d.end(), d.begin()); },
+                                  [](std::vector<uint32_t> &d, Executor &executor) {
+                                      paraller_partial_sum(d.begin(), d.end(), Partitioner(), executor);
+                                  }));
+
+    bench_reduce_bandwidth<float>("float", maxExponent_);
+    bench_reduce_bandwidth<int64_t>("int64", maxExponent_);
+    bench_sort(
+        "sort<int>", maxExponent_, [](std::vector<int> &d) { std::sort(d.begin(), d.end()); },
+        [](std::vector<int> &d, Executor &executor) { parallel_sort(d.begin(), d.end(), std::less<>(), executor); });
+    std::vector<int> scratch;
+    bench_sort(
+        "stable_sort<int>", maxExponent_, [](std::vector<int> &d) { std::stable_sort(d.begin(), d.end()); },
+        [&scratch](std::vector<int> &d, Executor &executor) {
+            parallel_stable_sort(d.begin(), d.end(), scratch, std::less<>(), executor);
+        });
+    bench_radix(maxExponent_);
+}
+
+int main(int argc, char **argv) {
+    int          maxExponent = 8;
+    std::string  suite       = "all";
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string const arg   = argv[i];
+        auto const        value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (arg.compare(0, 8, "--suite=") == 0) {
+            suite = value();
+        } else if (arg.compare(0, 7, "--runs=") == 0) {
+            options.runs = std::max(1, std::atoi(value().c_str()));
+        } else if (arg.compare(0, 9, "--warmup=") == 0) {
+            options.warmup = std::max(0, std::atoi(value().c_str()));
+        } else if (arg.compare(0, 10, "--threads=") == 0) {
+            options.maxThreads = static_cast<unsigned>(std::max(1, std::atoi(value().c_str())));
+        } else if (arg.compare(0, 6, "--ops=") == 0) {
+            options.ops = static_cast<std::size_t>(std::max(1L, std::atol(value().c_str())));
+        } else if (arg.compare(0, 7, "--json=") == 0) {
+            options.jsonPath = value();
+        } else if (arg == "--no-pin") {
+            options.pin = false;
+        } else if (!arg.empty() && arg[0] != '-') {
+            maxExponent = std::atoi(arg.c_str());
+        } else {
+            std::cerr << "unknown option: " << arg << '\n';
+            return 1;
+        }
+    }
+
+    spdlog::set_level(spdlog::level::warn);
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << '\n';
+
+    // 线程池基准在子进程中运行, 需在本进程创建任何线程池之前 fork, 所以先于算法基准
+    BenchReport report;
+    if (suite == "all" || suite == "concurrency") {
+        run_pool_benchmarks(options, report);
+        run_container_benchmarks(options, report);
+        run_lock_benchmarks(options, report);
+    }
+    if (suite == "all" || suite == "algo") run_algorithm_benchmarks(maxExponent);
+
+    if (!options.jsonPath.empty()) {
+        if (!report.write_json(options.jsonPath, options)) {
+            std::cerr << "failed to write " << options.jsonPath << '\n';
+            return 1;
+        }
+        std::cout << "\nresults written to " << options.jsonPath << '\n';
+    }
+    return 0;
+}
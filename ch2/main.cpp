@@ -5,6 +5,7 @@
  * @LastEditors: Ye Guosheng
  * @Description: 线程管理
  */
+#include "stl/transform_reduce.cpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -138,64 +139,22 @@ void printTime()
     std::cout << "now_time:" << buffer << '.' << std::setfill('0') << std::setw(3) << ms.count() << std::endl;
 }
 
-/// @brief 可调用对象,累加first-end
-/// @tparam Iterator
-/// @tparam T
-template <typename Iterator, typename T>
-struct accumulate_block
-{
-    void operator()(Iterator first, Iterator end, T &result)
-    {
-        result = std::accumulate(first, end, result);
-    }
-};
-
 /// @brief 并行累计计算
-/// 1. 计算容器内的元素个数，并确定实际使用的线程数
-/// 2. 根据线程数和元素个数，计算每个线程处理的元素块大小
-/// 3. 利用容器存储每个线程的累加结果
-/// 4. 遍历并创建线程，每个线程处理一个元素块，结果存于容器
-/// 5. 处理剩余的最后一个元素块
-/// 6. 等待所有线程处理完成，累加所有结果，返回最终结果
+/// 由划分器确定块数和实际使用的线程数, 各块的累加结果存放在按缓存行隔开的槽位中,
+/// 全部完成后按块号顺序与 init 相加; 元素为连续存放的算术类型且与 init 同类型时块内走 SIMD
 /// @tparam Iterator     迭代器类型
 /// @tparam T            元素类型
 /// @param first         开始位置
 /// @param last          结束位置
 /// @param init          初始值
+/// @param partitioner   划分策略
+/// @param executor      执行器, 默认共享的StealThreadPool
 /// @return T            返回累加值
 template <typename Iterator, typename T>
-T parallel_accumulate(Iterator first, Iterator last, T init)
+T parallel_accumulate(Iterator first, Iterator last, T init, Partitioner partitioner = Partitioner(),
+                      Executor &executor = default_executor())
 {
-    unsigned long const length = std::distance(first, last); // 计算元素数量
-    if (!length)                                             // 一个数
-        return init;
-    unsigned long const min_per_thread = 1000;                                                             // 每个线程的最小处理数数量
-    unsigned long const max_threads = (length + min_per_thread - 1) / min_per_thread;                      // 最大线程数,每个线程至少处理min_per_thread
-    unsigned long const hardware_threads = std::thread::hardware_concurrency();                            // 硬件支持线程数
-    unsigned long const num_threads = std::min(hardware_threads != 0 ? hardware_threads : 2, max_threads); // 使用合适的线程数
-    unsigned long const block_size = length / num_threads;                                                 // 计算独立线程内处理的块大小
-
-    std::vector<T> results(num_threads);               // 存放每个线程的计算题结果
-    std::vector<std::thread> threads(num_threads - 1); // 线程容器
-    Iterator block_start = first;                      // 块起始位
-
-    for (size_t i = 0; i < (num_threads - 1); ++i)
-    {
-        Iterator block_end = block_start;
-        std::advance(block_end, block_size);                                                                     // block_end 前进到block_size处
-        threads[i] = std::thread(accumulate_block<Iterator, T>(), block_start, block_end, std::ref(results[i])); // create thread[i]
-        block_start = block_end;                                                                                 // updata strat
-    }
-    accumulate_block<Iterator, T>()(block_start, last, results[num_threads - 1]); // 处理剩余元素
-
-    // for (auto &entry : threads)
-    // {
-    //     //std::cout<<std::this_thread::get_id()<<std::endl;
-    //     // entry.join();
-    // }
-
-    std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
-    return std::accumulate(results.begin(), results.end(), init);
+    return parallel_reduce(first, last, init, std::plus<T>(), partitioner, executor);
 }
 
 void test_parallel()
@@ -0,0 +1,345 @@
+#ifndef __CIRCULAR_QUEUE__
+#define __CIRCULAR_QUEUE__
+
+#include "threadPool/profiled_mutex.hpp"
+#include "threadPool/queue_latency.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/// @brief 有界环形队列, 互斥锁版
+/// 留一个空位区分空和满, 实际分配 Cap + 1 个位置
+/// @tparam T
+/// @tparam Cap 容量
+/// @tparam Mutex 互斥量类型, 换成 ProfiledMutex<> 可统计锁竞争
+template <typename T, size_t Cap, typename Mutex = std::mutex>
+class CircularQueue : private std::allocator<T> {
+    using AllocTraits = std::allocator_traits<std::allocator<T>>;
+
+public:
+    CircularQueue()
+        : _max_size(Cap + 1)
+        , _data(std::allocator<T>::allocate(_max_size))
+        , _head(0)
+        , _tail(0) {
+        name_lock(_mtx, "CircularQueue");
+    }
+
+    CircularQueue(const CircularQueue &)                     = delete;
+    CircularQueue &operator=(const CircularQueue &) volatile = delete;
+    CircularQueue &operator=(const CircularQueue &)          = delete;
+
+    ~CircularQueue() {
+        std::lock_guard<Mutex> lock(_mtx);
+        while (_head != _tail) {
+            AllocTraits::destroy(*this, _data + _head);
+            _head = (_head + 1) % _max_size;
+        }
+        std::allocator<T>::deallocate(_data, _max_size);
+    }
+
+    /// @brief 插入元素
+    /// @tparam ...Args
+    /// @param ...args
+    /// @return 队列已满返回 false
+    template <typename... Args>
+    bool emplace(Args &&...args) {
+        std::lock_guard<Mutex> lock(_mtx);
+
+        if ((_tail + 1) % _max_size == _head) {
+            return false;
+        }
+
+        AllocTraits::construct(*this, _data + _tail, std::forward<Args>(args)...);
+#ifdef QUEUE_LATENCY_TRACKING
+        _stamps[_tail] = latency::now_ns();
+#endif
+        _tail = (_tail + 1) % _max_size;
+        return true;
+    }
+
+    bool push(const T &value) { return emplace(value); }
+    bool push(T &&value) { return emplace(std::move(value)); }
+
+    /// @brief 取出队首元素
+    /// @param value
+    /// @return 队列为空返回 false
+    bool pop(T &value) {
+        std::lock_guard<Mutex> lock(_mtx);
+        if (_head == _tail) {
+            return false;
+        }
+        value = std::move(_data[_head]);
+        AllocTraits::destroy(*this, _data + _head);
+#ifdef QUEUE_LATENCY_TRACKING
+        _latency.record_since(_stamps[_head]);
+#endif
+        _head = (_head + 1) % _max_size;
+        return true;
+    }
+
+#ifdef QUEUE_LATENCY_TRACKING
+    /// @brief 元素从 push 到被取出的等待时间分布 (纳秒)
+    latency::Snapshot latency_snapshot() const { return _latency.snapshot(); }
+    void              reset_latency() { _latency.reset(); }
+#endif
+
+private:
+    size_t _max_size;
+    T     *_data;
+    Mutex  _mtx;
+    size_t _head = 0;
+    size_t _tail = 0;
+#ifdef QUEUE_LATENCY_TRACKING
+    std::uint64_t      _stamps[Cap + 1];
+    latency::Histogram _latency;
+#endif
+};
+
+// std::atomic<T>::compare_exchange_weak(T &expected, T desired)
+// std::atomic<T>::compare_exchange_strong(T &expected, T desired)
+// 比较调用者与expected的值, 如果相等,赋值为desired,返回true;
+// 否则,expected的值变为调用者的值,并返回false
+//
+// 它比较原子变量的当前值和一个期望值,当两值相等时,存储所提供的值;
+// 当两值不等, 期望值就会被更新为原子变量中的值。
+
+/// @brief 原子变量充当自旋锁的环形队列
+/// @tparam T
+/// @tparam Cap
+template <typename T, size_t Cap>
+class CircularQueueSeq : private std::allocator<T> {
+    using AllocTraits = std::allocator_traits<std::allocator<T>>;
+
+public:
+    CircularQueueSeq()
+        : _maxSize(Cap + 1)
+        , _data(std::allocator<T>::allocate(_maxSize))
+        , _atomic_using(false)
+        , _head(0)
+        , _tail(0) {}
+    CircularQueueSeq(const CircularQueueSeq &)                     = delete;
+    CircularQueueSeq &operator=(const CircularQueueSeq &) volatile = delete;
+    CircularQueueSeq &operator=(const CircularQueueSeq &)          = delete;
+    ~CircularQueueSeq() {
+
+        // lock
+        bool use_expected = false;
+        bool use_desired  = true;
+
+        do {
+            use_expected = false;
+            use_desired  = true;
+        } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+
+        while (_head != _tail) {
+            AllocTraits::destroy(*this, _data + _head);
+            _head = (_head + 1) % _maxSize;
+        }
+        std::allocator<T>::deallocate(_data, _maxSize);
+
+        // unlock
+        do {
+            use_expected = true;
+            use_desired  = false;
+        } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+    }
+
+    /// @brief push elem
+    /// @tparam ...Args
+    /// @param ...args
+    /// @return
+    template <typename... Args>
+    bool emplace(Args &&...args) {
+        bool use_expected = false;
+        bool use_desired  = true;
+
+        // 多个线程调用emplace,只有一个能进来, 其他的卡在while里
+        // _atomic_using = false == use_ecpectec,
+        //  then _aotmic_using = desired = ture; return true;
+        // CAS 失败会把 use_expected 改成当前值, 每轮都要重置
+        do {
+            use_expected = false;
+            use_desired  = true;
+        } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+
+        // full
+        if ((_tail + 1) % _maxSize == _head) {
+            do {
+                use_expected = true;
+                use_desired  = false;
+            } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+            return false;
+        }
+
+        AllocTraits::construct(*this, _data + _tail, std::forward<Args>(args)...);
+#ifdef QUEUE_LATENCY_TRACKING
+        _stamps[_tail] = latency::now_ns();
+#endif
+        _tail = (_tail + 1) % _maxSize;
+        do {
+            use_expected = true;
+            use_desired  = false;
+        } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+
+        return true;
+    }
+
+    /// @brief pop elem
+    /// @param value
+    /// @return
+    bool pop(T &value) {
+        bool use_expected = false;
+        bool use_desired  = true;
+
+        // lock
+        do {
+            use_expected = false;
+            use_desired  = true;
+        } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+
+        if (_head == _tail) {
+            // unlock
+            do {
+                use_expected = true;
+                use_desired  = false;
+            } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+            return false;
+        }
+
+        value = std::move(_data[_head]);
+        AllocTraits::destroy(*this, _data + _head);
+#ifdef QUEUE_LATENCY_TRACKING
+        _latency.record_since(_stamps[_head]);
+#endif
+        _head = (_head + 1) % _maxSize;
+
+        // unlock
+        do {
+            use_expected = true;
+            use_desired  = false;
+        } while (!_atomic_using.compare_exchange_strong(use_expected, use_desired));
+        return true;
+    }
+
+    bool push(const T &value) { return emplace(value); }
+    bool push(T &&value) { return emplace(std::move(value)); }
+
+#ifdef QUEUE_LATENCY_TRACKING
+    /// @brief 元素从 push 到被取出的等待时间分布 (纳秒)
+    latency::Snapshot latency_snapshot() const { return _latency.snapshot(); }
+    void              reset_latency() { _latency.reset(); }
+#endif
+
+private:
+    size_t            _maxSize;
+    T                *_data;
+    std::atomic<bool> _atomic_using;
+    size_t            _head = 0;
+    size_t            _tail = 0;
+#ifdef QUEUE_LATENCY_TRACKING
+    std::uint64_t      _stamps[Cap + 1];
+    latency::Histogram _latency;
+#endif
+};
+
+/// @brief 无锁环形队列: push 先 CAS 占位再写数据, 写完后按顺序推进 _tailUpdata, pop 只读已写完的位置
+/// 元素按赋值写入未构造的内存, 只适用于平凡类型
+/// @tparam T
+/// @tparam Cap
+template <typename T, size_t Cap>
+class CircularQueueLightweight : private std::allocator<T> {
+    using AllocTraits = std::allocator_traits<std::allocator<T>>;
+
+public:
+    CircularQueueLightweight()
+        : _maxSize(Cap + 1)
+        , _data(std::allocator<T>::allocate(_maxSize))
+        , _head(0)
+        , _tail(0)
+        , _tailUpdata(0) {}
+    CircularQueueLightweight(const CircularQueueLightweight &)                     = delete;
+    CircularQueueLightweight &operator=(const CircularQueueLightweight &) volatile = delete;
+    CircularQueueLightweight &operator=(const CircularQueueLightweight &)          = delete;
+
+    ~CircularQueueLightweight() {
+        size_t       head = _head.load(std::memory_order_relaxed);
+        size_t const tail = _tail.load(std::memory_order_relaxed);
+        while (head != tail) {
+            AllocTraits::destroy(*this, _data + head);
+            head = (head + 1) % _maxSize;
+        }
+        std::allocator<T>::deallocate(_data, _maxSize);
+    }
+
+    bool pop(T &value) {
+        size_t h;
+#ifdef QUEUE_LATENCY_TRACKING
+        std::uint64_t stamp;
+#endif
+        do {
+            h = _head.load(std::memory_order_relaxed);
+            if (h == _tail.load(std::memory_order_acquire))
+                return false; // empty
+
+            if (h == _tailUpdata.load(std::memory_order_acquire))
+                return false; // data not update down
+
+            value = _data[h];
+#ifdef QUEUE_LATENCY_TRACKING
+            stamp = _stamps[h];
+#endif
+        } while (!_head.compare_exchange_strong(h, (h + 1) % _maxSize, std::memory_order_release,
+                                                std::memory_order_relaxed));
+#ifdef QUEUE_LATENCY_TRACKING
+        _latency.record_since(stamp);
+#endif
+        return true;
+    }
+
+    bool push(T &value) {
+        size_t t;
+        do {
+            t = _tail.load(std::memory_order_relaxed);
+            if ((t + 1) % _maxSize == _head.load(std::memory_order_acquire))
+                return false;
+            // _data[t] = value;
+        } while (!_tail.compare_exchange_strong(t, (t + 1) % _maxSize, std::memory_order_release,
+                                                std::memory_order_relaxed));
+
+        _data[t] = value;
+#ifdef QUEUE_LATENCY_TRACKING
+        _stamps[t] = latency::now_ns();
+#endif
+
+        // attention
+        size_t taildown;
+        do {
+            taildown = t;
+        } while (!_tailUpdata.compare_exchange_strong(taildown, (taildown + 1) % _maxSize, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+        return true;
+    }
+
+#ifdef QUEUE_LATENCY_TRACKING
+    /// @brief 元素从 push 到被取出的等待时间分布 (纳秒)
+    latency::Snapshot latency_snapshot() const { return _latency.snapshot(); }
+    void              reset_latency() { _latency.reset(); }
+#endif
+
+private:
+    size_t              _maxSize;
+    T                  *_data;
+    std::atomic<size_t> _head;
+    std::atomic<size_t> _tail;
+    std::atomic<size_t> _tailUpdata;
+#ifdef QUEUE_LATENCY_TRACKING
+    std::uint64_t      _stamps[Cap + 1];
+    latency::Histogram _latency;
+#endif
+};
+
+#endif //__CIRCULAR_QUEUE__
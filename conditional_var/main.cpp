@@ -16,6 +16,7 @@
 #include <thread>
 
 #include "spdlog/spdlog.h"
+#include "thread_safe_stack_queue/thread_safe_queue.hpp"
 
 class AA {
     std::mutex                                       _m_mtx;
@@ -124,75 +125,7 @@ void test_Add() {
     t2.join();
 }
 
-template <class T> class ThreadSafeQueue {
-public:
-    ThreadSafeQueue() {}
-
-    /// @brief const 引用, 在未实现移动构造时可以使用拷贝构造，否则无法使用
-    /// @param rhs
-    ThreadSafeQueue(ThreadSafeQueue const &rhs) {
-
-        std::lock_guard<std::mutex> lock(rhs._mtx);
-        _data_queue = rhs._data_queue;
-    }
-
-    void push(T new_value) {
-
-        std::lock_guard<std::mutex> lock(_mtx);
-        _data_queue.push(new_value);
-        _data_cond.notify_one(); // 唤醒可能等等的其他线程
-    }
-
-    /// @brief 队列为空则等待，不为空则pop()
-    /// @param value
-    void wait_and_pop(T &value) {
-
-        // 注意是unique_lock 而不是lock_guard
-        std::unique_lock<std::mutex> un_lock(_mtx);
-        _data_cond.wait(un_lock, [this]() { return !_data_queue.empty(); });
-        value = _data_queue.front(); // 一次copy消耗
-        _data_queue.pop();
-    }
-
-    /// @brief
-    /// @return std::shared_ptr<T> res
-    std::shared_ptr<T> wait_and_pop() {
-
-        std::unique_lock<std::mutex> un_lock(_mtx);
-        _data_cond.wait(un_lock, [this]() { return !_data_queue.empty(); });
-        std::shared_ptr<T> sp_res(std::make_shared<T>(_data_queue.front()));
-        _data_queue.pop();
-        return sp_res;
-    }
-
-    bool try_pop(T &value) {
-
-        std::lock_guard<std::mutex> lock(_mtx);
-        if (_data_queue.empty()) return false;
-        value = _data_queue.front();
-        _data_queue.pop();
-        return true;
-    }
-
-    std::shared_ptr<T> try_pop() {
-
-        std::lock_guard<std::mutex> lock(_mtx);
-        if (_data_queue.empty()) return std::shared_ptr<T>();
-        std::shared_ptr<T> res(std::make_shared<T>(_data_queue.front()));
-        _data_queue.pop();
-        return res;
-    }
-
-    bool empty() const {
-        std::lock_guard<std::mutex> lock(_mtx);
-        return _data_queue.empty();
-    }
-
-private:
-    mutable std::mutex      _mtx;
-    std::queue<T>           _data_queue;
-    std::condition_variable _data_cond;
-};
+// ThreadSafeQueue 见 thread_safe_stack_queue/thread_safe_queue.hpp: 无锁实现, 接口同原先的互斥锁版本
 
 void test_ThreadSafeQueue() {
     ThreadSafeQueue<int> ts_queue;
@@ -8,10 +8,14 @@
  */
 
 #include "spdlog/spdlog.h"
+#include "threadPool/concurrent_cache.hpp"
+#include "threadPool/pool_future.hpp"
 #include <future>
 #include <iostream>
 #include <map>
+#include <string>
 #include <thread>
+#include <vector>
 
 using payload_type = std::string;
 class Connection {
@@ -81,6 +85,25 @@ void test_fetchDataFromDB() {
     spdlog::info("data from DB: {}", database_data);
 }
 
+/// @brief fetchDataFromDB 前加一层缓存: 命中直接返回, 未命中才查库, 结果保留 1 秒
+payload_type fetchDataFromDBCached(payload_type query) {
+    static ConcurrentCache<payload_type, payload_type> cache(1024, std::chrono::seconds(1));
+    return cache.get_or_load(query, fetchDataFromDB);
+}
+
+/// @brief 第一轮查库, 第二轮全部命中; 同一轮里相同的查询同时未命中时各查一次
+void test_fetchDataFromDB_cached() {
+    for (int round = 0; round < 2; ++round) {
+        std::vector<std::future<payload_type>> results;
+        for (int i = 0; i < 4; ++i) {
+            results.push_back(std::async(std::launch::async, fetchDataFromDBCached, "Data" + std::to_string(i)));
+        }
+        for (auto &result : results) {
+            spdlog::info("round {} data: {}", round, result.get());
+        }
+    }
+}
+
 /*
 std::packaged_task是一个可调用目标，它包装了一个任务，该任务可以在另一个线程上运行。
 它可以捕获任务的返回值或异常，并将其存储在std::future对象中，以便以后使用
@@ -200,13 +223,31 @@ void use_shared_future() {
     t3.join();
 }
 
+/// @brief 线程池上的 future: 每一级在上一级完成后才投递到池中, 不会有线程阻塞在 get() 上
+void use_pool_future() {
+    std::vector<PoolFuture<int>> queries;
+    for (int i = 0; i < 4; ++i) {
+        queries.push_back(pool_async([i]() { return i * i; }).then([](int value) { return value + 1; }));
+    }
+    when_all(std::move(queries))
+        .then([](std::vector<int> values) {
+            for (int value : values) {
+                std::cout << value << " ";
+            }
+            std::cout << std::endl;
+        })
+        .get();
+}
+
 int main() {
     // test_connection();
     // std::cout << "main thread id: " << std::this_thread::get_id() <<
     // std::endl;
     // test_fetchDataFromDB();
+    // test_fetchDataFromDB_cached();
     // use_package();
     // use_promise();
     // use_promise_excetion();
     use_shared_future();
+    // use_pool_future();
 }
\ No newline at end of file
@@ -8,10 +8,14 @@
 #ifndef LOCKFREEQUEUE_HPP
 #define LOCKFREEQUEUE_HPP
 
-#include "spdlog.h"
+#include "threadPool/cache_padded.hpp"
+#include "threadPool/hazard_pointer.hpp"
+#include "threadPool/node_pool.hpp"
+#include "threadPool/queue_latency.hpp"
+#include "threadPool/sharded_counter.hpp"
 #include <atomic>
 #include <memory>
-#include <set>
+#include <new>
 
 /// @brief 单生产、消费者的无锁队列实现
 /// @tparam DataType
@@ -74,179 +78,88 @@ public:
     }
 };
 
-/// @brief
+/// @brief 多生产者多消费者无锁队列 (Michael-Scott)
+/// 头结点是哑结点, push 只 CAS 尾部, pop 只 CAS 头部, 尾指针落后时任何线程都可帮忙推进.
+/// 摘下的结点经危险指针确认无人访问后放回 NodePool, 稳定运行时入队不再向堆申请结点.
 /// @tparam DataType
 template <typename DataType>
 class LockFreeQueue {
 private:
-    struct node;
-
-    /// @brief 作为副本使用
-    struct countedNodePtr {
-        countedNodePtr()
-            : externalCount(0)
-            , nodePtr(nullptr) {}
-
-        int   externalCount;
-        node *nodePtr;
-    };
-
-    std::atomic<countedNodePtr> _atmHead;
-    std::atomic<countedNodePtr> _atmTail;
-
-    struct nodeCounter {
-        unsigned internalCount : 30;
-        unsigned externalCounters : 2;
-        // 一个结点最多被tail和前一个结点的node->next指射,因此外部引用计数最多为2
-    };
-
     struct node {
-        std::atomic<DataType *>     _atmData;
-        std::atomic<nodeCounter>    _atmNodeCount;
-        std::atomic<countedNodePtr> _atmNextCountNodePtr;
-
-        explicit node(int externalCount_ = 2) {
-            nodeCounter newNodeCounter;
-            newNodeCounter.internalCount    = 0;
-            newNodeCounter.externalCounters = externalCount_;
-            _atmNodeCount.store(newNodeCounter);
-
-            countedNodePtr nodePtr;
-            nodePtr.nodePtr       = nullptr;
-            nodePtr.externalCount = 0;
-
-            _atmNextCountNodePtr.store(nodePtr, std::memory_order_acquire);
-        }
-
-        void release_ref() {
-            spdlog::info("call release ref");
-            nodeCounter oldCounter =
-                _atmNodeCount.load(std::memory_order_acquire);
-            nodeCounter newCounter;
-
-            do {
-                newCounter = oldCounter;
-                --newCounter.internalCount;
-            } while (!_atmNodeCount.compare_exchange_strong(
-                oldCounter, newCounter, std::memory_order_acquire,
-                std::memory_order_release));
-
-            if (!newCounter.internalCount && !newCounter.externalCounters) {
-                delete this;
-                spdlog::info("release_ref delete success");
-                destruct_count.fetch_add(1);
-            }
-        }
+        node()
+            : _atmData(nullptr)
+            , _atmNextNodePtr(nullptr) {}
+
+        std::atomic<DataType *> _atmData;
+        std::atomic<node *>     _atmNextNodePtr;
+#ifdef QUEUE_LATENCY_TRACKING
+        std::uint64_t _enqueueNs;
+#endif
     };
 
-    static void increase_external_count(std::atomic<countedNodePtr> &counter_,
-                                        countedNodePtr &oldCounter) {
-        countedNodePtr newCounter;
-        do {
-            newCounter = oldCounter;
-            ++newCounter.externalCount;
-        } while (!counter_.compare_exchange_strong(oldCounter, newCounter,
-                                                   std::memory_order_acquire,
-                                                   std::memory_order_release));
-        oldCounter.externalCount = newCounter.externalCount;
-    }
+    using NodePoolType = NodePool<node>;
 
-    static void free_external_counter(countedNodePtr &oldNodePtr) {
-        spdlog::info("call free_external_counter");
-        node *const nodePtr       = oldNodePtr.nodePtr;
-        int const   countIncrease = oldNodePtr.externalCount - 2;
-        nodeCounter oldCounter =
-            nodePtr->_atmNodeCount.load(std::memory_order_acquire);
-        nodeCounter newCounter;
+    CachePadded<std::atomic<node *>> _atmHead;
+    CachePadded<std::atomic<node *>> _atmTail;
+#ifdef QUEUE_LATENCY_TRACKING
+    latency::Histogram _latency;
+#endif
 
-        do {
-            newCounter = oldCounter;
-            --newCounter.externalCounters;
-            newCounter.internalCount += countIncrease;
-        } while (!nodePtr->_atmNodeCount.compare_exchange_strong(
-            oldCounter, newCounter, std::memory_order_acquire,
-            std::memory_order_release));
+    static node *new_node() { return ::new (NodePoolType::allocate()) node; }
 
-        if (!newCounter.internalCount && !newCounter.externalCounters) {
-            destruct_count.fetch_add(1);
-            spdlog::info("free external counter delete success");
-            delete nodePtr;
-        }
-    }
-
-    void set_new_tail(countedNodePtr &oldTail_, countedNodePtr &newTail_) {
-        node *const currentTailPtr = oldTail_.nodePtr;
-        while (!_atmTail.compare_exchange_strong(oldTail_, newTail_) &&
-               oldTail_.nodePtr == currentTailPtr)
-            ;
-
-        if (oldTail_.nodePtr == currentTailPtr) {
-            free_external_counter(oldTail_);
-        } else {
-            currentTailPtr->release_ref();
-        }
+    static void free_node(void *nodePtr_) {
+        static_cast<node *>(nodePtr_)->~node();
+        NodePoolType::deallocate(nodePtr_);
     }
 
 public:
     LockFreeQueue() {
-        countedNodePtr newNext;
-        newNext.nodePtr       = new node();
-        newNext.externalCount = 1;
-        _atmTail.store(newNext);
-        _atmHead.store(newNext);
-        // spdlog::warn("new_next.ptr is{0}", newNext.nodePtr);
+        node *const dummy = new_node();
+        _atmHead.value.store(dummy, std::memory_order_relaxed);
+        _atmTail.value.store(dummy, std::memory_order_relaxed);
     }
 
+    LockFreeQueue(const LockFreeQueue &)            = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    /// @brief 析构时不能再有其他线程访问队列
     ~LockFreeQueue() {
-        while (pop())
-            ;
-        countedNodePtr headCountedNode = _atmHead.load();
-        delete headCountedNode.nodePtr;
+        node *nodePtr = _atmHead.value.load(std::memory_order_relaxed);
+        while (nodePtr) {
+            node *const next = nodePtr->_atmNextNodePtr.load(std::memory_order_relaxed);
+            delete nodePtr->_atmData.load(std::memory_order_relaxed);
+            free_node(nodePtr);
+            nodePtr = next;
+        }
     }
 
     void push(DataType newValue_) {
-        // create new node and new countedNodePtr
-        std::unique_ptr<DataType> uniPtrNewData(new DataType(newValue_));
-        countedNodePtr            countedNodePtrNewNext;
-        countedNodePtrNewNext.nodePtr       = new node;
-        countedNodePtrNewNext.externalCount = 1;
-
-        // load tail
-        countedNodePtr oldTail = _atmTail.load(std::memory_order_acquire);
+        node *const newNode = new_node();
+        newNode->_atmData.store(new DataType(std::move(newValue_)), std::memory_order_relaxed);
+#ifdef QUEUE_LATENCY_TRACKING
+        newNode->_enqueueNs = latency::now_ns();
+#endif
 
         for (;;) {
-            // 将tail同步更新给oldTail
-            increase_external_count(_atmTail, oldTail);
-
-            DataType *oldData = nullptr;
-            if (oldTail.nodePtr->_atmData.compare_exchange_strong(
-                    oldData, uniPtrNewData.get())) {
-
-                countedNodePtr oldNext;
-                countedNodePtr nowNext =
-                    oldNext.nodePtr->_atmNextCountNodePtr.load();
-
-                if (!oldTail.nodePtr->_atmNextCountNodePtr
-                         .compare_exchange_strong(oldNext,
-                                                  countedNodePtrNewNext)) {
-                    delete countedNodePtrNewNext.nodePtr;
-                    countedNodePtrNewNext = oldNext;
-                }
-                set_new_tail(oldTail, countedNodePtrNewNext);
-                uniPtrNewData.release();
+            node *oldTail = hazard::protect(0, _atmTail.value);
+            node *oldNext = oldTail->_atmNextNodePtr.load(std::memory_order_acquire);
+            if (oldTail != _atmTail.value.load(std::memory_order_acquire)) continue;
+
+            if (oldNext) {
+                // 尾指针落后, 帮上一个 push 推进后重试
+                _atmTail.value.compare_exchange_weak(oldTail, oldNext, std::memory_order_release,
+                                                     std::memory_order_relaxed);
+                continue;
+            }
+            if (oldTail->_atmNextNodePtr.compare_exchange_weak(oldNext, newNode, std::memory_order_release,
+                                                               std::memory_order_relaxed)) {
+                _atmTail.value.compare_exchange_strong(oldTail, newNode, std::memory_order_release,
+                                                       std::memory_order_relaxed);
                 break;
-            } else {
-                countedNodePtr oldNext;
-                if (oldTail.nodePtr->_atmNextCountNodePtr
-                        .compare_exchange_strong(oldNext,
-                                                 countedNodePtrNewNext)) {
-                    oldNext                       = countedNodePtrNewNext;
-                    countedNodePtrNewNext.nodePtr = new node;
-                }
-                set_new_tail(oldTail, countedNodePtrNewNext);
             }
         }
-        ++construct_count;
+        hazard::clear(0);
+        construct_count.add();
     }
 
     /**
@@ -254,34 +167,55 @@ public:
      * @return pop the front data if exists else nullptr
      */
     std::unique_ptr<DataType> pop() {
-        countedNodePtr oldHead = _atmHead.load(std::memory_order_acquire);
         for (;;) {
-            increase_external_count(_atmHead, oldHead);
-            node *const nodePtr = oldHead.nodePtr;
-
-            if (nodePtr == _atmTail.load(std::memory_order_acquire).nodePtr) {
-                // 头尾相等，队列为空，减少头部引用计数
-                nodePtr->release_ref();
+            node *oldHead = hazard::protect(0, _atmHead.value);
+            node *next    = hazard::protect(1, oldHead->_atmNextNodePtr);
+            if (oldHead != _atmHead.value.load(std::memory_order_acquire)) continue;
+
+            if (!next) {
+                // 头尾相等且没有后继, 队列为空
+                hazard::clear(0);
+                hazard::clear(1);
                 return std::unique_ptr<DataType>();
             }
-
-            countedNodePtr next = nodePtr->_atmNextCountNodePtr.load();
-            if (_atmHead.compare_exchange_strong(oldHead, next)) {
-                DataType *const res = nodePtr->_atmData.exchange(nullptr);
-                free_external_counter(oldHead);
+            node *oldTail = _atmTail.value.load(std::memory_order_acquire);
+            if (oldHead == oldTail) {
+                // 尾指针仍指向要摘下的结点, 先推进, 否则回收后尾指针悬空
+                _atmTail.value.compare_exchange_weak(oldTail, next, std::memory_order_release,
+                                                     std::memory_order_relaxed);
+                continue;
+            }
+            if (_atmHead.value.compare_exchange_weak(oldHead, next, std::memory_order_acq_rel,
+                                                     std::memory_order_relaxed)) {
+                // next 成为新的哑结点, 它的数据只归 CAS 成功的线程
+                DataType *const res = next->_atmData.exchange(nullptr, std::memory_order_relaxed);
+#ifdef QUEUE_LATENCY_TRACKING
+                _latency.record_since(next->_enqueueNs);
+#endif
+                hazard::clear(0);
+                hazard::clear(1);
+                hazard::retire(oldHead, &LockFreeQueue::free_node);
+                destruct_count.add();
                 return std::unique_ptr<DataType>(res);
             }
-            nodePtr->release_ref();
         }
     }
 
-    static std::atomic<int> destruct_count;
-    static std::atomic<int> construct_count;
+#ifdef QUEUE_LATENCY_TRACKING
+    /// @brief 元素从 push 到被取出的等待时间分布 (纳秒)
+    latency::Snapshot latency_snapshot() const { return _latency.snapshot(); }
+    void              reset_latency() { _latency.reset(); }
+#endif
+
+    /// @brief 出队 (摘下) 的结点数, 按线程分片计数, 不在热路径上争抢同一缓存行
+    static ShardedCounter destruct_count;
+    /// @brief 入队的结点数
+    static ShardedCounter construct_count;
 };
 
 template <typename DataType>
-std::atomic<int> LockFreeQueue<DataType>::destruct_count = {0};
+ShardedCounter LockFreeQueue<DataType>::destruct_count;
 
 template <typename DataType>
-std::atomic<int> LockFreeQueue<DataType>::construct_count = {0};
+ShardedCounter LockFreeQueue<DataType>::construct_count;
 #endif // LOCKFREEQUEUE_HPP
\ No newline at end of file
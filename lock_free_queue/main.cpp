@@ -144,7 +144,7 @@ int test_multiple_queue() {
               << std::endl;
     std::cout << "destruct count is " << que.destruct_count.load() << std::endl;
     // assert(que.destruct_count == TESTCOUNT * 100 * 4);
-    return que.destruct_count.load(std::memory_order_acquire);
+    return static_cast<int>(que.destruct_count.load());
 }
 
 /// @brief 单生产者,单消费者的无锁队列
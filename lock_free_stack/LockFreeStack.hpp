@@ -22,7 +22,16 @@ private:
     };
 
 public:
-    LockFreeStack() {}
+    LockFreeStack()
+        : _headATM(nullptr)
+        , _toBeDeleted(nullptr)
+        , _theadNumInPop(0) {}
+
+    /// @brief 析构时不能再有其他线程访问
+    ~LockFreeStack() {
+        delete_nodes(_toBeDeleted.load());
+        delete_nodes(_headATM.load());
+    }
 
     /// @brief
     /// @param value
@@ -6,15 +6,45 @@
  * @Description:  parallet test for quick sort
  */
 
+#include "circular_queue/circular_queue.hpp"
+#include "lock_free_queue/LockFreeQueue.hpp"
 #include "spdlog/spdlog.h"
+#include "threadPool/channel.hpp"
+#include "threadPool/co_task.hpp"
+#include "threadPool/concurrent_cache.hpp"
+#include "threadPool/distributed_shared_mutex.hpp"
+#include "threadPool/pipeline.hpp"
+#include "threadPool/lock_free_thread_safe_queue.hpp"
+#include "threadPool/pool_future.hpp"
+#include "threadPool/profiled_mutex.hpp"
+#include "threadPool/queue_latency.hpp"
+#include "threadPool/rcu_map.hpp"
+#include "threadPool/sharded_counter.hpp"
+#include "threadPool/spin_lock.hpp"
+#include "threadPool/task_trace.hpp"
+#include "threadPool/thread_safe_queue.hpp"
+#include "threadPool/wait_group.hpp"
+#include "thread_safe_stack_queue/thread_safe_queue_ht.hpp"
+#include "thread_safe_list/ThreadSafeList.hpp"
 #include "gtest/gtest.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
 #include <future>
+#include <iterator>
 #include <iostream>
 #include <list>
+#include <memory>
 #include <queue>
 #include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 /// @brief sequential func
 /// @tparam T
@@ -244,6 +274,1330 @@ TEST(test_parallel_quick, parallel_sort) { test_parallel_quick(); }
 
 TEST(test_thread_pool_sort, thread_pool_sort) { test_thread_pool_sort(); }
 
+TEST(test_pool_future, then_chain) {
+    PoolFuture<int> result = pool_async([]() { return 20; })
+                                 .then([](int value) { return value + 1; })
+                                 .then([](int value) { return std::to_string(value * 2); })
+                                 .then([](std::string text) { return static_cast<int>(text.size()) + 40; });
+    EXPECT_EQ(result.get(), 42);
+
+    // 返回 PoolFuture 的后续任务被展开
+    PoolFuture<int> nested = make_ready_future(5).then([](int value) {
+        return pool_async([value]() { return value * 3; });
+    });
+    EXPECT_EQ(nested.get(), 15);
+
+    std::atomic<int> sideEffect(0);
+    pool_async([&sideEffect]() { sideEffect += 1; }).then([&sideEffect]() { sideEffect += 2; }).get();
+    EXPECT_EQ(sideEffect.load(), 3);
+}
+
+TEST(test_pool_future, exception_skips_continuations) {
+    std::atomic<bool> called(false);
+    PoolFuture<int>   result = pool_async([]() -> int { throw std::runtime_error("boom"); })
+                                 .then([&called](int value) {
+                                     called = true;
+                                     return value;
+                                 });
+    EXPECT_THROW(result.get(), std::runtime_error);
+    EXPECT_FALSE(called.load());
+    EXPECT_FALSE(result.valid());
+
+    PoolFuture<int> broken;
+    {
+        PoolPromise<int> promise;
+        broken = promise.get_future();
+    }
+    EXPECT_THROW(broken.get(), std::future_error);
+}
+
+TEST(test_pool_future, promise_then_before_ready) {
+    PoolPromise<int> promise;
+    PoolFuture<int>  result = promise.get_future().then([](int value) { return value * 2; });
+    EXPECT_FALSE(result.ready());
+    std::thread producer([&promise]() { promise.set_value(21); });
+    EXPECT_EQ(result.get(), 42);
+    producer.join();
+    EXPECT_THROW(promise.set_value(1), std::future_error);
+}
+
+TEST(test_pool_future, when_all) {
+    std::vector<PoolFuture<int>> futures;
+    for (int i = 0; i < 64; ++i) {
+        futures.push_back(pool_async([i]() { return i * i; }));
+    }
+    std::vector<int> squares = when_all(std::move(futures)).get();
+    ASSERT_EQ(squares.size(), 64u);
+    for (int i = 0; i < 64; ++i) {
+        EXPECT_EQ(squares[i], i * i);
+    }
+
+    EXPECT_TRUE(when_all(std::vector<PoolFuture<int>>()).get().empty());
+
+    std::vector<PoolFuture<void>> voids;
+    std::atomic<int>              count(0);
+    for (int i = 0; i < 16; ++i) {
+        voids.push_back(pool_async([&count]() { ++count; }));
+    }
+    when_all(std::move(voids)).get();
+    EXPECT_EQ(count.load(), 16);
+
+    auto mixed = when_all(pool_async([]() { return 1; }), pool_async([]() { return std::string("two"); }),
+                          make_ready_future())
+                     .get();
+    EXPECT_EQ(std::get<0>(mixed), 1);
+    EXPECT_EQ(std::get<1>(mixed), "two");
+
+    std::vector<PoolFuture<int>> failing;
+    failing.push_back(make_ready_future(1));
+    failing.push_back(pool_async([]() -> int { throw std::logic_error("fail"); }));
+    EXPECT_THROW(when_all(std::move(failing)).get(), std::logic_error);
+}
+
+TEST(test_pool_future, when_any) {
+    PoolPromise<int>             never;
+    std::vector<PoolFuture<int>> futures;
+    futures.push_back(never.get_future());
+    futures.push_back(pool_async([]() { return 7; }));
+    std::pair<std::size_t, int> first = when_any(std::move(futures)).get();
+    EXPECT_EQ(first.first, 1u);
+    EXPECT_EQ(first.second, 7);
+
+    std::vector<PoolFuture<void>> voids;
+    voids.push_back(PoolPromise<void>().get_future()); // broken_promise 同样算作就绪
+    EXPECT_THROW(when_any(std::move(voids)).get(), std::future_error);
+
+    EXPECT_THROW(when_any(std::vector<PoolFuture<int>>()), std::invalid_argument);
+}
+
+TEST(test_pool_future, nested_get_on_single_worker) {
+    // 池线程内 get() 嵌套任务: 等待时帮忙执行排队任务, 单线程执行器也不会死等
+    struct InlineQueueExecutor : Executor {
+        void post(FunctionWrapper task_) override {
+            std::lock_guard<std::mutex> lock(mtx);
+            tasks.push_back(std::move(task_));
+        }
+        bool run_pending_task() override {
+            FunctionWrapper task;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (tasks.empty()) return false;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+            return true;
+        }
+        std::size_t concurrency() const override { return 1; }
+
+        std::mutex                  mtx;
+        std::deque<FunctionWrapper> tasks;
+    } executor;
+
+    PoolFuture<int> outer = pool_async(
+        [&executor]() { return pool_async([]() { return 1; }, executor).get() + 1; }, executor);
+    EXPECT_EQ(outer.get(), 2);
+}
+
+TEST(test_channel, status_and_move_only) {
+    Channel<std::unique_ptr<int>> channel(2);
+    EXPECT_EQ(channel.try_send(std::unique_ptr<int>(new int(1))), ChannelStatus::Success);
+    EXPECT_TRUE(channel.send(std::unique_ptr<int>(new int(2))));
+
+    std::unique_ptr<int> extra(new int(3));
+    EXPECT_EQ(channel.try_send(std::move(extra)), ChannelStatus::Full);
+    ASSERT_TRUE(extra); // 失败时值不被移走
+    EXPECT_EQ(channel.send_for(std::move(extra), std::chrono::milliseconds(10)), ChannelStatus::Timeout);
+    ASSERT_TRUE(extra);
+
+    std::unique_ptr<int> value;
+    EXPECT_TRUE(channel.receive(value));
+    EXPECT_EQ(*value, 1);
+    EXPECT_EQ(channel.try_receive(value), ChannelStatus::Success);
+    EXPECT_EQ(*value, 2);
+    EXPECT_EQ(channel.try_receive(value), ChannelStatus::Empty);
+    EXPECT_EQ(channel.receive_for(value, std::chrono::milliseconds(10)), ChannelStatus::Timeout);
+
+    EXPECT_TRUE(channel.send(std::move(extra)));
+    channel.close();
+    EXPECT_FALSE(channel.send(std::unique_ptr<int>()));
+    EXPECT_EQ(channel.try_receive(value), ChannelStatus::Success); // 关闭后仍可取完剩余数据
+    EXPECT_EQ(*value, 3);
+    EXPECT_EQ(channel.try_receive(value), ChannelStatus::Closed);
+    EXPECT_FALSE(channel.receive(value));
+}
+
+TEST(test_channel, rendezvous) {
+    Channel<int> channel;
+    EXPECT_EQ(channel.try_send(1), ChannelStatus::Full); // 没有接收方在等
+
+    std::atomic<int> delivered(0);
+    std::thread      first([&]() {
+        channel.send(1);
+        ++delivered;
+    });
+    std::thread second([&]() {
+        channel.send(2);
+        ++delivered;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(delivered.load(), 0); // 值被取走之前两个发送方都不能返回
+
+    int a = 0, b = 0;
+    EXPECT_TRUE(channel.receive(a));
+    EXPECT_TRUE(channel.receive(b));
+    first.join();
+    second.join();
+    EXPECT_EQ(delivered.load(), 2);
+    EXPECT_EQ(a + b, 3);
+
+    int value = 7;
+    EXPECT_EQ(channel.send_for(std::move(value), std::chrono::milliseconds(10)), ChannelStatus::Timeout);
+    EXPECT_EQ(channel.size(), 0u); // 超时的值被撤回
+}
+
+TEST(test_channel, batch_mpmc) {
+    constexpr int kProducers = 4, kConsumers = 3, kPerProducer = 100000;
+    Channel<long> channel(1024);
+
+    std::atomic<long>        total(0);
+    std::atomic<long>        received(0);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < kConsumers; ++c) {
+        consumers.emplace_back([&]() {
+            std::vector<long> batch(256);
+            std::size_t       n;
+            while ((n = channel.receive_n(batch.begin(), batch.size())) != 0) {
+                long sum = 0;
+                for (std::size_t i = 0; i < n; ++i) sum += batch[i];
+                total += sum;
+                received += n;
+            }
+        });
+    }
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p]() {
+            std::vector<long> values(kPerProducer);
+            for (int i = 0; i < kPerProducer; ++i) values[i] = static_cast<long>(p) * kPerProducer + i;
+            if (p % 2) {
+                EXPECT_EQ(channel.send_n(values.begin(), values.size()), values.size());
+            } else {
+                for (long v : values) channel.send(v);
+            }
+        });
+    }
+    for (auto &t : producers) t.join();
+    channel.close();
+    for (auto &t : consumers) t.join();
+
+    long const count = static_cast<long>(kProducers) * kPerProducer;
+    EXPECT_EQ(received.load(), count);
+    EXPECT_EQ(total.load(), count * (count - 1) / 2);
+}
+
+TEST(test_channel, select) {
+    Channel<int>         numbers(8);
+    Channel<std::string> words;
+
+    Select select;
+    int    numberSum = 0, wordCount = 0;
+    select.on_receive(numbers, [&](int value) { numberSum += value; })
+        .on_receive(words, [&](std::string word) { wordCount += word == "hi"; });
+    EXPECT_EQ(select.try_select(), Select::kTimeout);
+    EXPECT_EQ(select.wait_for(std::chrono::milliseconds(10)), Select::kTimeout);
+
+    std::thread numberProducer([&]() {
+        for (int i = 1; i <= 1000; ++i) numbers.send(i);
+        numbers.close();
+    });
+    std::thread wordProducer([&]() {
+        for (int i = 0; i < 100; ++i) words.send("hi");
+        words.close();
+    });
+    std::size_t fired = 0, branch;
+    while ((branch = select.wait()) != Select::kClosed) {
+        ASSERT_LT(branch, 2u);
+        ++fired;
+    }
+    numberProducer.join();
+    wordProducer.join();
+    EXPECT_EQ(fired, 1100u);
+    EXPECT_EQ(numberSum, 500500);
+    EXPECT_EQ(wordCount, 100);
+}
+
+TEST(test_channel, select_unbuffered_try_send) {
+    Channel<int> a, b;
+    Select       select;
+    int          received = 0;
+    select.on_receive(a, [&](int value) { received += value; }).on_receive(b, [&](int value) { received += value; });
+
+    std::thread waiter([&]() { select.wait(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // 让 Select 挂到两个通道上
+
+    // Select 醒来只取一个值, 不能同时向两个无缓冲通道承诺交付
+    int const successes =
+        (a.try_send(1) == ChannelStatus::Success) + (b.try_send(2) == ChannelStatus::Success);
+    EXPECT_LE(successes, 1);
+
+    a.close();
+    b.close();
+    waiter.join();
+    EXPECT_EQ(a.size() + b.size(), 0u); // 报告成功的值都被取走了
+    EXPECT_EQ(received != 0, successes == 1);
+}
+
+TEST(test_pipeline, ordered_output) {
+    PipelineOptions options;
+    options.capacity = 64;
+    options.batch    = 16;
+    options.ordered  = true;
+
+    std::vector<std::string> output;
+    auto pipeline = make_pipeline<int>(options)
+                        .stage("square", 4, [](int value) { return static_cast<long>(value) * value; })
+                        .stage("format", 3, [](long value) { return std::to_string(value); })
+                        .sink("collect", [&output](std::string text) { output.push_back(std::move(text)); });
+
+    std::vector<int> input(20000);
+    for (int i = 0; i < 20000; ++i) input[i] = i;
+    PipelineStats const stats = pipeline.run(input.begin(), input.end());
+
+    ASSERT_EQ(output.size(), input.size());
+    for (int i = 0; i < 20000; ++i) {
+        ASSERT_EQ(output[i], std::to_string(static_cast<long>(i) * i));
+    }
+    ASSERT_EQ(stats.stages.size(), 3u);
+    for (auto const &stage : stats.stages) {
+        EXPECT_EQ(stage.items, 20000u);
+        EXPECT_LE(stage.maxQueue, options.capacity); // 背压: 积压不超过通道容量
+    }
+    EXPECT_THROW(make_pipeline<int>(options).sink("sink", [](int) {}, 2), std::invalid_argument);
+}
+
+TEST(test_pipeline, bottleneck_and_push) {
+    PipelineOptions options;
+    options.capacity = 32;
+    options.batch    = 8;
+
+    std::atomic<long> sum(0);
+    auto              pipeline = make_pipeline<int>(options)
+                        .stage("fast", 1, [](int value) { return value + 1; })
+                        .stage("slow", 2,
+                               [](int value) {
+                                   std::this_thread::sleep_for(std::chrono::microseconds(200));
+                                   return value;
+                               })
+                        .sink("sum", [&sum](int value) { sum += value; }, 2);
+    pipeline.start();
+    for (int i = 0; i < 2000; ++i) {
+        ASSERT_TRUE(pipeline.push(i));
+    }
+    PipelineStats const stats = pipeline.finish();
+    EXPECT_EQ(sum.load(), 2000L * 2001 / 2);
+    EXPECT_EQ(stats.bottleneck(), 1u);
+    EXPECT_NE(stats.to_string().find("slow x2"), std::string::npos);
+    EXPECT_FALSE(pipeline.push(0)); // finish 之后输入已关闭
+}
+
+TEST(test_pipeline, backpressure_is_not_busy) {
+    PipelineOptions options;
+    options.capacity = 16;
+    options.batch    = 4;
+
+    auto pipeline = make_pipeline<int>(options)
+                        .stage("parse", 4, [](int value) { return value + 1; })
+                        .stage("enrich", 1,
+                               [](int value) {
+                                   std::this_thread::sleep_for(std::chrono::microseconds(300));
+                                   return value;
+                               })
+                        .sink("drop", [](int) {});
+    std::vector<int> input(1000);
+    for (int i = 0; i < 1000; ++i) input[i] = i;
+    PipelineStats const stats = pipeline.run(input.begin(), input.end());
+
+    ASSERT_EQ(stats.stages.size(), 3u);
+    EXPECT_EQ(stats.bottleneck(), 1u);
+    // parse 几乎一直被 enrich 背压, 阻塞时间记为 blocked 而不是 busy
+    EXPECT_LT(stats.stages[0].utilization, 0.5);
+    EXPECT_GT(stats.stages[0].blockedSeconds, stats.stages[0].busySeconds);
+    EXPECT_GT(stats.stages[1].utilization, 0.5);
+}
+
+TEST(test_pipeline, stage_exception) {
+    std::atomic<int> delivered(0);
+    auto             pipeline = make_pipeline<int>()
+                        .stage("parse", 2,
+                               [](int value) {
+                                   if (value == 500) throw std::runtime_error("bad record");
+                                   return value;
+                               })
+                        .sink("sink", [&delivered](int) { ++delivered; });
+    std::vector<int> input(1000);
+    for (int i = 0; i < 1000; ++i) input[i] = i;
+    EXPECT_THROW(pipeline.run(input.begin(), input.end()), std::runtime_error);
+    EXPECT_LT(delivered.load(), 1000);
+
+    // ordered 模式下 sink 抛出只丢弃那一条, 其余条目各交付一次且保持顺序
+    PipelineOptions options;
+    options.batch   = 16;
+    options.ordered = true;
+    std::vector<std::string> output;
+    auto ordered = make_pipeline<int>(options)
+                       .stage("format", 3, [](int value) { return std::to_string(value); })
+                       .sink("collect", [&output](std::string text) {
+                           if (text == "500") throw std::runtime_error("bad sink");
+                           output.push_back(std::move(text));
+                       });
+    EXPECT_THROW(ordered.run(input.begin(), input.end()), std::runtime_error);
+    ASSERT_EQ(output.size(), 999u);
+    for (int i = 0, j = 0; i < 1000; ++i) {
+        if (i == 500) continue;
+        ASSERT_EQ(output[j++], std::to_string(i));
+    }
+}
+
+TEST(test_pipeline, ordered_stage_exception) {
+    // 中间阶段抛出时同批其余结果照常发出, 出错序号以跳过标记通知 sink, 后续条目不必等到 finish
+    PipelineOptions options;
+    options.batch   = 16;
+    options.ordered = true;
+    std::vector<std::string> output;
+    std::atomic<int>         delivered(0);
+    auto pipeline = make_pipeline<int>(options)
+                        .stage("parse", 3,
+                               [](int value) {
+                                   if (value == 500) throw std::runtime_error("bad record");
+                                   return value;
+                               })
+                        .stage("format", 2, [](int value) { return std::to_string(value); })
+                        .sink("collect", [&](std::string text) {
+                            output.push_back(std::move(text));
+                            ++delivered;
+                        });
+    pipeline.start();
+    for (int i = 0; i < 1000; ++i) {
+        pipeline.push(i);
+    }
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (delivered.load() < 999 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(delivered.load(), 999); // 输入尚未关闭, 出错之后的条目也已交付
+    EXPECT_THROW(pipeline.finish(), std::runtime_error);
+    ASSERT_EQ(output.size(), 999u);
+    for (int i = 0, j = 0; i < 1000; ++i) {
+        if (i == 500) continue;
+        ASSERT_EQ(output[j++], std::to_string(i));
+    }
+}
+
+struct CountedValue {
+    static std::atomic<int> live;
+
+    explicit CountedValue(int value_ = 0)
+        : value(value_) {
+        ++live;
+    }
+    CountedValue(CountedValue const &other_)
+        : value(other_.value) {
+        ++live;
+    }
+    CountedValue &operator=(CountedValue const &) = default;
+    ~CountedValue() { --live; }
+
+    int value;
+};
+std::atomic<int> CountedValue::live(0);
+
+// 危险指针域在池内任务里才第一次用到, 晚于 StealThreadPool 单例构造;
+// 进程退出时池在静态析构阶段才 join 工作线程, 线程退出仍要归还记录, 域不能先于池析构.
+// 子进程里单例都是新建的, 名字以 DeathTest 结尾使它排在其他测试之前, fork 时尚无线程.
+TEST(test_hazard_pointer_DeathTest, pool_workers_exit_after_domain_use) {
+    EXPECT_EXIT(
+        {
+            StealThreadPool &pool = StealThreadPool::instance();
+            WaitGroup        group;
+            group.add();
+            pool.post([&group]() {
+                LockFreeQueue<int> queue;
+                queue.push(1);
+                queue.pop();
+                group.done();
+            });
+            group.wait();
+            std::exit(0);
+        },
+        ::testing::ExitedWithCode(0), "");
+}
+
+TEST(test_lock_free_queue, api_and_lifetime) {
+    {
+        LockFreeThreadSafeQueue<std::unique_ptr<int>> queue;
+        EXPECT_TRUE(queue.empty());
+        EXPECT_FALSE(queue.try_pop());
+        queue.push(std::unique_ptr<int>(new int(1)));
+        queue.push(std::unique_ptr<int>(new int(2)));
+        EXPECT_FALSE(queue.empty());
+        std::unique_ptr<int> value;
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(*value, 1);
+        EXPECT_EQ(**queue.wait_and_pop(), 2);
+        EXPECT_TRUE(queue.empty());
+    }
+    {
+        LockFreeThreadSafeQueue<CountedValue> queue;
+        for (int i = 0; i < 100; ++i) queue.push(CountedValue(i));
+        CountedValue value;
+        for (int i = 0; i < 40; ++i) {
+            queue.wait_and_pop(value);
+            EXPECT_EQ(value.value, i);
+        }
+        EXPECT_EQ(CountedValue::live.load(), 61); // 队列里 60 个加上 value
+    }
+    EXPECT_EQ(CountedValue::live.load(), 0); // 析构释放剩余元素
+}
+
+TEST(test_lock_free_queue, mpmc_fifo_per_producer) {
+    constexpr int kProducers = 4, kConsumers = 4, kPerProducer = 50000;
+    LockFreeThreadSafeQueue<long> queue;
+
+    std::atomic<long>        total(0);
+    std::atomic<int>         misordered(0);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < kConsumers; ++c) {
+        consumers.emplace_back([&]() {
+            std::vector<long> last(kProducers, -1);
+            long              sum = 0;
+            for (long value;;) {
+                queue.wait_and_pop(value);
+                if (value < 0) break;
+                long const producer = value / kPerProducer, sequence = value % kPerProducer;
+                if (sequence <= last[producer]) ++misordered;
+                last[producer] = sequence;
+                sum += value;
+            }
+            total += sum;
+        });
+    }
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < kPerProducer; ++i) queue.push(static_cast<long>(p) * kPerProducer + i);
+        });
+    }
+    for (auto &t : producers) t.join();
+    for (int c = 0; c < kConsumers; ++c) queue.push(-1);
+    for (auto &t : consumers) t.join();
+
+    long const count = static_cast<long>(kProducers) * kPerProducer;
+    EXPECT_EQ(total.load(), count * (count - 1) / 2);
+    EXPECT_EQ(misordered.load(), 0);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(test_lock_free_queue, blocking_waiters_wake) {
+    LockFreeThreadSafeQueue<int> queue;
+    std::atomic<int>             sum(0);
+    std::vector<std::thread>     waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&]() { sum += *queue.wait_and_pop(); });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 让等待者先睡下
+    for (int i = 1; i <= 3; ++i) queue.push(i);
+    for (auto &t : waiters) t.join();
+    EXPECT_EQ(sum.load(), 6);
+}
+
+/// @brief 不休眠的多生产者多消费者压测: 元素不丢不重, 同一生产者的元素保持先后顺序
+TEST(test_lock_free_queue, ms_queue_stress_fifo_per_producer) {
+    constexpr int       kProducers = 4, kConsumers = 4, kPerProducer = 100000;
+    LockFreeQueue<long> que;
+    std::atomic<long>   popped(0);
+    std::atomic<long>   total(0);
+    std::atomic<int>    misordered(0);
+    // 计数是类型的静态成员, 只看本测试的增量
+    long const constructed = static_cast<long>(LockFreeQueue<long>::construct_count.load());
+    long const destructed  = static_cast<long>(LockFreeQueue<long>::destruct_count.load());
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < kPerProducer; ++i) que.push(static_cast<long>(p) * kPerProducer + i);
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&]() {
+            std::vector<long> last(kProducers, -1);
+            long              sum = 0;
+            while (popped.load(std::memory_order_relaxed) < kProducers * kPerProducer) {
+                auto p = que.pop();
+                if (!p) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                long const producer = *p / kPerProducer, sequence = *p % kPerProducer;
+                if (sequence <= last[producer]) ++misordered;
+                last[producer] = sequence;
+                sum += *p;
+                ++popped;
+            }
+            total += sum;
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    long const count = static_cast<long>(kProducers) * kPerProducer;
+    EXPECT_EQ(popped.load(), count);
+    EXPECT_EQ(total.load(), count * (count - 1) / 2);
+    EXPECT_EQ(misordered.load(), 0);
+    EXPECT_FALSE(que.pop());
+    EXPECT_EQ(static_cast<long>(LockFreeQueue<long>::construct_count.load()) - constructed, count);
+    EXPECT_EQ(static_cast<long>(LockFreeQueue<long>::destruct_count.load()) - destructed, count);
+}
+
+TEST(test_queue_batch, pop_n_and_pop_all) {
+    ThreadSafeQueue<std::unique_ptr<int>> queue;
+    for (int i = 0; i < 10; ++i) queue.push(std::unique_ptr<int>(new int(i)));
+
+    std::vector<std::unique_ptr<int>> batch(4);
+    EXPECT_EQ(queue.pop_n(batch.begin(), batch.size()), 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(*batch[i], i);
+
+    std::unique_ptr<int> value;
+    EXPECT_TRUE(queue.try_pop(value)); // 切链后头部仍可正常弹出
+    EXPECT_EQ(*value, 4);
+
+    auto rest = queue.pop_all();
+    ASSERT_EQ(rest.size(), 5u);
+    for (int i = 0; i < 5; ++i) EXPECT_EQ(*rest[i], i + 5);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.pop_n(batch.begin(), batch.size()), 0u);
+    EXPECT_TRUE(queue.pop_all().empty());
+
+    queue.push(std::unique_ptr<int>(new int(42))); // pop_all 之后尾部仍连着头部
+    EXPECT_TRUE(queue.try_steal(value));
+    EXPECT_EQ(*value, 42);
+
+    ThreadSafeQueueHT<int> queueHT;
+    for (int i = 0; i < 10; ++i) queueHT.push(i);
+    std::vector<int> out;
+    EXPECT_EQ(queueHT.pop_n(std::back_inserter(out), 3), 3u);
+    auto all = queueHT.pop_all();
+    out.insert(out.end(), all.begin(), all.end());
+    EXPECT_EQ(out, std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    EXPECT_TRUE(queueHT.empty());
+    queueHT.push(7);
+    int valueHT = 0;
+    EXPECT_TRUE(queueHT.try_pop(valueHT));
+    EXPECT_EQ(valueHT, 7);
+}
+
+TEST(test_queue_batch, concurrent_drain) {
+    constexpr int         kProducers = 3, kPerProducer = 100000;
+    ThreadSafeQueue<long> queue;
+    std::atomic<int>      finished(0);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < kPerProducer; ++i) queue.push(static_cast<long>(p) * kPerProducer + i);
+            ++finished;
+        });
+    }
+    std::vector<long> batch(256);
+    long              total = 0, count = 0;
+    bool              all_pops = false;
+    for (;;) {
+        bool const  done = finished.load() == kProducers;
+        std::size_t n    = 0;
+        if (all_pops) {
+            for (long v : queue.pop_all()) {
+                total += v;
+                ++n;
+            }
+        } else {
+            n = queue.pop_n(batch.begin(), batch.size());
+            for (std::size_t i = 0; i < n; ++i) total += batch[i];
+        }
+        all_pops = !all_pops;
+        count += n;
+        if (done && n == 0 && queue.empty()) break;
+        if (n == 0) std::this_thread::yield();
+    }
+    for (auto &t : producers) t.join();
+
+    long const expected = static_cast<long>(kProducers) * kPerProducer;
+    EXPECT_EQ(count, expected);
+    EXPECT_EQ(total, expected * (expected - 1) / 2);
+}
+
+TEST(test_latency, histogram_percentiles) {
+    // 每个值落入的桶上界不小于它, 且相对误差不超过 1 / kSubBuckets
+    for (std::uint64_t v : std::initializer_list<std::uint64_t>{0, 1, 31, 32, 33, 1000, 123456789, latency::Buckets::kMaxValue}) {
+        std::uint64_t const high = latency::Buckets::highest_of(latency::Buckets::index_of(v));
+        EXPECT_GE(high, v);
+        EXPECT_LE(high - v, v / latency::Buckets::kSubBuckets);
+    }
+    EXPECT_EQ(latency::Buckets::index_of(latency::Buckets::kMaxValue), latency::Buckets::kCount - 1);
+
+    latency::Histogram histogram;
+    EXPECT_EQ(histogram.snapshot().count(), 0u);
+    EXPECT_EQ(histogram.snapshot().percentile(99), 0u);
+    for (std::uint64_t v = 1; v <= 1000; ++v) histogram.record(v);
+    latency::Snapshot const snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count(), 1000u);
+    EXPECT_EQ(snapshot.min(), 1u);
+    EXPECT_EQ(snapshot.max(), 1000u);
+    EXPECT_DOUBLE_EQ(snapshot.mean(), 500.5);
+    EXPECT_EQ(snapshot.percentile(0), 1u);
+    EXPECT_EQ(snapshot.percentile(100), 1000u);
+    EXPECT_GE(snapshot.percentile(50), 500u);
+    EXPECT_LE(snapshot.percentile(50), 500u + 500u / latency::Buckets::kSubBuckets);
+    EXPECT_GE(snapshot.percentile(99), 990u);
+
+    latency::Snapshot merged = snapshot;
+    merged.merge(snapshot);
+    EXPECT_EQ(merged.count(), 2000u);
+    histogram.reset();
+    EXPECT_EQ(histogram.snapshot().count(), 0u);
+}
+
+TEST(test_latency, concurrent_record) {
+    constexpr int            kThreads = 12, kPerThread = 20000;
+    latency::Histogram       histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kPerThread; ++i) histogram.record(static_cast<std::uint64_t>(t * kPerThread + i));
+        });
+    }
+    for (auto &t : threads) t.join();
+    latency::Snapshot const snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count(), static_cast<std::uint64_t>(kThreads) * kPerThread);
+    EXPECT_EQ(snapshot.min(), 0u);
+    EXPECT_EQ(snapshot.max(), static_cast<std::uint64_t>(kThreads) * kPerThread - 1);
+}
+
+#ifdef QUEUE_LATENCY_TRACKING
+/// @brief 先压入 count_ 个元素, 等待 delay_ 后全部取出: 每个元素都应记录一次, 且等待时间不短于 delay_
+template <typename Queue, typename Push, typename Pop>
+void check_queue_latency(Queue &queue_, Push push_, Pop pop_) {
+    constexpr int                   kCount = 64;
+    std::chrono::milliseconds const delay(5);
+    for (int i = 0; i < kCount; ++i) push_(queue_, i);
+    std::this_thread::sleep_for(delay);
+    for (int i = 0; i < kCount; ++i) EXPECT_TRUE(pop_(queue_));
+    latency::Snapshot const snapshot = queue_.latency_snapshot();
+    EXPECT_EQ(snapshot.count(), static_cast<std::uint64_t>(kCount));
+    EXPECT_GE(snapshot.min(), static_cast<std::uint64_t>(std::chrono::nanoseconds(delay).count()));
+    EXPECT_GE(snapshot.percentile(50), snapshot.min());
+    queue_.reset_latency();
+    EXPECT_EQ(queue_.latency_snapshot().count(), 0u);
+}
+
+TEST(test_latency, queues_record_wait_time) {
+    auto push = [](auto &q_, int v_) { q_.push(v_); };
+    int  value;
+
+    ThreadSafeQueue<int> queue;
+    check_queue_latency(queue, push, [&](ThreadSafeQueue<int> &q_) { return q_.try_pop(value); });
+    LockFreeThreadSafeQueue<int> lockFree;
+    check_queue_latency(lockFree, push, [&](LockFreeThreadSafeQueue<int> &q_) { return q_.try_pop(value); });
+    LockFreeQueue<int> msQueue;
+    check_queue_latency(msQueue, push, [](LockFreeQueue<int> &q_) { return q_.pop() != nullptr; });
+    CircularQueue<int, 64> circular;
+    check_queue_latency(circular, push, [&](CircularQueue<int, 64> &q_) { return q_.pop(value); });
+    CircularQueueSeq<int, 64> circularSeq;
+    check_queue_latency(circularSeq, push, [&](CircularQueueSeq<int, 64> &q_) { return q_.pop(value); });
+    CircularQueueLightweight<int, 64> circularLight;
+    check_queue_latency(
+        circularLight, [](CircularQueueLightweight<int, 64> &q_, int v_) { q_.push(v_); },
+        [&](CircularQueueLightweight<int, 64> &q_) { return q_.pop(value); });
+    Channel<int> channel(64);
+    check_queue_latency(channel, [](Channel<int> &c_, int v_) { c_.send(v_); },
+                        [&](Channel<int> &c_) { return c_.try_receive(value) == ChannelStatus::Success; });
+
+    // 批量取出同样逐个记录
+    for (int i = 0; i < 8; ++i) queue.push(i);
+    std::vector<int> out;
+    queue.pop_n(std::back_inserter(out), 3);
+    queue.pop_all();
+    EXPECT_EQ(queue.latency_snapshot().count(), 8u);
+    for (int i = 0; i < 8; ++i) channel.send(i);
+    channel.try_receive_n(std::back_inserter(out), 8);
+    EXPECT_EQ(channel.latency_snapshot().count(), 8u);
+}
+#endif // QUEUE_LATENCY_TRACKING
+
+TEST(test_sharded_counter, concurrent_add) {
+    constexpr int            kThreads = 24, kPerThread = 20000; // 线程数超过分片数, 部分线程共用分片
+    ShardedCounter           counter;
+    std::vector<std::thread> threads;
+    EXPECT_EQ(counter.load(), 0u);
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                if (i % 2)
+                    ++counter;
+                else
+                    counter += static_cast<std::uint64_t>(t);
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    std::uint64_t expected = 0;
+    for (int t = 0; t < kThreads; ++t) expected += kPerThread / 2 + static_cast<std::uint64_t>(t) * (kPerThread / 2);
+    EXPECT_EQ(counter.load(), expected);
+    counter.reset();
+    EXPECT_EQ(static_cast<std::uint64_t>(counter), 0u);
+}
+
+/// @brief 多线程在锁内做非原子的读-改-写, 锁有问题就会丢更新
+template <typename Lock>
+void check_mutual_exclusion(Lock &lock_) {
+    constexpr int            kThreads = 6, kPerThread = 20000;
+    long                     counter  = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                std::lock_guard<Lock> guard(lock_);
+                long const            value = counter;
+                counter                     = value + 1;
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    EXPECT_EQ(counter, static_cast<long>(kThreads) * kPerThread);
+
+    ASSERT_TRUE(lock_.try_lock());
+    std::thread other([&lock_]() { EXPECT_FALSE(lock_.try_lock()); });
+    other.join();
+    lock_.unlock();
+}
+
+TEST(test_spin_lock, mutual_exclusion) {
+    TTASLock ttas;
+    check_mutual_exclusion(ttas);
+    TicketLock ticket;
+    check_mutual_exclusion(ticket);
+    MCSLock mcs;
+    check_mutual_exclusion(mcs);
+    SpinThenParkLock park(1); // 几乎立即睡眠, 覆盖唤醒路径
+    check_mutual_exclusion(park);
+}
+
+TEST(test_spin_lock, mcs_nested_out_of_order_unlock) {
+    MCSLock first, second;
+    long    counter = 0;
+    auto    worker  = [&]() {
+        for (int i = 0; i < 10000; ++i) {
+            std::lock(first, second);
+            ++counter;
+            first.unlock(); // 先放先拿到的那把, 结点不按栈序归还
+            second.unlock();
+        }
+    };
+    std::thread t1(worker), t2(worker);
+    t1.join();
+    t2.join();
+    EXPECT_EQ(counter, 20000);
+}
+
+TEST(test_distributed_shared_mutex, readers_see_consistent_writes) {
+    constexpr int            kReaders = 6, kWriters = 2, kReads = 20000, kWrites = 2000;
+    DistributedSharedMutex   mtx;
+    long                     first = 0, second = 0; // 写者总是一起改, 读者不应看到不相等
+    std::atomic<int>         torn(0);
+    std::vector<std::thread> threads;
+    for (int r = 0; r < kReaders; ++r) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kReads; ++i) {
+                std::shared_lock<DistributedSharedMutex> lock(mtx);
+                if (first != second) ++torn;
+            }
+        });
+    }
+    for (int w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kWrites; ++i) {
+                std::lock_guard<DistributedSharedMutex> lock(mtx);
+                ++first;
+                ++second;
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(first, static_cast<long>(kWriters) * kWrites);
+
+    // 读锁在别的线程释放 (落在不同分片) 后写者仍能拿到锁
+    ASSERT_TRUE(mtx.try_lock_shared());
+    EXPECT_TRUE(mtx.try_lock_shared());
+    EXPECT_FALSE(mtx.try_lock());
+    std::thread([&mtx]() { mtx.unlock_shared(); }).join();
+    mtx.unlock_shared();
+    ASSERT_TRUE(mtx.try_lock());
+    std::thread([&mtx]() { EXPECT_FALSE(mtx.try_lock_shared()); }).join();
+    mtx.unlock();
+}
+
+TEST(test_rcu_map, readers_see_whole_versions) {
+    constexpr int            kReaders = 4, kUpdates = 500;
+    RcuMap<int, long>        map;
+    std::atomic<bool>        done(false);
+    std::atomic<int>         torn(0);
+    std::vector<std::thread> threads;
+    map.update([](std::unordered_map<int, long> &m_) {
+        m_[0] = 0;
+        m_[1] = 0;
+    });
+    std::weak_ptr<std::unordered_map<int, long> const> first = map.snapshot();
+    for (int r = 0; r < kReaders; ++r) {
+        threads.emplace_back([&]() {
+            long last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                // 同一版本里两个键总是相等, 版本号只增不减
+                auto const snapshot = map.snapshot();
+                if (snapshot->at(0) != snapshot->at(1) || snapshot->at(0) < last) ++torn;
+                last = snapshot->at(0);
+                long value = -1;
+                if (!map.find(0, value) || value < last) ++torn;
+            }
+        });
+    }
+    std::thread writer([&]() {
+        for (long i = 1; i <= kUpdates; ++i) {
+            map.update([i](std::unordered_map<int, long> &m_) {
+                m_[0] = i;
+                m_[1] = i;
+            });
+        }
+    });
+    writer.join();
+    done.store(true, std::memory_order_release);
+    for (auto &t : threads) t.join();
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(map.value_for(1), kUpdates);
+    EXPECT_EQ(map.size(), 2u);
+
+    // 写线程退出时还被读者保护的旧版本交给了全局列表; 读者都退出后再发布一次, 发布后的扫描接手并回收
+    auto const before = map.snapshot();
+    map.insert_or_assign(2, 7);
+    EXPECT_TRUE(first.expired());
+    EXPECT_TRUE(map.erase(0));
+    EXPECT_FALSE(map.erase(0));
+    EXPECT_FALSE(map.contains(0));
+    EXPECT_EQ(map.value_for(2), 7);
+    EXPECT_EQ(before->size(), 2u); // 旧快照不受后续更新影响
+    EXPECT_EQ(before->count(2), 0u);
+}
+
+/// @brief 读者把负值拷出来时停在 find 里 (仍保护着所在的版本), 直到放行
+struct GatedValue {
+    static std::atomic<bool> entered;
+    static std::atomic<bool> released;
+
+    GatedValue(int value_ = 0)
+        : value(value_) {}
+    GatedValue(GatedValue const &) = default;
+    GatedValue &operator=(GatedValue const &other_) {
+        if (other_.value < 0) {
+            entered = true;
+            while (!released) std::this_thread::yield();
+        }
+        value = other_.value;
+        return *this;
+    }
+
+    int value;
+};
+std::atomic<bool> GatedValue::entered(false);
+std::atomic<bool> GatedValue::released(false);
+
+TEST(test_rcu_map, old_versions_freed_on_publish) {
+    RcuMap<int, GatedValue> map;
+    map.insert_or_assign(0, GatedValue(-1));
+    std::weak_ptr<RcuMap<int, GatedValue>::map_type const> held = map.snapshot();
+
+    // 没有读者时, 发布后旧版本当场释放, 不必等线程退出或攒满一批
+    map.insert_or_assign(1, GatedValue(1));
+    EXPECT_TRUE(held.expired());
+
+    held = map.snapshot();
+    std::thread reader([&map]() {
+        GatedValue value;
+        map.find(0, value);
+    });
+    while (!GatedValue::entered) std::this_thread::yield();
+    map.insert_or_assign(2, GatedValue(2));
+    EXPECT_FALSE(held.expired()); // 读者还在这个版本上
+    GatedValue::released = true;
+    reader.join();
+
+    std::weak_ptr<RcuMap<int, GatedValue>::map_type const> previous = map.snapshot();
+    map.insert_or_assign(3, GatedValue(3)); // 下一次发布时一并释放
+    EXPECT_TRUE(held.expired());
+    EXPECT_TRUE(previous.expired());
+    EXPECT_EQ(map.size(), 4u);
+}
+
+TEST(test_concurrent_cache, clock_eviction_ttl_and_stats) {
+    // 单分片, 容量 4: 访问过的 1, 2 各躲过一次, 淘汰没被访问的 3
+    ConcurrentCache<int, int> clock(4, std::chrono::seconds(0), nullptr, 1);
+    for (int i = 1; i <= 4; ++i) clock.put(i, i * 10);
+    EXPECT_EQ(clock.value_for(1), 10);
+    EXPECT_EQ(clock.value_for(2), 20);
+    clock.put(5, 50);
+    int value = 0;
+    EXPECT_FALSE(clock.get(3, value));
+    EXPECT_TRUE(clock.get(4, value));
+    EXPECT_EQ(value, 40);
+    EXPECT_EQ(clock.size(), 4u);
+    CacheStats stats = clock.stats();
+    EXPECT_EQ(stats.hits, 3u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.evictions, 1u);
+
+    // 按字节计: 超过分片容量的条目不缓存, 放入大条目可一次淘汰多个小条目
+    ConcurrentCache<int, std::string> bytes(
+        8, std::chrono::seconds(0), [](int const &, std::string const &value_) { return value_.size(); }, 1);
+    EXPECT_FALSE(bytes.put(0, "123456789"));
+    EXPECT_TRUE(bytes.put(1, "aa"));
+    EXPECT_TRUE(bytes.put(2, "bb"));
+    EXPECT_TRUE(bytes.put(3, "ccccccc"));
+    EXPECT_EQ(bytes.usage(), 7u);
+    EXPECT_EQ(bytes.value_for(3), "ccccccc");
+    EXPECT_EQ(bytes.stats().evictions, 2u);
+
+    // 过期即未命中并删除
+    ConcurrentCache<int, int> ttl(8, std::chrono::milliseconds(20));
+    ttl.put(1, 1);
+    EXPECT_TRUE(ttl.get(1, value));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_FALSE(ttl.get(1, value));
+    EXPECT_EQ(ttl.size(), 0u);
+    EXPECT_EQ(ttl.stats().expirations, 1u);
+
+    // 并发读穿: 值总是对的, 容量不超, 命中加未命中等于查询次数
+    constexpr int             kThreads = 4, kLookups = 2000, kKeys = 64;
+    ConcurrentCache<int, int> cache(32, std::chrono::seconds(0), nullptr, 4);
+    std::atomic<int>          wrong(0);
+    std::vector<std::thread>  threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&cache, &wrong, t]() {
+            std::mt19937 rng(t);
+            for (int i = 0; i < kLookups; ++i) {
+                int const key = static_cast<int>(rng() % kKeys);
+                if (cache.get_or_load(key, [](int key_) { return key_ * 3; }) != key * 3) ++wrong;
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    stats = cache.stats();
+    EXPECT_EQ(wrong, 0);
+    EXPECT_LE(cache.size(), 32u);
+    EXPECT_EQ(stats.hits + stats.misses, static_cast<std::uint64_t>(kThreads * kLookups));
+    EXPECT_GT(stats.hits, 0u);
+    EXPECT_GT(stats.evictions, 0u);
+}
+
+TEST(test_concurrent_cache, capacity_is_exact) {
+    // 默认分片数比容量多时按容量收缩, 总数不超过容量
+    ConcurrentCache<int, int> small(4);
+    for (int i = 0; i < 100; ++i) small.put(i, i);
+    EXPECT_EQ(small.size(), 4u);
+
+    // 余数分给前几个分片, 各分片之和等于容量
+    ConcurrentCache<int, int> uneven(50, std::chrono::seconds(0), nullptr, 23);
+    for (int i = 0; i < 1000; ++i) uneven.put(i, i);
+    EXPECT_EQ(uneven.size(), 50u);
+
+    // 分片数为 0 按 1 处理
+    ConcurrentCache<int, int> single(3, std::chrono::seconds(0), nullptr, 0);
+    for (int i = 0; i < 10; ++i) single.put(i, i);
+    EXPECT_EQ(single.size(), 3u);
+
+    // 权重为 0 的条目按 1 计, 条目数仍受容量限制
+    ConcurrentCache<int, int> weightless(
+        3, std::chrono::seconds(0), [](int const &, int const &) { return std::size_t(0); }, 1);
+    for (int i = 0; i < 10; ++i) EXPECT_TRUE(weightless.put(i, i));
+    EXPECT_EQ(weightless.size(), 3u);
+    EXPECT_EQ(weightless.usage(), 3u);
+    EXPECT_EQ(weightless.stats().evictions, 7u);
+}
+
+TEST(test_task_trace, ring_never_yields_torn_records) {
+    // 4 个槽位, 多个线程不停绕圈覆盖; 每条记录各字段取同一个值, 读出的记录若字段不一致就是交错写入
+    constexpr int            kWriters = 4, kPerWriter = 20000;
+    trace::detail::Ring      ring(4);
+    std::atomic<bool>        done(false);
+    std::atomic<int>         torn(0);
+    std::vector<std::thread> writers;
+    for (int w = 0; w < kWriters; ++w) {
+        writers.emplace_back([&ring, w]() {
+            for (std::uint64_t i = 1; i <= kPerWriter; ++i) {
+                trace::TaskRecord record;
+                record.submitNs = record.startNs = record.endNs = i * kWriters + w;
+                record.worker                                   = static_cast<std::uint32_t>(w);
+                ring.push(record);
+            }
+        });
+    }
+    std::thread reader([&]() {
+        std::vector<trace::TaskRecord> records;
+        while (!done.load(std::memory_order_relaxed)) {
+            records.clear();
+            ring.collect(records);
+            for (auto const &r : records) {
+                if (r.startNs != r.submitNs || r.endNs != r.submitNs || r.submitNs % kWriters != r.worker) ++torn;
+            }
+        }
+    });
+    for (auto &t : writers) t.join();
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(torn.load(), 0);
+    std::vector<trace::TaskRecord> records;
+    ring.collect(records);
+    EXPECT_FALSE(records.empty());
+    EXPECT_LE(records.size(), 4u);
+}
+
+TEST(test_task_trace, tracer_records_and_chrome_export) {
+    trace::TaskTracer tracer(2, 8);
+    std::thread       worker([&]() {
+        tracer.bind_worker(1);
+        auto own = tracer.wrap([]() { return 1; });
+        EXPECT_EQ(own(), 1);
+        auto inner = tracer.wrap([]() {});
+        auto outer = tracer.wrap([&inner]() { inner(); }); // 窃取来的任务里再执行的任务不算窃取
+        trace::StolenScope scope;
+        outer();
+    });
+    worker.join();
+    auto external = tracer.wrap([]() {});
+    external(); // 未绑定的线程
+    std::vector<trace::TaskRecord> records = tracer.records();
+    if (!trace::TaskTracer::enabled()) {
+        EXPECT_TRUE(records.empty());
+        return;
+    }
+
+    ASSERT_EQ(records.size(), 4u);
+    std::uint32_t const externalWorker = trace::TaskTracer::kExternalWorker;
+    EXPECT_EQ(records[0].worker, 1u);
+    EXPECT_FALSE(records[0].stolen);
+    EXPECT_EQ(records[1].worker, 1u); // outer
+    EXPECT_TRUE(records[1].stolen);
+    EXPECT_EQ(records[2].worker, 1u); // inner
+    EXPECT_FALSE(records[2].stolen);
+    EXPECT_LE(records[2].endNs, records[1].endNs);
+    EXPECT_EQ(records[3].worker, externalWorker);
+    EXPECT_FALSE(records[3].stolen);
+    for (auto const &r : records) {
+        EXPECT_LE(r.submitNs, r.startNs);
+        EXPECT_LE(r.startNs, r.endNs);
+    }
+
+    std::ostringstream out;
+    trace::write_chrome_trace(out, {{"demo \"pool\"", &tracer}});
+    std::string const json = out.str();
+    auto const        count = [&json](std::string const &needle_) {
+        std::size_t n = 0;
+        for (std::size_t pos = json.find(needle_); pos != std::string::npos; pos = json.find(needle_, pos + 1)) ++n;
+        return n;
+    };
+    EXPECT_EQ(count("\"ph\":\"X\""), 4u);
+    EXPECT_EQ(count("\"ph\":\"b\""), 4u);
+    EXPECT_EQ(count("\"stolen\":true"), 1u);
+    EXPECT_NE(json.find("\"name\":\"demo \\\"pool\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"external\""), std::string::npos);
+
+    // 缓冲区写满后只保留最近的记录
+    std::thread refill([&]() {
+        tracer.bind_worker(0);
+        for (int i = 0; i < 20; ++i) tracer.wrap([]() {})();
+    });
+    refill.join();
+    EXPECT_EQ(tracer.records().size(), 4u + 8u);
+    tracer.clear();
+    EXPECT_TRUE(tracer.records().empty());
+}
+
+TEST(test_task_trace, steal_pool_records) {
+    constexpr int      kTasks = 200;
+    StealThreadPool   &pool   = StealThreadPool::instance();
+    trace::TaskTracer &tracer = pool.tracer();
+    tracer.clear();
+    WaitGroup        group;
+    std::atomic<int> ran(0);
+    for (int i = 0; i < kTasks; ++i) {
+        group.add();
+        pool.post([&]() {
+            ++ran;
+            group.done();
+        });
+    }
+    group.wait([&pool]() { return pool.run_pending_task(); });
+    EXPECT_EQ(ran.load(), kTasks);
+    std::vector<trace::TaskRecord> records = tracer.records();
+    if (!trace::TaskTracer::enabled()) {
+        EXPECT_TRUE(records.empty());
+        return;
+    }
+    // group.done() 在记录写入之前, 等最后几条落盘
+    for (int spin = 0; records.size() < static_cast<std::size_t>(kTasks) && spin < 1000; ++spin) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        records = tracer.records();
+    }
+    ASSERT_EQ(records.size(), static_cast<std::size_t>(kTasks));
+    std::uint32_t const externalWorker = trace::TaskTracer::kExternalWorker;
+    for (auto const &r : records) {
+        EXPECT_TRUE(r.worker < pool.thread_count() || r.worker == externalWorker);
+        EXPECT_FALSE(r.worker == externalWorker && r.stolen);
+        EXPECT_LE(r.submitNs, r.startNs);
+        EXPECT_LE(r.startNs, r.endNs);
+    }
+}
+
+TEST(test_profiled_mutex, containers_report_contention) {
+    constexpr int kThreads   = 4;
+    constexpr int kPerThread = 2000;
+    lock_profile::reset();
+
+    ThreadSafeQueue<int, ProfiledMutex<>>   queue;
+    CircularQueue<int, 64, ProfiledMutex<>> ring;
+    std::atomic<int>                        popped(0);
+    std::vector<std::thread>                threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kPerThread; ++i) {
+                queue.push(i);
+                int value = 0;
+                if (queue.try_pop(value)) ++popped;
+                ring.push(i);
+                ring.pop(value);
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    int value = 0;
+    while (queue.try_pop(value)) ++popped;
+    EXPECT_EQ(popped.load(), kThreads * kPerThread);
+
+    std::vector<lock_profile::LockReport> const reports = lock_profile::report();
+    auto find = [&reports](std::string const &name_) {
+        auto it = std::find_if(reports.begin(), reports.end(),
+                               [&name_](lock_profile::LockReport const &r_) { return r_.name == name_; });
+        return it == reports.end() ? lock_profile::LockReport() : *it;
+    };
+    lock_profile::LockReport const head       = find("ThreadSafeQueue::head");
+    lock_profile::LockReport const ringReport = find("CircularQueue");
+    EXPECT_GE(head.acquisitions, static_cast<std::uint64_t>(kThreads * kPerThread));
+    EXPECT_GE(ringReport.acquisitions, static_cast<std::uint64_t>(2 * kThreads * kPerThread));
+    for (auto const &r : reports) {
+        EXPECT_LE(r.contended, r.acquisitions);
+        EXPECT_GE(r.maxHoldNs * r.acquisitions, r.holdNs);
+        if (r.contended == 0) {
+            EXPECT_EQ(r.waitNs, 0u);
+        }
+    }
+    for (std::size_t i = 1; i < reports.size(); ++i) EXPECT_GE(reports[i - 1].waitNs, reports[i].waitNs);
+
+    std::ostringstream out;
+    lock_profile::write_report(out);
+    EXPECT_NE(out.str().find("ThreadSafeQueue::tail"), std::string::npos);
+}
+
+TEST(test_profiled_mutex, list_nodes_do_not_query_registry) {
+    constexpr int kNodes = 1000;
+    {
+        ThraedSafeList<int, ProfiledMutex<>> warmup; // 第一次建结点 / 未命名的锁时查表并缓存
+        ProfiledMutex<>                      unnamed;
+        warmup.push_back(0);
+    }
+    std::uint64_t const before = lock_profile::Registry::instance().lookups();
+    {
+        ThraedSafeList<int, ProfiledMutex<>> list;
+        ProfiledMutex<>                      unnamed;
+        for (int i = 0; i < kNodes; ++i) {
+            list.push_front(i);
+            list.push_back(i);
+        }
+        list.insert_if([](int value_) { return value_ == 0; }, -1);
+        std::lock_guard<ProfiledMutex<>> lock(unnamed);
+    }
+    // 只有链表尾指针的锁按名字查了一次
+    EXPECT_LE(lock_profile::Registry::instance().lookups() - before, 1u);
+
+    std::vector<lock_profile::LockReport> const reports = lock_profile::report();
+    auto const node = std::find_if(reports.begin(), reports.end(), [](lock_profile::LockReport const &r_) {
+        return r_.name == "ThraedSafeList::node";
+    });
+    ASSERT_NE(node, reports.end());
+    EXPECT_GE(node->acquisitions, static_cast<std::uint64_t>(2 * kNodes));
+}
+
+#ifdef CO_TASK_ENABLED
+CoTask<int> co_square(int value_) { co_return value_ *value_; }
+
+template <typename Scheduler>
+CoTask<int> co_sum_squares(int count_, Scheduler &executor_) {
+    std::vector<CoTask<int>> children;
+    for (int i = 0; i < count_; ++i) {
+        children.push_back(spawn(co_square(i), executor_));
+    }
+    int sum = 0;
+    for (auto &child : children) {
+        sum += co_await child;
+    }
+    co_return sum;
+}
+
+/// @brief 每层 co_await 一个未启动的子任务, 对称转移下链再深也不增长栈
+CoTask<long> co_chain(int depth_) {
+    if (depth_ == 0) co_return 0;
+    co_return 1 + co_await co_chain(depth_ - 1);
+}
+
+CoTask<void> co_throw_on_pool(Executor &executor_) {
+    co_await schedule_on(executor_);
+    throw std::runtime_error("co boom");
+}
+
+TEST(test_co_task, spawn_and_await) {
+    EXPECT_EQ(sync_wait(co_sum_squares(100, default_executor())), 328350);
+    EXPECT_EQ(sync_wait(co_chain(10000)), 10000);
+    EXPECT_THROW(sync_wait(co_throw_on_pool(default_executor())), std::runtime_error);
+
+    // schedule_on 之后在执行器的线程上继续 (ThreadExecutor 不会被 sync_wait 拉回调用线程执行)
+    std::thread::id const caller = std::this_thread::get_id();
+    auto                  where  = [](Executor &executor_) -> CoTask<std::thread::id> {
+        co_await schedule_on(executor_);
+        co_return std::this_thread::get_id();
+    };
+    EXPECT_NE(sync_wait(where(ThreadExecutor::instance())), caller);
+    EXPECT_EQ(sync_wait(co_sum_squares(10, StealThreadPool::instance()), StealThreadPool::instance()), 285);
+
+    // spawn 后不等待就析构, 任务结束时自行销毁
+    std::atomic<bool> ran(false);
+    auto              flag = [](std::atomic<bool> &ran_) -> CoTask<void> {
+        ran_ = true;
+        co_return;
+    };
+    spawn(flag(ran), default_executor());
+    while (!ran.load()) {
+        std::this_thread::yield();
+    }
+}
+#endif
+
 int main() {
 
     set_random();
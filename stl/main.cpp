@@ -8,11 +8,18 @@
 
 #include "parallel_find.cpp"
 #include "parallel_for_each.cpp"
+#include "parallel_sort.cpp"
 #include "partial_sum.cpp"
+#include "transform_reduce.cpp"
 #include "gtest/gtest.h"
+#include <atomic>
 #include <cstdint>
 #include <iostream>
+#include <limits>
+#include <list>
+#include <numeric>
 #include <random>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -33,7 +40,7 @@ void set_random_tests() {
 }
 
 void print_results(std::vector<int64_t> const &res) {
-    for (const &elem : res) {
+    for (auto const &elem : res) {
         std::cout << elem << " ";
     }
     spdlog::error("print end...");
@@ -101,6 +108,452 @@ TEST(sum, partial_sum) {
     }
     spdlog::info("\n");
 }
+/// @brief 三种划分策略下结果都应与串行版本一致, 固定4个线程以便在单核机器上也走并行路径
+std::vector<Partitioner> all_partitioners() {
+    return {Partitioner(PartitionKind::Static, 3, 4), Partitioner(PartitionKind::Dynamic, 2, 4),
+            Partitioner(PartitionKind::Auto, 1, 4)};
+}
+
+TEST(partitioner, plan_covers_range) {
+    for (auto const &partitioner : all_partitioners()) {
+        for (std::size_t length : {1, 7, 100, 4097}) {
+            PartitionPlan const plan = partitioner.plan(length);
+            EXPECT_GE(plan.workerCount, 1u);
+            EXPECT_LE(plan.workerCount, plan.chunkCount);
+            EXPECT_EQ(plan.chunk_begin(0), 0u);
+            EXPECT_EQ(plan.chunk_end(plan.chunkCount - 1), length);
+            for (std::size_t i = 1; i < plan.chunkCount; ++i) {
+                EXPECT_EQ(plan.chunk_end(i - 1), plan.chunk_begin(i));
+            }
+        }
+    }
+}
+
+TEST(partitioner, uneven_for_each) {
+    std::vector<int64_t> expected(1000);
+    std::iota(expected.begin(), expected.end(), 0);
+    for (auto &elem : expected)
+        elem *= elem;
+    for (auto const &partitioner : all_partitioners()) {
+        std::vector<int64_t> datas(1000);
+        std::iota(datas.begin(), datas.end(), 0);
+        parallel_for_each(
+            datas.begin(), datas.end(),
+            [](int64_t &i) {
+                if (i % 97 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200)); // 不均匀的耗时
+                i *= i;
+            },
+            partitioner);
+        EXPECT_EQ(datas, expected);
+
+        // 非随机访问迭代器: 各块起点一次遍历求出
+        std::list<int64_t> listDatas(1000);
+        std::iota(listDatas.begin(), listDatas.end(), 0);
+        parallel_for_each(listDatas.begin(), listDatas.end(), [](int64_t &i) { i *= i; }, partitioner);
+        EXPECT_TRUE(std::equal(listDatas.begin(), listDatas.end(), expected.begin()));
+    }
+}
+
+TEST(partitioner, find_and_partial_sum) {
+    for (auto const &partitioner : all_partitioners()) {
+        std::vector<int64_t> datas(500);
+        std::iota(datas.begin(), datas.end(), 1);
+        auto iter = parallel_find(datas.begin(), datas.end(), 321, partitioner);
+        ASSERT_NE(iter, datas.end());
+        EXPECT_EQ(*iter, 321);
+        EXPECT_EQ(parallel_find(datas.begin(), datas.end(), -1, partitioner), datas.end());
+
+        std::vector<int64_t> expected(datas.size());
+        std::partial_sum(datas.begin(), datas.end(), expected.begin());
+        paraller_partial_sum(datas.begin(), datas.end(), partitioner);
+        EXPECT_EQ(datas, expected);
+
+        // 非随机访问迭代器: 各块起点一次遍历求出
+        std::list<int64_t> listDatas(500);
+        std::iota(listDatas.begin(), listDatas.end(), 1);
+        auto listIter = parallel_find(listDatas.begin(), listDatas.end(), 321, partitioner);
+        ASSERT_NE(listIter, listDatas.end());
+        EXPECT_EQ(*listIter, 321);
+        EXPECT_EQ(std::distance(listDatas.begin(), listIter), 320);
+        EXPECT_EQ(parallel_find(listDatas.begin(), listDatas.end(), -1, partitioner), listDatas.end());
+        paraller_partial_sum(listDatas.begin(), listDatas.end(), partitioner);
+        EXPECT_TRUE(std::equal(listDatas.begin(), listDatas.end(), expected.begin()));
+    }
+}
+
+/// @brief 覆盖 SIMD 路径(int32/uint32/float)与标量路径(int64), 长度取不是4的倍数的值
+template <typename T>
+void check_scans(std::size_t length_) {
+    std::vector<T> datas(length_);
+    for (std::size_t i = 0; i < length_; ++i)
+        datas[i] = static_cast<T>(i % 13);
+    std::vector<T> inclusive(length_), exclusive(length_);
+    std::partial_sum(datas.begin(), datas.end(), inclusive.begin());
+    T running = T(7);
+    for (std::size_t i = 0; i < length_; ++i) {
+        exclusive[i] = running;
+        running += datas[i];
+    }
+
+    for (auto const &partitioner : all_partitioners()) {
+        std::vector<T> out(length_);
+        EXPECT_EQ(parallel_inclusive_scan(datas.begin(), datas.end(), out.begin(), std::plus<>(), partitioner),
+                  out.end());
+        EXPECT_EQ(out, inclusive);
+        parallel_exclusive_scan(datas.begin(), datas.end(), out.begin(), T(7), std::plus<>(), partitioner);
+        EXPECT_EQ(out, exclusive);
+
+        std::vector<T> inPlace(datas);
+        parallel_exclusive_scan(inPlace.begin(), inPlace.end(), inPlace.begin(), T(7), std::plus<T>(), partitioner);
+        EXPECT_EQ(inPlace, exclusive);
+        inPlace = datas;
+        paraller_partial_sum(inPlace.begin(), inPlace.end(), partitioner);
+        EXPECT_EQ(inPlace, inclusive);
+    }
+}
+
+TEST(scan, matches_serial) {
+    for (std::size_t length : {1, 5, 1003}) {
+        check_scans<int32_t>(length);
+        check_scans<uint32_t>(length);
+        check_scans<float>(length);
+        check_scans<int64_t>(length);
+    }
+}
+
+TEST(scan, associative_non_commutative_op) {
+    std::list<std::string> words;
+    for (int i = 0; i < 200; ++i)
+        words.push_back(std::string(1, static_cast<char>('a' + i % 26)));
+    std::vector<std::string> expected(words.size());
+    std::partial_sum(words.begin(), words.end(), expected.begin());
+
+    for (auto const &partitioner : all_partitioners()) {
+        std::vector<std::string> out(words.size());
+        parallel_inclusive_scan(words.begin(), words.end(), out.begin(), std::plus<std::string>(), partitioner);
+        EXPECT_EQ(out, expected);
+        // 取最大值也满足结合律
+        std::vector<int> values{3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9};
+        std::vector<int> maxes(values.size());
+        parallel_inclusive_scan(
+            values.begin(), values.end(), maxes.begin(), [](int a, int b) { return std::max(a, b); }, partitioner);
+        EXPECT_EQ(maxes, (std::vector<int>{3, 3, 4, 4, 5, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9}));
+    }
+}
+
+/// @brief 多处命中时应返回第一个, 命中位置跨越轮询步长与块边界
+template <typename T>
+void check_finds(std::size_t length_) {
+    std::vector<T> datas(length_);
+    for (std::size_t i = 0; i < length_; ++i)
+        datas[i] = static_cast<T>(i % 100);
+    for (auto const &partitioner : all_partitioners()) {
+        for (std::size_t target : {std::size_t(0), length_ / 3, length_ - 1}) {
+            std::vector<T> hay(datas);
+            hay[target]                                = T(123);
+            hay[std::min(length_ - 1, target + 40000)] = T(123);
+            auto expected = std::find(hay.begin(), hay.end(), T(123));
+            EXPECT_EQ(parallel_find(hay.begin(), hay.end(), T(123), partitioner), expected);
+            EXPECT_EQ(parallel_find(hay.begin(), hay.end(), 123, partitioner), expected);
+            EXPECT_EQ(parallel_find_if(
+                          hay.begin(), hay.end(), [](T v) { return v > T(100); }, partitioner),
+                      expected);
+        }
+        EXPECT_EQ(parallel_find(datas.begin(), datas.end(), T(100), partitioner), datas.end());
+    }
+}
+
+TEST(find, first_match_is_deterministic) {
+    for (std::size_t length : {1, 33, 100003}) {
+        check_finds<int32_t>(length);
+        check_finds<uint32_t>(length);
+        check_finds<int64_t>(length);
+        check_finds<double>(length);
+        check_finds<int16_t>(length);
+    }
+    // -1 与 uint32_t 比较时按无符号转换, SIMD 路径须一致
+    std::vector<uint32_t> datas(1000, 7);
+    datas[600] = 0xFFFFFFFFu;
+    EXPECT_EQ(parallel_find(datas.begin(), datas.end(), -1) - datas.begin(), 600);
+
+    std::list<int> values(5000, 1);
+    *std::next(values.begin(), 4321) = 2;
+    for (auto const &partitioner : all_partitioners()) {
+        EXPECT_EQ(std::distance(values.begin(), parallel_find(values.begin(), values.end(), 2, partitioner)), 4321);
+    }
+}
+
+TEST(find, async_find_respects_flag) {
+    std::vector<int32_t> datas(100000, 1);
+    datas[77777] = 5;
+    std::atomic<bool> done(true);
+    EXPECT_EQ(async_find(datas.begin(), datas.end(), 5, done), datas.end());
+    done.store(false);
+    EXPECT_EQ(async_find(datas.begin(), datas.end(), 5, done) - datas.begin(), 77777);
+    EXPECT_TRUE(done.load());
+}
+
+/// @brief 覆盖 SIMD 求和/内积 (int32/uint64/float/double) 与标量路径, 整数值保证浮点结果精确
+template <typename T>
+void check_reduces(std::size_t length_) {
+    std::vector<T> datas(length_), weights(length_);
+    for (std::size_t i = 0; i < length_; ++i) {
+        datas[i]   = static_cast<T>(i % 17);
+        weights[i] = static_cast<T>(i % 3);
+    }
+    T const sum = std::accumulate(datas.begin(), datas.end(), T(5));
+    T const dot = std::inner_product(datas.begin(), datas.end(), weights.begin(), T(5));
+
+    for (auto const &partitioner : all_partitioners()) {
+        EXPECT_EQ(parallel_reduce(datas.begin(), datas.end(), T(5), std::plus<>(), partitioner), sum);
+        EXPECT_EQ(parallel_transform_reduce(datas.data(), datas.data() + length_, T(5), std::plus<T>(), Identity(),
+                                            partitioner),
+                  sum);
+        EXPECT_EQ(parallel_transform_reduce(datas.begin(), datas.end(), weights.begin(), T(5), std::plus<>(),
+                                            std::multiplies<>(), partitioner),
+                  dot);
+        // 非恒等变换走标量路径
+        EXPECT_EQ(parallel_transform_reduce(
+                      datas.begin(), datas.end(), T(5), std::plus<>(), [](T v) { return v + v; }, partitioner),
+                  T(2) * sum - T(5));
+        // 非随机访问迭代器: 两个区间各自一次遍历求出块起点
+        std::list<T> const listDatas(datas.begin(), datas.end()), listWeights(weights.begin(), weights.end());
+        EXPECT_EQ(parallel_transform_reduce(listDatas.begin(), listDatas.end(), listWeights.begin(), T(5),
+                                            std::plus<>(), std::multiplies<>(), partitioner),
+                  dot);
+    }
+}
+
+TEST(transform_reduce, matches_serial) {
+    for (std::size_t length : {1, 7, 1003}) {
+        check_reduces<int32_t>(length);
+        check_reduces<uint64_t>(length);
+        check_reduces<float>(length);
+        check_reduces<double>(length);
+        check_reduces<int16_t>(length);
+    }
+    std::vector<int32_t> empty;
+    EXPECT_EQ(parallel_reduce(empty.begin(), empty.end(), 42), 42);
+}
+
+TEST(transform_reduce, non_commutative_reduce) {
+    std::list<int> digits;
+    for (int i = 0; i < 300; ++i)
+        digits.push_back(i % 10);
+    std::string expected = "#";
+    for (int digit : digits)
+        expected += std::to_string(digit);
+    for (auto const &partitioner : all_partitioners()) {
+        EXPECT_EQ(parallel_transform_reduce(
+                      digits.begin(), digits.end(), std::string("#"), std::plus<std::string>(),
+                      [](int digit) { return std::to_string(digit); }, partitioner),
+                  expected);
+    }
+}
+
+/// @brief 转发给默认执行器, 但声称有4个线程, 让单核机器上也走并行划分
+class FourWayExecutor : public Executor {
+public:
+    void        post(FunctionWrapper task_) override { default_executor().post(std::move(task_)); }
+    bool        run_pending_task() override { return default_executor().run_pending_task(); }
+    std::size_t concurrency() const override { return 4; }
+};
+
+TEST(sort, matches_std_sort) {
+    std::mt19937    engine(42);
+    FourWayExecutor fourWay;
+    for (std::size_t length : {0, 1, 2, 25, 1000, 100000, 3000000}) {
+        for (int distinct : {1, 3, 1 << 30}) { // 全相等 / 大量重复 / 基本不重复
+            std::uniform_int_distribution<int> u(0, distinct - 1);
+            std::vector<int>                   datas(length);
+            for (auto &elem : datas)
+                elem = u(engine);
+            std::vector<int> expected(datas);
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<int> sorted(datas);
+            parallel_sort(sorted.begin(), sorted.end(), std::less<>(), fourWay);
+            EXPECT_EQ(sorted, expected);
+
+            std::sort(expected.begin(), expected.end(), std::greater<int>());
+            parallel_sort(datas.begin(), datas.end(), std::greater<int>());
+            EXPECT_EQ(datas, expected);
+        }
+    }
+
+    // 已排序与逆序输入
+    std::vector<int64_t> ascending(200000);
+    std::iota(ascending.begin(), ascending.end(), 0);
+    std::vector<int64_t> descending(ascending.rbegin(), ascending.rend());
+    parallel_sort(descending.begin(), descending.end());
+    EXPECT_EQ(descending, ascending);
+
+    std::vector<std::string> words{"pear", "apple", "fig", "kiwi", "banana", "apple", "cherry"};
+    parallel_sort(words.begin(), words.end());
+    EXPECT_TRUE(std::is_sorted(words.begin(), words.end()));
+}
+
+TEST(sort, parallel_partition) {
+    FourWayExecutor  fourWay;
+    std::vector<int> datas(2000000);
+    std::mt19937     engine(7);
+    for (auto &elem : datas)
+        elem = static_cast<int>(engine() % 1000);
+    auto const isSmall = [](int value_) { return value_ < 300; };
+    auto const count   = std::count_if(datas.begin(), datas.end(), isSmall);
+    auto const cut     = sort_detail::parallel_partition(datas.begin(), datas.end(), isSmall, fourWay);
+    EXPECT_EQ(cut - datas.begin(), count);
+    EXPECT_TRUE(std::is_partitioned(datas.begin(), datas.end(), isSmall));
+}
+
+/// @brief 只按 key 比较, 用 index 检查相等元素是否保持原有顺序
+struct KeyedItem {
+    int         key;
+    std::size_t index;
+    bool        operator==(KeyedItem const &other_) const { return key == other_.key && index == other_.index; }
+};
+bool by_key(KeyedItem const &a_, KeyedItem const &b_) { return a_.key < b_.key; }
+
+TEST(sort, stable_sort_and_merge) {
+    std::mt19937           engine(11);
+    FourWayExecutor        fourWay;
+    std::vector<KeyedItem> scratch; // 多次排序复用
+    for (std::size_t length : {0, 1, 30, 5000, 300000}) {
+        std::vector<KeyedItem> datas(length);
+        for (std::size_t i = 0; i < length; ++i)
+            datas[i] = KeyedItem{static_cast<int>(engine() % 100), i};
+        std::vector<KeyedItem> expected(datas);
+        std::stable_sort(expected.begin(), expected.end(), by_key);
+
+        std::vector<KeyedItem> sorted(datas);
+        parallel_stable_sort(sorted.begin(), sorted.end(), scratch, by_key, fourWay);
+        EXPECT_EQ(sorted, expected);
+        sorted = datas;
+        parallel_stable_sort(sorted.begin(), sorted.end(), by_key);
+        EXPECT_EQ(sorted, expected);
+
+        // 两半分别排序后合并, 相等时左半在前
+        std::size_t const half = length / 3;
+        std::stable_sort(datas.begin(), datas.begin() + half, by_key);
+        std::stable_sort(datas.begin() + half, datas.end(), by_key);
+        std::vector<KeyedItem> merged(length), mergedExpected(length);
+        std::merge(datas.begin(), datas.begin() + half, datas.begin() + half, datas.end(), mergedExpected.begin(),
+                   by_key);
+        EXPECT_EQ(parallel_merge(datas.begin(), datas.begin() + half, datas.begin() + half, datas.end(),
+                                 merged.begin(), by_key, fourWay),
+                  merged.end());
+        EXPECT_EQ(merged, mergedExpected);
+    }
+    EXPECT_GE(scratch.size(), 300000u);
+}
+
+TEST(sort, kway_merge) {
+    std::mt19937    engine(5);
+    FourWayExecutor fourWay;
+
+    std::vector<KeyedItem>                           datas;
+    std::vector<std::pair<std::size_t, std::size_t>> bounds;
+    for (std::size_t run = 0; run < 7; ++run) {
+        std::size_t const length = run == 3 ? 0 : 20000 * (run + 1); // 包含一个空段
+        std::size_t const begin  = datas.size();
+        for (std::size_t i = 0; i < length; ++i)
+            datas.push_back(KeyedItem{static_cast<int>(engine() % 50), datas.size()});
+        std::stable_sort(datas.begin() + begin, datas.end(), by_key);
+        bounds.emplace_back(begin, datas.size());
+    }
+    // 各段按段序拼接后稳定排序, 即稳定多路合并的结果
+    std::vector<KeyedItem> expected(datas);
+    std::stable_sort(expected.begin(), expected.end(), by_key);
+
+    using Iter = std::vector<KeyedItem>::const_iterator;
+    std::vector<std::pair<Iter, Iter>> runs;
+    for (auto const &bound : bounds)
+        runs.emplace_back(datas.cbegin() + bound.first, datas.cbegin() + bound.second);
+    for (Executor *executor : {static_cast<Executor *>(&fourWay), &default_executor()}) {
+        std::vector<KeyedItem> merged(datas.size());
+        EXPECT_EQ(parallel_kway_merge(runs, merged.begin(), by_key, *executor), merged.end());
+        EXPECT_EQ(merged, expected);
+    }
+}
+
+template <typename T>
+void check_radix(std::vector<T> datas_, Executor &executor_) {
+    std::vector<T> expected(datas_);
+    std::sort(expected.begin(), expected.end());
+    parallel_radix_sort(datas_.begin(), datas_.end(), radix_detail::SelfKey(), executor_);
+    EXPECT_EQ(datas_, expected);
+}
+
+TEST(sort, radix_sort) {
+    std::mt19937_64 engine(3);
+    FourWayExecutor fourWay;
+    for (std::size_t length : {0, 1, 20, 1000, 300000}) {
+        std::vector<int64_t>  signedKeys(length);
+        std::vector<uint32_t> unsignedKeys(length);
+        std::vector<int16_t>  shortKeys(length);
+        std::vector<double>   doubleKeys(length);
+        std::vector<float>    floatKeys(length);
+        for (std::size_t i = 0; i < length; ++i) {
+            signedKeys[i]   = static_cast<int64_t>(engine());
+            unsignedKeys[i] = static_cast<uint32_t>(engine());
+            shortKeys[i]    = static_cast<int16_t>(engine());
+            doubleKeys[i]   = (static_cast<double>(engine() % 2000001) - 1000000.0) / 7.0;
+            floatKeys[i]    = static_cast<float>(doubleKeys[i]);
+        }
+        if (length > 10) {
+            doubleKeys[3] = std::numeric_limits<double>::infinity();
+            doubleKeys[4] = -std::numeric_limits<double>::infinity();
+            doubleKeys[5] = -0.0;
+            floatKeys[6]  = std::numeric_limits<float>::lowest();
+        }
+        for (Executor *executor : {static_cast<Executor *>(&fourWay), &default_executor()}) {
+            check_radix(signedKeys, *executor);
+            check_radix(unsignedKeys, *executor);
+            check_radix(shortKeys, *executor);
+            check_radix(doubleKeys, *executor);
+            check_radix(floatKeys, *executor);
+        }
+    }
+}
+
+TEST(sort, radix_sort_by_key_is_stable) {
+    // 时间戳只有低位不同, 高位各趟应被跳过
+    std::mt19937           engine(9);
+    std::vector<KeyedItem> records(200000);
+    for (std::size_t i = 0; i < records.size(); ++i)
+        records[i] = KeyedItem{static_cast<int>(engine() % 5000) - 2500, i};
+    std::vector<KeyedItem> expected(records);
+    std::stable_sort(expected.begin(), expected.end(), by_key);
+
+    FourWayExecutor fourWay;
+    parallel_radix_sort(
+        records.begin(), records.end(), [](KeyedItem const &item_) { return item_.key; }, fourWay);
+    EXPECT_EQ(records, expected);
+}
+
+TEST(sort, radix_sort_skips_constant_digits) {
+    // 多块划分下, 只有最低字节不同的键只做一趟分发: 每趟统计时取一次键, 分发时再取一次, 跳过的趟只取一次
+    std::size_t const     length = 4 * radix_detail::kRadixGrain;
+    std::mt19937_64       engine(13);
+    std::vector<uint64_t> keys(length);
+    for (auto &key : keys)
+        key = 0x0123456789abcd00ULL | (engine() & 0xff);
+    std::vector<uint64_t> expected(keys);
+    std::sort(expected.begin(), expected.end());
+
+    FourWayExecutor          fourWay;
+    std::atomic<std::size_t> keyCalls(0);
+    parallel_radix_sort(
+        keys.begin(), keys.end(),
+        [&keyCalls](uint64_t key_) {
+            keyCalls.fetch_add(1, std::memory_order_relaxed);
+            return key_;
+        },
+        fourWay);
+    EXPECT_EQ(keys, expected);
+    EXPECT_EQ(keyCalls.load(), (sizeof(uint64_t) + 1) * length);
+}
+
 int main() {
     set_random_tests();
 
@@ -1,108 +1,139 @@
 
+#include "threadPool/partitioner.hpp"
+#include "threadPool/simd.hpp"
+#include <algorithm>
 #include <atomic>
-#include <future>
-#include <iostream>
-#include <memory>
-#include <thread>
-#include <vector>
+#include <iterator>
+#include <type_traits>
 
-class JoinThread {
-public:
-    explicit JoinThread(std::vector<std::thread> &threads_)
-        : _threads(threads_) {}
-    ~JoinThread() {
-        for (unsigned long i = 0; i < _threads.size(); ++i) {
-            if (_threads[i].joinable()) _threads[i].join();
-        }
+namespace find_detail {
+
+/// @brief 每扫描这么多元素检查一次能否提前结束
+constexpr std::size_t kPollStride = 16384;
+
+/// @brief 连续存放的算术类型且按值比较时走 simd::find
+/// match 须与元素同类型, 或同为整数且不比元素宽 (此时 *it == match 与 *it == T(match) 等价)
+template <typename Iterator, typename MatchType, typename T = typename std::iterator_traits<Iterator>::value_type>
+using use_simd = std::integral_constant<
+    bool, simd::is_vectorizable<T>::value && is_contiguous_iterator<Iterator>::value &&
+              (std::is_same<MatchType, T>::value ||
+               (std::is_integral<MatchType>::value && std::is_integral<T>::value && sizeof(MatchType) <= sizeof(T)))>;
+
+/// @brief 在 [lo, hi) 中逐个判断, it 从 lo 处出发, 返回时停在命中处或 hi 处
+template <typename Iterator, typename Predicate>
+std::size_t scan_if(Iterator &it, std::size_t lo, std::size_t hi, Predicate &pred) {
+    for (; lo != hi; ++lo, ++it) {
+        if (pred(*it)) return lo;
     }
+    return hi;
+}
 
-private:
-    std::vector<std::thread> &_threads;
-};
+template <typename Iterator, typename MatchType>
+std::size_t scan_value(Iterator &it, std::size_t lo, std::size_t hi, MatchType const &match, std::false_type) {
+    for (; lo != hi; ++lo, ++it) {
+        if (*it == match) return lo;
+    }
+    return hi;
+}
 
-/// @brief 划分数据区间给n个线程去查找
-/// @tparam Iterator
-/// @tparam MatchType
-/// @param first
-/// @param last
-/// @param match
-/// @return
 template <typename Iterator, typename MatchType>
-Iterator parallel_find(Iterator first, Iterator last, MatchType match) {
+std::size_t scan_value(Iterator &it, std::size_t lo, std::size_t hi, MatchType const &match, std::true_type) {
+    using valueType          = typename std::iterator_traits<Iterator>::value_type;
+    std::size_t const offset = simd::find(&*it, hi - lo, static_cast<valueType>(match));
+    it += offset;
+    return lo + offset;
+}
 
-    // find elem if exitst
-    struct find_element {
+/// @brief 返回第一个命中位置, 与线程调度无关
+/// 命中时用 CAS 把 best 压到更小的下标; 每扫描 kPollStride 个元素检查一次,
+/// 已扫到 best 之后或 stopFlag_ 被置位时放弃剩余部分. best 之前的部分一定会被扫完, 所以结果确定.
+/// @tparam Scan std::size_t(Iterator &it, std::size_t lo, std::size_t hi), 返回 [lo, hi) 内第一个命中的下标或 hi
+template <typename Iterator, typename Scan>
+Iterator find_first(Iterator first, Iterator last, Scan scan, std::atomic<bool> *stopFlag_,
+                    Partitioner const &partitioner_, Executor &executor_) {
+    std::size_t const length = std::distance(first, last);
+    if (!length) return last;
 
-        void operator()(Iterator begin, Iterator end, MatchType match, std::promise<Iterator> *result,
-                        std::atomic<bool> *findDoneFlag) {
-            try {
-                for (; (begin != end) && !findDoneFlag->load(std::memory_order_acquire); ++begin) {
-                    if (*begin == match) {
-                        result->set_value(begin);
-                        findDoneFlag->store(true, std::memory_order_relaxed);
-                        return;
-                    }
-                }
-            } catch (const std::exception &e) {
-                try {
-                    result->set_exception(std::current_exception());
-                    findDoneFlag->store(true, std::memory_order_release);
+    PartitionPlan const         plan   = partitioner_.plan(length);
+    std::vector<Iterator> const starts = chunk_starts(plan, first);
+    std::atomic<std::size_t>    best(length);
+    run_partitioned(
+        plan,
+        [&](std::size_t chunk_, std::size_t begin_, std::size_t end_) {
+            Iterator it = starts[chunk_];
+            for (std::size_t lo = begin_; lo < end_; lo += kPollStride) {
+                if (lo >= best.load(std::memory_order_relaxed)) return;
+                if (stopFlag_ && stopFlag_->load(std::memory_order_relaxed)) return;
+
+                std::size_t const hi    = std::min(end_, lo + kPollStride);
+                std::size_t const found = scan(it, lo, hi);
+                if (found == hi) continue;
 
-                } catch (...) {
+                std::size_t current = best.load(std::memory_order_relaxed);
+                while (found < current && !best.compare_exchange_weak(current, found, std::memory_order_relaxed)) {
                 }
+                return;
             }
-        }
-    };
+        },
+        executor_);
+    std::size_t const result = best.load(std::memory_order_relaxed);
+    return result == length ? last : std::next(first, result);
+}
 
-    unsigned long const length          = std::distance(first, last);
-    unsigned long const minPerThread    = 25;
-    unsigned long const maxThreads      = (length + minPerThread - 1) / minPerThread;
-    unsigned long const hardwareThreads = std::thread::hardware_concurrency();
-    unsigned long const numThreads      = std::min(hardwareThreads != 0 ? hardwareThreads : 2, maxThreads);
-    unsigned long const blockSize       = length / numThreads;
+} // namespace find_detail
 
-    std::vector<std::thread> threads(numThreads - 1);
-    std::atomic<bool>        findDoneFlag(false);
-    std::promise<Iterator>   result;
-    {
-        JoinThread joinThreads(threads);
-        Iterator   blockStart = first;
-        for (unsigned long index = 0; index < (numThreads - 1); ++index) {
-            Iterator blockEnd = blockStart;
-            std::advance(blockEnd, blockSize);
-            threads[index] = std::thread(find_element(), blockStart, blockEnd, match, &result, &findDoneFlag);
-            blockStart     = blockEnd;
-        }
-        find_element()(blockStart, last, match, &result, &findDoneFlag);
-    }
-    if (!findDoneFlag.load(std::memory_order_relaxed)) {
-        return last;
-    }
-    return result.get_future().get();
+/// @brief 并行 find_if, 返回第一个满足 pred 的位置 (与串行 std::find_if 结果相同)
+/// @tparam Iterator  至少为前向迭代器
+/// @tparam Predicate
+/// @param first
+/// @param last
+/// @param pred
+/// @param partitioner
+/// @param executor
+/// @return
+template <typename Iterator, typename Predicate>
+Iterator parallel_find_if(Iterator first, Iterator last, Predicate pred, Partitioner partitioner = Partitioner(),
+                          Executor &executor = default_executor()) {
+    return find_detail::find_first(
+        first, last,
+        [&pred](Iterator &it, std::size_t lo, std::size_t hi) { return find_detail::scan_if(it, lo, hi, pred); },
+        nullptr, partitioner, executor);
 }
 
+/// @brief 划分数据区间给n个线程去查找, 返回第一个等于 match 的位置
+/// 连续存放的算术类型用 SIMD 比较, 大数组查找只受内存带宽限制
+/// @tparam Iterator
+/// @tparam MatchType
+/// @param first
+/// @param last
+/// @param match
+/// @param partitioner
+/// @param executor
+/// @return
 template <typename Iterator, typename MatchType>
-Iterator async_find(Iterator first, Iterator last, MatchType match, std::atomic<bool> &findDoneFlag) {
-    try {
-        unsigned long const length       = std::distance(first, last);
-        unsigned long const minPerThread = 30;
-        if (length < 2 * minPerThread) {
-            for (; (first != last) && !findDoneFlag.load(std::memory_order_acquire); ++first) {
-                if (*first == match) {
-                    findDoneFlag.store(true);
-                    return first;
-                }
-            }
-            return last;
-        } else {
-            Iterator              mid = first + (length / 2);
-            std::future<Iterator> asyncResult =
-                std::async(&async_find<Iterator, MatchType>, mid, last, match, std::ref(findDoneFlag));
-            Iterator const directResult = async_find(first, mid, match, findDoneFlag);
-            return (directResult == mid) ? asyncResult.get() : directResult;
-        }
-    } catch (const std::exception &e) {
-        std::cerr << e.what() << '\n';
-        throw;
-    }
-}
\ No newline at end of file
+Iterator parallel_find(Iterator first, Iterator last, MatchType match, Partitioner partitioner = Partitioner(),
+                       Executor &executor = default_executor()) {
+    using Simd = find_detail::use_simd<Iterator, MatchType>;
+    return find_detail::find_first(
+        first, last,
+        [&match](Iterator &it, std::size_t lo, std::size_t hi) {
+            return find_detail::scan_value(it, lo, hi, match, Simd());
+        },
+        nullptr, partitioner, executor);
+}
+
+/// @brief 与其他查找共享 findDoneFlag: 标记被置位后放弃剩余部分, 自己找到时置位
+/// 原先每次二分都 std::async 一个新线程, 现在与 parallel_find 共用线程池上的查找
+template <typename Iterator, typename MatchType>
+Iterator async_find(Iterator first, Iterator last, MatchType match, std::atomic<bool> &findDoneFlag,
+                    Partitioner partitioner = Partitioner(), Executor &executor = default_executor()) {
+    using Simd      = find_detail::use_simd<Iterator, MatchType>;
+    Iterator result = find_detail::find_first(
+        first, last,
+        [&match](Iterator &it, std::size_t lo, std::size_t hi) {
+            return find_detail::scan_value(it, lo, hi, match, Simd());
+        },
+        &findDoneFlag, partitioner, executor);
+    if (result != last) findDoneFlag.store(true);
+    return result;
+}
@@ -0,0 +1,610 @@
+/***
+ * @Description: 随机访问区间上的并行排序: 快速排序 / 稳定归并排序与多路合并 / 基数排序
+ */
+#include "threadPool/cache_padded.hpp"
+#include "threadPool/parallel_invoke.hpp"
+#include "threadPool/partitioner.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sort_detail {
+
+/// @brief 不超过这个长度改用插入排序
+constexpr std::ptrdiff_t kInsertionCutoff = 24;
+/// @brief 不超过这个长度不再拆分任务, 在当前线程上串行排序
+constexpr std::ptrdiff_t kSerialCutoff = 1 << 15;
+/// @brief 超过这个长度时划分本身也并行执行, 每个线程至少处理 kPartitionGrain 个元素
+constexpr std::ptrdiff_t kParallelPartitionCutoff = 1 << 20;
+constexpr std::size_t    kPartitionGrain          = 1 << 18;
+
+template <typename RandomIt, typename Compare>
+void insertion_sort(RandomIt first, RandomIt last, Compare &comp) {
+    if (first == last) return;
+    for (RandomIt i = first + 1; i != last; ++i) {
+        auto     value = std::move(*i);
+        RandomIt hole  = i;
+        while (hole != first && comp(value, *(hole - 1))) {
+            *hole = std::move(*(hole - 1));
+            --hole;
+        }
+        *hole = std::move(value);
+    }
+}
+
+/// @brief 三数取中: 返回 a, b, c 中值居中的那个
+template <typename RandomIt, typename Compare>
+RandomIt median_of_three(RandomIt a, RandomIt b, RandomIt c, Compare &comp) {
+    if (comp(*a, *b)) {
+        if (comp(*b, *c)) return b;
+        return comp(*a, *c) ? c : a;
+    }
+    if (comp(*a, *c)) return a;
+    return comp(*b, *c) ? c : b;
+}
+
+/// @brief Hoare 划分: first+1, 中点, last-1 三数取中换到 first 作为枢轴,
+/// 三个候选中较小与较大的仍留在区间内充当哨兵, 内层循环无需边界检查
+/// @return 划分点 cut: [first, cut) 不大于枢轴, [cut, last) 不小于枢轴, 两侧都非空
+template <typename RandomIt, typename Compare>
+RandomIt partition_pivot(RandomIt first, RandomIt last, Compare &comp) {
+    RandomIt const mid = first + (last - first) / 2;
+    std::iter_swap(first, median_of_three(first + 1, mid, last - 1, comp));
+
+    RandomIt lo = first + 1, hi = last;
+    while (true) {
+        while (comp(*lo, *first))
+            ++lo;
+        --hi;
+        while (comp(*first, *hi))
+            --hi;
+        if (!(lo < hi)) return lo;
+        std::iter_swap(lo, hi);
+        ++lo;
+    }
+}
+
+/// @brief 原地并行划分, 返回满足 pred 的元素之后的位置
+/// 1. 区间按线程静态分块, 各块独立 std::partition, 得到每块满足 pred 的个数
+/// 2. 总个数 m 即最终分界; [0, m) 中不满足的与 [m, n) 中满足的个数相同, 两两交换即可
+/// 3. 两组错位区间各自展平成长度 K 的序列, 再按线程分段并行交换
+template <typename RandomIt, typename Predicate>
+RandomIt parallel_partition(RandomIt first, RandomIt last, Predicate pred, Executor &executor) {
+    std::size_t const   length = last - first;
+    PartitionPlan const plan =
+        Partitioner(PartitionKind::Static, kPartitionGrain, executor.concurrency()).plan(length);
+    if (plan.workerCount < 2) return std::partition(first, last, pred);
+
+    std::vector<std::size_t> trueCounts(plan.chunkCount);
+    run_partitioned(
+        plan,
+        [&](std::size_t chunk_, std::size_t begin_, std::size_t end_) {
+            trueCounts[chunk_] = std::partition(first + begin_, first + end_, pred) - (first + begin_);
+        },
+        executor);
+
+    std::size_t boundary = 0;
+    for (std::size_t count : trueCounts)
+        boundary += count;
+
+    // 每块的 [begin, split) 满足 pred, [split, end) 不满足; 与分界两侧求交得到错位区间
+    using Interval = std::pair<std::size_t, std::size_t>;
+    std::vector<Interval> wrongLeft, wrongRight;
+    for (std::size_t i = 0; i < plan.chunkCount; ++i) {
+        std::size_t const begin = plan.chunk_begin(i), end = plan.chunk_end(i), split = begin + trueCounts[i];
+        if (split < std::min(end, boundary)) wrongLeft.emplace_back(split, std::min(end, boundary));
+        if (std::max(begin, boundary) < split) wrongRight.emplace_back(std::max(begin, boundary), split);
+    }
+
+    // offsets[i]: 第 i 个区间在展平序列中的起点
+    auto flatten = [](std::vector<Interval> const &intervals_, std::vector<std::size_t> &offsets_) {
+        std::size_t total = 0;
+        for (auto const &interval : intervals_) {
+            offsets_.push_back(total);
+            total += interval.second - interval.first;
+        }
+        return total;
+    };
+    std::vector<std::size_t> leftOffsets, rightOffsets;
+    std::size_t const        misplaced = flatten(wrongLeft, leftOffsets);
+    flatten(wrongRight, rightOffsets);
+    if (!misplaced) return first + boundary;
+
+    // 展平序列中的第 k 个元素 -> (区间号, 区间内的位置)
+    auto locate = [](std::vector<Interval> const &intervals_, std::vector<std::size_t> const &offsets_,
+                     std::size_t k_) {
+        std::size_t const index = std::upper_bound(offsets_.begin(), offsets_.end(), k_) - offsets_.begin() - 1;
+        return std::make_pair(index, intervals_[index].first + (k_ - offsets_[index]));
+    };
+
+    run_partitioned(
+        Partitioner(PartitionKind::Static, kPartitionGrain, executor.concurrency()).plan(misplaced),
+        [&](std::size_t, std::size_t begin_, std::size_t end_) {
+            auto left  = locate(wrongLeft, leftOffsets, begin_);
+            auto right = locate(wrongRight, rightOffsets, begin_);
+            for (std::size_t k = begin_; k < end_; ++k) {
+                if (left.second == wrongLeft[left.first].second) left.second = wrongLeft[++left.first].first;
+                if (right.second == wrongRight[right.first].second) right.second = wrongRight[++right.first].first;
+                std::iter_swap(first + left.second++, first + right.second++);
+            }
+        },
+        executor);
+    return first + boundary;
+}
+
+/// @brief 大区间: 三数取中的枢轴值拷贝出来, 并行划分成 < 枢轴 与 >= 枢轴 两部分;
+/// 没有比枢轴小的元素时再划出 == 枢轴 的部分直接跳过, 保证每轮都有进展
+template <typename RandomIt, typename Compare>
+std::pair<RandomIt, RandomIt> parallel_partition_pivot(RandomIt first, RandomIt last, Compare &comp,
+                                                       Executor &executor) {
+    using valueType = typename std::iterator_traits<RandomIt>::value_type;
+
+    valueType const pivot = *median_of_three(first, first + (last - first) / 2, last - 1, comp);
+    RandomIt const  cut =
+        parallel_partition(first, last, [&](valueType const &value_) { return comp(value_, pivot); }, executor);
+    if (cut != first) return std::make_pair(cut, cut);
+    RandomIt const equalEnd =
+        parallel_partition(first, last, [&](valueType const &value_) { return !comp(pivot, value_); }, executor);
+    return std::make_pair(first, equalEnd);
+}
+
+template <typename RandomIt, typename Compare>
+void quick_sort(RandomIt first, RandomIt last, Compare &comp, int depth, Executor &executor) {
+    while (last - first > kInsertionCutoff) {
+        if (depth-- == 0) { // 划分持续失衡, 退化为堆排序保证 O(nlogn)
+            std::partial_sort(first, last, last, comp);
+            return;
+        }
+        if (last - first > kSerialCutoff) {
+            // [first, cut.first) 与 [cut.second, last) 分别递归, 中间是与枢轴相等的元素
+            std::pair<RandomIt, RandomIt> cut;
+            if (last - first > kParallelPartitionCutoff) {
+                cut = parallel_partition_pivot(first, last, comp, executor);
+            } else {
+                RandomIt const mid = partition_pivot(first, last, comp);
+                cut                = std::make_pair(mid, mid);
+            }
+            parallel_invoke([&]() { quick_sort(first, cut.first, comp, depth, executor); },
+                            [&]() { quick_sort(cut.second, last, comp, depth, executor); }, executor);
+            return;
+        }
+        // 串行: 较短的一侧递归, 较长的一侧循环, 栈深度不超过 logn
+        RandomIt const cut = partition_pivot(first, last, comp);
+        if (cut - first < last - cut) {
+            quick_sort(first, cut, comp, depth, executor);
+            first = cut;
+        } else {
+            quick_sort(cut, last, comp, depth, executor);
+            last = cut;
+        }
+    }
+    insertion_sort(first, last, comp);
+}
+
+} // namespace sort_detail
+
+/// @brief 原地并行快速排序 (不稳定)
+/// 三数取中选枢轴, 短区间插入排序, 左右两侧经执行器 fork-join 并行递归;
+/// 很大的区间连划分本身也并行执行. 递归过深时退化为堆排序.
+/// @tparam RandomIt 随机访问迭代器
+/// @tparam Compare  严格弱序
+/// @param first
+/// @param last
+/// @param comp
+/// @param executor  执行器, 默认共享的StealThreadPool
+template <typename RandomIt, typename Compare = std::less<>>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp = Compare(), Executor &executor = default_executor()) {
+    std::ptrdiff_t const length = last - first;
+    if (length < 2) return;
+    int depth = 0;
+    for (std::ptrdiff_t n = length; n > 1; n >>= 1)
+        depth += 2;
+    sort_detail::quick_sort(first, last, comp, depth, executor);
+}
+
+namespace merge_detail {
+
+/// @brief 输出长度超过 kMergeGrain 的每一份才值得交给一个线程合并
+constexpr std::size_t kMergeGrain = 1 << 16;
+
+/// @brief co-rank: 稳定合并 A、B 后的前 k 个元素中有多少个来自 A
+/// 相等时 A 在前, 因此 A[i] <= B[j-1] 说明 i 还太小; 该条件对 i 单调, 二分即可
+template <typename It1, typename It2, typename Compare>
+std::size_t co_rank(std::size_t k_, It1 a_, std::size_t n_, It2 b_, std::size_t m_, Compare &comp) {
+    std::size_t lo = k_ > m_ ? k_ - m_ : 0;
+    std::size_t hi = std::min(k_, n_);
+    while (lo < hi) {
+        std::size_t const i = lo + (hi - lo) / 2;
+        std::size_t const j = k_ - i;
+        if (j > 0 && !comp(b_[j - 1], a_[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+/// @brief 串行合并, 元素移动到输出; 比较始终作用于左值, 不会因按值传参的比较器把元素移走
+template <typename It1, typename It2, typename OutIt, typename Compare>
+OutIt move_merge(It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first, Compare &comp) {
+    while (first1 != last1 && first2 != last2) {
+        if (comp(*first2, *first1)) {
+            *d_first++ = std::move(*first2++);
+        } else {
+            *d_first++ = std::move(*first1++);
+        }
+    }
+    d_first = std::move(first1, last1, d_first);
+    return std::move(first2, last2, d_first);
+}
+
+template <bool Move, typename It1, typename It2, typename OutIt, typename Compare>
+void merge_serial(It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first, Compare &comp) {
+    if (Move) {
+        move_merge(first1, last1, first2, last2, d_first, comp);
+    } else {
+        std::merge(first1, last1, first2, last2, d_first, comp);
+    }
+}
+
+/// @brief 按输出位置切成若干份, 每份两端用 co_rank 定位到 A、B 中的子区间, 各自串行合并
+/// @tparam Move 为 true 时移动元素, 否则拷贝
+template <bool Move, typename It1, typename It2, typename OutIt, typename Compare>
+void merge(It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first, Compare &comp, Executor &executor) {
+    std::size_t const n = last1 - first1, m = last2 - first2;
+    if (n + m < 2 * kMergeGrain) { // 归并排序的底层大量小合并, 不必询问执行器
+        merge_serial<Move>(first1, last1, first2, last2, d_first, comp);
+        return;
+    }
+    PartitionPlan const plan =
+        Partitioner(PartitionKind::Static, kMergeGrain, executor.concurrency()).plan(n + m);
+    if (plan.workerCount < 2) {
+        merge_serial<Move>(first1, last1, first2, last2, d_first, comp);
+        return;
+    }
+    run_partitioned(
+        plan,
+        [&](std::size_t, std::size_t begin_, std::size_t end_) {
+            std::size_t const i0 = co_rank(begin_, first1, n, first2, m, comp);
+            std::size_t const i1 = co_rank(end_, first1, n, first2, m, comp);
+            merge_serial<Move>(first1 + i0, first1 + i1, first2 + (begin_ - i0), first2 + (end_ - i1),
+                               d_first + begin_, comp);
+        },
+        executor);
+}
+
+/// @brief 乒乓归并: 两半排序结果放在另一侧, 再合并回目标侧, 每层只搬运一次
+/// toBuffer_ 为 true 时结果写入 buffer_, 否则留在 [first, last)
+template <typename RandomIt, typename BufferIt, typename Compare>
+void merge_sort(RandomIt first, RandomIt last, BufferIt buffer_, bool toBuffer_, Compare &comp, Executor &executor) {
+    std::ptrdiff_t const length = last - first;
+    if (length <= sort_detail::kInsertionCutoff) {
+        sort_detail::insertion_sort(first, last, comp); // 插入排序遇到相等元素不移动, 是稳定的
+        if (toBuffer_) std::move(first, last, buffer_);
+        return;
+    }
+
+    std::ptrdiff_t const half   = length / 2;
+    RandomIt const       middle = first + half;
+    if (length > sort_detail::kSerialCutoff) {
+        parallel_invoke([&]() { merge_sort(first, middle, buffer_, !toBuffer_, comp, executor); },
+                        [&]() { merge_sort(middle, last, buffer_ + half, !toBuffer_, comp, executor); }, executor);
+    } else {
+        merge_sort(first, middle, buffer_, !toBuffer_, comp, executor);
+        merge_sort(middle, last, buffer_ + half, !toBuffer_, comp, executor);
+    }
+
+    if (toBuffer_) {
+        merge<true>(first, middle, middle, last, buffer_, comp, executor);
+    } else {
+        merge<true>(buffer_, buffer_ + half, buffer_ + half, buffer_ + length, first, comp, executor);
+    }
+}
+
+/// @brief 多路合并的一个输出段: 小顶堆里放各路当前位置, 相等时路号小的先出, 保证稳定
+template <typename RandomIt, typename OutIt, typename Compare>
+void kway_merge_serial(std::vector<std::pair<RandomIt, RandomIt>> runs_, OutIt d_first, Compare &comp) {
+    std::vector<std::size_t> heap;
+    for (std::size_t i = 0; i < runs_.size(); ++i) {
+        if (runs_[i].first != runs_[i].second) heap.push_back(i);
+    }
+    // std::*_heap 是大顶堆, "a 应排在 b 之后" 时 a < b
+    auto const later = [&](std::size_t a_, std::size_t b_) {
+        if (comp(*runs_[b_].first, *runs_[a_].first)) return true;
+        if (comp(*runs_[a_].first, *runs_[b_].first)) return false;
+        return a_ > b_;
+    };
+    std::make_heap(heap.begin(), heap.end(), later);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        std::size_t const run = heap.back();
+        *d_first++            = *runs_[run].first++;
+        if (runs_[run].first == runs_[run].second) {
+            heap.pop_back();
+        } else {
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+}
+
+} // namespace merge_detail
+
+/// @brief 并行稳定合并两个有序区间 (结果同 std::merge)
+/// @return 输出区间的尾后迭代器
+template <typename It1, typename It2, typename OutIt, typename Compare = std::less<>>
+OutIt parallel_merge(It1 first1, It1 last1, It2 first2, It2 last2, OutIt d_first, Compare comp = Compare(),
+                     Executor &executor = default_executor()) {
+    merge_detail::merge<false>(first1, last1, first2, last2, d_first, comp, executor);
+    return d_first + ((last1 - first1) + (last2 - first2));
+}
+
+/// @brief 并行稳定归并排序, 使用调用方提供的辅助空间
+/// scratch 不足时扩容, 多次排序可复用同一个 scratch 避免反复分配 (元素类型需可默认构造)
+/// 两半经 fork-join 并行排序, 每层合并按 co-rank 切分后并行执行
+/// @tparam RandomIt 随机访问迭代器
+/// @param first
+/// @param last
+/// @param scratch   辅助空间
+/// @param comp
+/// @param executor  执行器, 默认共享的StealThreadPool
+template <typename RandomIt, typename Compare = std::less<>>
+void parallel_stable_sort(RandomIt first, RandomIt last,
+                          std::vector<typename std::iterator_traits<RandomIt>::value_type> &scratch,
+                          Compare comp = Compare(), Executor &executor = default_executor()) {
+    std::size_t const length = last - first;
+    if (length < 2) return;
+    if (scratch.size() < length) scratch.resize(length);
+    merge_detail::merge_sort(first, last, scratch.begin(), false, comp, executor);
+}
+
+template <typename RandomIt, typename Compare = std::less<>>
+void parallel_stable_sort(RandomIt first, RandomIt last, Compare comp = Compare(),
+                          Executor &executor = default_executor()) {
+    std::vector<typename std::iterator_traits<RandomIt>::value_type> scratch;
+    parallel_stable_sort(first, last, scratch, comp, executor);
+}
+
+/// @brief 并行多路合并若干有序段 (稳定: 相等元素按段的先后输出)
+/// 从各段等距抽样选出分隔值, 每段按分隔值 lower_bound 切开, 同一分隔值之间的各段子区间
+/// 组成一个输出段, 由一个线程用小顶堆合并; 输出段的起点由前面各子区间长度之和确定
+/// @tparam RandomIt 各有序段的随机访问迭代器
+/// @tparam OutIt    随机访问输出迭代器
+/// @param runs      有序段 [first, last) 列表
+/// @param d_first
+/// @param comp
+/// @param executor
+/// @return 输出区间的尾后迭代器
+template <typename RandomIt, typename OutIt, typename Compare = std::less<>>
+OutIt parallel_kway_merge(std::vector<std::pair<RandomIt, RandomIt>> const &runs, OutIt d_first,
+                          Compare comp = Compare(), Executor &executor = default_executor()) {
+    using valueType = typename std::iterator_traits<RandomIt>::value_type;
+    using Runs      = std::vector<std::pair<RandomIt, RandomIt>>;
+
+    std::size_t total = 0;
+    for (auto const &run : runs)
+        total += run.second - run.first;
+    PartitionPlan const plan =
+        Partitioner(PartitionKind::Static, merge_detail::kMergeGrain, executor.concurrency()).plan(total);
+    if (plan.workerCount < 2) {
+        merge_detail::kway_merge_serial(runs, d_first, comp);
+        return d_first + total;
+    }
+
+    // 每段取 workerCount 个等距样本, 排序后等距取 workerCount - 1 个作为分隔值
+    std::vector<valueType> samples;
+    for (auto const &run : runs) {
+        std::size_t const length = run.second - run.first;
+        for (std::size_t i = 1; length && i <= plan.workerCount; ++i)
+            samples.push_back(run.first[i * length / (plan.workerCount + 1)]);
+    }
+    std::sort(samples.begin(), samples.end(), comp);
+
+    // cuts[p][r]: 第 p 个分隔点在第 r 段中的位置, 首尾分别是各段的起点与终点
+    std::vector<std::vector<RandomIt>> cuts(plan.workerCount + 1);
+    for (auto const &run : runs) {
+        cuts.front().push_back(run.first);
+        cuts.back().push_back(run.second);
+    }
+    for (std::size_t p = 1; p < plan.workerCount; ++p) {
+        valueType const &splitter = samples[p * samples.size() / plan.workerCount];
+        for (std::size_t r = 0; r < runs.size(); ++r) {
+            // 分隔值单调不减, 从上一个分隔点开始查找
+            cuts[p].push_back(std::lower_bound(cuts[p - 1][r], runs[r].second, splitter, comp));
+        }
+    }
+
+    std::vector<std::size_t> outputBegin(plan.workerCount + 1, 0);
+    for (std::size_t p = 0; p < plan.workerCount; ++p) {
+        outputBegin[p + 1] = outputBegin[p];
+        for (std::size_t r = 0; r < runs.size(); ++r)
+            outputBegin[p + 1] += cuts[p + 1][r] - cuts[p][r];
+    }
+
+    run_partitioned(
+        Partitioner(PartitionKind::Dynamic, 1, plan.workerCount).plan(plan.workerCount),
+        [&](std::size_t segment_, std::size_t, std::size_t) {
+            Runs pieces;
+            for (std::size_t r = 0; r < runs.size(); ++r)
+                pieces.emplace_back(cuts[segment_][r], cuts[segment_ + 1][r]);
+            merge_detail::kway_merge_serial(std::move(pieces), d_first + outputBegin[segment_], comp);
+        },
+        executor);
+    return d_first + total;
+}
+
+namespace radix_detail {
+
+/// @brief 每趟处理 8 位, 256 个桶
+constexpr unsigned    kRadixBits = 8;
+constexpr std::size_t kBuckets   = std::size_t(1) << kRadixBits;
+/// @brief 每个线程至少处理的元素数
+constexpr std::size_t kRadixGrain = 1 << 16;
+/// @brief 短于这个长度改用比较排序
+constexpr std::size_t kComparisonCutoff = 4096;
+
+/// @brief 键变换: 把键映射成同宽度的无符号整数, 无符号比较的顺序与原键一致
+/// 有符号整数翻转符号位; IEEE 浮点负数整体取反、非负数置符号位
+/// (-0.0 排在 +0.0 之前, 负 NaN 排在最前, 正 NaN 排在最后)
+template <typename Key, typename Enable = void>
+struct RadixKey;
+
+template <typename Key>
+struct RadixKey<Key, typename std::enable_if<std::is_integral<Key>::value>::type> {
+    static_assert(!std::is_same<Key, bool>::value, "bool keys are not supported");
+    using Bits = typename std::make_unsigned<Key>::type;
+
+    static Bits encode(Key key_) {
+        Bits const signBit = std::is_signed<Key>::value ? Bits(Bits(1) << (sizeof(Bits) * 8 - 1)) : Bits(0);
+        return static_cast<Bits>(static_cast<Bits>(key_) ^ signBit);
+    }
+};
+
+template <typename Key>
+struct RadixKey<Key, typename std::enable_if<std::is_floating_point<Key>::value>::type> {
+    static_assert(sizeof(Key) == 4 || sizeof(Key) == 8, "only IEEE float and double keys are supported");
+    using Bits = typename std::conditional<sizeof(Key) == 4, uint32_t, uint64_t>::type;
+
+    static Bits encode(Key key_) {
+        Bits bits;
+        std::memcpy(&bits, &key_, sizeof(bits));
+        Bits const signBit = Bits(1) << (sizeof(Bits) * 8 - 1);
+        return (bits & signBit) ? Bits(~bits) : Bits(bits | signBit);
+    }
+};
+
+/// @brief 默认以元素本身为键
+struct SelfKey {
+    template <typename T>
+    T operator()(T const &value_) const {
+        return value_;
+    }
+};
+
+/// @brief 一趟 LSD: 各线程统计自己那一块的直方图, 串行求出每个线程每个桶的起始写入位置,
+/// 各线程再按原顺序把元素分发到目标区间 (因此稳定). 分发先写入每个桶一个缓存行大小的
+/// 本地缓冲, 攒满后整行写出, 减少对 256 个分散位置的零散写.
+/// @return 所有键在这一位上都相同时跳过这一趟并返回false
+template <typename SrcIt, typename DstIt, typename Encode>
+bool scatter_pass(SrcIt src_, DstIt dst_, std::size_t length_, unsigned shift_, Encode &encode_,
+                  PartitionPlan const &plan_, Executor &executor_) {
+    using valueType = typename std::iterator_traits<SrcIt>::value_type;
+    // 每个桶的本地缓冲容纳一个缓存行; 元素比缓存行还大时直接写出
+    constexpr std::size_t kCombined = std::max<std::size_t>(1, kCacheLineSize / sizeof(valueType));
+
+    auto const digit = [&](valueType const &value_) {
+        return static_cast<std::size_t>(encode_(value_) >> shift_) & (kBuckets - 1);
+    };
+
+    std::vector<std::size_t> counts(plan_.chunkCount * kBuckets, 0);
+    run_partitioned(
+        plan_,
+        [&](std::size_t chunk_, std::size_t begin_, std::size_t end_) {
+            std::size_t *histogram = &counts[chunk_ * kBuckets];
+            for (std::size_t i = begin_; i < end_; ++i)
+                ++histogram[digit(src_[i])];
+        },
+        executor_);
+
+    // 某个桶在各块中的总数等于全长, 即所有键在这一位上相同
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        std::size_t total = 0;
+        for (std::size_t chunk = 0; chunk < plan_.chunkCount; ++chunk)
+            total += counts[chunk * kBuckets + bucket];
+        if (total == length_) return false;
+        if (total) break; // 第一个非空的桶不满, 这一趟要做
+    }
+
+    // 按 (桶, 块) 的顺序求前缀和, 得到每块每桶的起始位置
+    std::size_t offset = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        for (std::size_t chunk = 0; chunk < plan_.chunkCount; ++chunk) {
+            std::size_t      &count = counts[chunk * kBuckets + bucket];
+            std::size_t const next  = offset + count;
+            count                   = offset;
+            offset                  = next;
+        }
+    }
+
+    run_partitioned(
+        plan_,
+        [&](std::size_t chunk_, std::size_t begin_, std::size_t end_) {
+            std::size_t *position = &counts[chunk_ * kBuckets];
+            if (kCombined == 1) {
+                for (std::size_t i = begin_; i < end_; ++i)
+                    dst_[position[digit(src_[i])]++] = std::move(src_[i]);
+                return;
+            }
+            std::vector<valueType>     buffer(kBuckets * kCombined);
+            std::vector<unsigned char> filled(kBuckets, 0);
+            for (std::size_t i = begin_; i < end_; ++i) {
+                std::size_t const bucket = digit(src_[i]);
+                buffer[bucket * kCombined + filled[bucket]] = std::move(src_[i]);
+                if (++filled[bucket] == kCombined) {
+                    std::move(&buffer[bucket * kCombined], &buffer[bucket * kCombined] + kCombined,
+                              dst_ + position[bucket]);
+                    position[bucket] += kCombined;
+                    filled[bucket] = 0;
+                }
+            }
+            for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+                std::move(&buffer[bucket * kCombined], &buffer[bucket * kCombined] + filled[bucket],
+                          dst_ + position[bucket]);
+            }
+        },
+        executor_);
+    return true;
+}
+
+} // namespace radix_detail
+
+/// @brief 并行 LSD 基数排序 (稳定), 按 keyOf(元素) 的值升序排列
+/// 键可以是任意宽度的有符号/无符号整数或 float/double, 经 RadixKey 变换后按 8 位一趟排序;
+/// 所有元素在某一位上都相同的趟直接跳过 (例如时间戳的高位). 元素类型需可默认构造.
+/// @tparam RandomIt 随机访问迭代器
+/// @tparam KeyOf    Key(value_type const &), 默认以元素本身为键
+/// @param first
+/// @param last
+/// @param keyOf
+/// @param executor  执行器, 默认共享的StealThreadPool
+template <typename RandomIt, typename KeyOf = radix_detail::SelfKey>
+void parallel_radix_sort(RandomIt first, RandomIt last, KeyOf keyOf = KeyOf(),
+                         Executor &executor = default_executor()) {
+    using valueType = typename std::iterator_traits<RandomIt>::value_type;
+    using keyType   = typename std::decay<decltype(keyOf(std::declval<valueType const &>()))>::type;
+    using Radix     = radix_detail::RadixKey<keyType>;
+
+    auto encode = [&keyOf](valueType const &value_) { return Radix::encode(keyOf(value_)); };
+
+    std::size_t const length = last - first;
+    if (length < radix_detail::kComparisonCutoff) { // 每趟固定的直方图与缓冲开销不划算
+        std::stable_sort(first, last,
+                         [&encode](valueType const &a_, valueType const &b_) { return encode(a_) < encode(b_); });
+        return;
+    }
+
+    PartitionPlan const plan =
+        Partitioner(PartitionKind::Static, radix_detail::kRadixGrain, executor.concurrency()).plan(length);
+    std::vector<valueType> buffer(length);
+    bool                   inBuffer = false; // 当前数据在 buffer 还是原区间
+    for (unsigned shift = 0; shift < sizeof(typename Radix::Bits) * 8; shift += radix_detail::kRadixBits) {
+        bool const moved = inBuffer ? radix_detail::scatter_pass(buffer.begin(), first, length, shift, encode, plan,
+                                                                 executor)
+                                    : radix_detail::scatter_pass(first, buffer.begin(), length, shift, encode, plan,
+                                                                 executor);
+        if (moved) inBuffer = !inBuffer;
+    }
+    if (inBuffer) {
+        run_partitioned(
+            plan,
+            [&](std::size_t, std::size_t begin_, std::size_t end_) {
+                std::move(buffer.begin() + begin_, buffer.begin() + end_, first + begin_);
+            },
+            executor);
+    }
+}
@@ -5,114 +5,145 @@
  * @LastEditors: Ye Guosheng
  * @Description:
  */
+#include "threadPool/partitioner.hpp"
+#include "threadPool/simd.hpp"
 #include <algorithm>
-#include <atomic>
-#include <future>
+#include <functional>
+#include <iterator>
 #include <numeric>
-#include <thread>
+#include <type_traits>
 #include <vector>
 
-class Join_Thread {
-public:
-    explicit Join_Thread(std::vector<std::thread> &threads_)
-        : _threads(threads_) {}
-    ~Join_Thread() {
-        for (unsigned long i = 0; i < _threads.size(); ++i) {
-            if (_threads[i].joinable()) _threads[i].join();
-        }
+namespace scan_detail {
+
+/// @brief 输入输出都是连续内存, 且 T 在 Op 下有向量化实现时走 SIMD
+template <typename InputIt, typename OutputIt, typename T, typename Op>
+using use_simd = std::integral_constant<
+    bool, simd::can_scan<T, Op>::value && is_contiguous_iterator<InputIt>::value &&
+              is_contiguous_iterator<OutputIt>::value &&
+              std::is_same<typename std::iterator_traits<InputIt>::value_type, T>::value &&
+              std::is_same<typename std::iterator_traits<OutputIt>::value_type, T>::value>;
+
+/// @brief 块内扫描, carry 为前面所有块的累计值, 返回本块结束后的累计值
+template <typename InputIt, typename OutputIt, typename T, typename Op>
+T scan_block(InputIt first, InputIt last, OutputIt d_first, T carry, Op op, bool inclusive, std::false_type) {
+    for (; first != last; ++first, ++d_first) {
+        T value = op(carry, *first); // 先读后写, 原地扫描时不会读到已改写的值
+        *d_first = inclusive ? value : carry;
+        carry    = std::move(value);
+    }
+    return carry;
+}
+
+template <typename InputIt, typename OutputIt, typename T, typename Op>
+T scan_block(InputIt first, InputIt last, OutputIt d_first, T carry, Op, bool inclusive, std::true_type) {
+    if (first == last) return carry;
+    return simd::prefix_sum(&*first, &*d_first, std::distance(first, last), carry, inclusive);
+}
+
+template <typename InputIt, typename T, typename Op>
+T reduce_block(InputIt first, InputIt last, T init, Op op, std::false_type) {
+    return std::accumulate(first, last, std::move(init), op);
+}
+
+template <typename InputIt, typename T, typename Op>
+T reduce_block(InputIt first, InputIt last, T init, Op, std::true_type) {
+    if (first == last) return init;
+    return init + simd::sum(&*first, std::distance(first, last));
+}
+
+/// @brief 两遍扫描 (reduce-then-scan)
+/// 第一遍各块独立求块内总和; 调用线程串行扫描块总和得到每块的起始值;
+/// 第二遍各块以起始值为初值独立做块内扫描. 两遍之间块与块没有依赖, 块数不影响延迟.
+/// hasInit 为 false 时(无初值的 inclusive 扫描) 第0块以首元素为初值.
+template <typename InputIt, typename OutputIt, typename T, typename Op>
+OutputIt scan(InputIt first, InputIt last, OutputIt d_first, T const &init, bool hasInit, Op op, bool inclusive,
+              Partitioner const &partitioner, Executor &executor) {
+    using Simd = use_simd<InputIt, OutputIt, T, Op>;
+
+    std::size_t const length = std::distance(first, last);
+    if (!length) return d_first;
+
+    PartitionPlan const         plan      = partitioner.plan(length);
+    std::vector<InputIt> const  starts    = chunk_starts(plan, first);
+    std::vector<OutputIt> const outStarts = chunk_starts(plan, d_first);
+    // 最后一块的总和用不到, 只对前 chunkCount - 1 块求和
+    std::vector<T> blockSums(plan.chunkCount);
+    if (plan.chunkCount > 1) {
+        PartitionPlan reducePlan = plan;
+        reducePlan.chunkCount -= 1;
+        reducePlan.length      = plan.chunk_begin(plan.chunkCount - 1);
+        reducePlan.workerCount = std::min(plan.workerCount, reducePlan.chunkCount);
+        run_partitioned(
+            reducePlan,
+            [&](std::size_t chunk_, std::size_t, std::size_t) {
+                InputIt blockFirst = starts[chunk_];
+                T       head       = *blockFirst;
+                blockSums[chunk_]  = reduce_block(++blockFirst, starts[chunk_ + 1], std::move(head), op, Simd());
+            },
+            executor);
     }
 
-private:
-    std::vector<std::thread> &_threads;
-};
+    // 块数只有线程数的若干倍, 串行扫描即可
+    std::vector<T> offsets(plan.chunkCount);
+    if (hasInit) offsets[0] = init;
+    for (std::size_t i = 1; i < plan.chunkCount; ++i) {
+        offsets[i] = (i == 1 && !hasInit) ? blockSums[0] : op(offsets[i - 1], blockSums[i - 1]);
+    }
+
+    run_partitioned(
+        plan,
+        [&](std::size_t chunk_, std::size_t, std::size_t) {
+            InputIt  blockFirst = starts[chunk_];
+            InputIt  blockLast  = starts[chunk_ + 1];
+            OutputIt blockOut   = outStarts[chunk_];
+            T        carry      = offsets[chunk_];
+            if (chunk_ == 0 && !hasInit) { // inclusive 无初值: 首元素原样输出
+                carry     = *blockFirst;
+                *blockOut = carry;
+                ++blockFirst;
+                ++blockOut;
+            }
+            scan_block(blockFirst, blockLast, blockOut, std::move(carry), op, inclusive, Simd());
+        },
+        executor);
+    return outStarts.back();
+}
+
+} // namespace scan_detail
+
+/// @brief 并行 inclusive 扫描: d_first[i] = first[0] op first[1] op ... op first[i]
+/// op 需满足结合律(不要求交换律), 迭代器需至少为前向迭代器, 输出可以与输入相同(原地扫描)
+/// @return 输出区间的尾后迭代器
+template <typename InputIt, typename OutputIt, typename Op = std::plus<>>
+OutputIt parallel_inclusive_scan(InputIt first, InputIt last, OutputIt d_first, Op op = Op(),
+                                 Partitioner partitioner = Partitioner(), Executor &executor = default_executor()) {
+    using valueType = typename std::iterator_traits<InputIt>::value_type;
+    return scan_detail::scan(first, last, d_first, valueType(), false, op, true, partitioner, executor);
+}
+
+/// @brief 并行 exclusive 扫描: d_first[0] = init, d_first[i] = init op first[0] op ... op first[i-1]
+/// @return 输出区间的尾后迭代器
+template <typename InputIt, typename OutputIt, typename T, typename Op = std::plus<>>
+OutputIt parallel_exclusive_scan(InputIt first, InputIt last, OutputIt d_first, T init, Op op = Op(),
+                                 Partitioner partitioner = Partitioner(), Executor &executor = default_executor()) {
+    return scan_detail::scan(first, last, d_first, init, true, op, false, partitioner, executor);
+}
 
 /// @brief [1,2,3,4,5,6,7,8,9]
 /// split as         : [1,2,3]    [4,5,6]        [7,8,9]
-/// Add in group     : [1,3,6]    [4,9,15]       [7,15,24]
-/// Add beteeen group: [1,3,6] 6->[10,15,21] 21->[28,36,45]
-/// res              : [1,3,6,10,15,21,28,36,55]
+/// reduce in group  :    6          15             24
+/// scan group sums  :    0           6             21
+/// scan in group    : [1,3,6]    6->[10,15,21]  21->[28,36,45]
+/// res              : [1,3,6,10,15,21,28,36,45]
 /// @tparam Iterator
 /// @param first
 /// @param last
+/// @param partitioner 划分策略, 各块两遍之间互不等待
+/// @param executor
 template <typename Iterator>
-void paraller_partial_sum(Iterator first, Iterator last) {
-    using valueType = typename Iterator::value_type;
-
-    struct processChunk {
-
-        void operator()(Iterator begin, Iterator last, std::future<valueType> *previousEndValuesFuture_,
-                        std::promise<valueType> *endValuesPro_) {
-            try {
-
-                Iterator end = last;
-                ++end;
-                std::partial_sum(begin, end, begin); // 计算当前块的部分和
-
-                if (previousEndValuesFuture_) {                         // 当前块不是第一个块
-                    valueType addEnd = previousEndValuesFuture_->get(); // 获取前一个块的和
-                    *last += addEnd; // 当前块的最后一个元素添加前一个块的和addEnd（**先添加，及时给下一块使用**）
-                    if (endValuesPro_) {                 // 需要将当前块的值传给下一个块
-                        endValuesPro_->set_value(*last); // 将endValuesPro_设置为当前块的最后一个元素的值
-                    }
-                    std::for_each(begin, last, [addEnd](valueType &item) {
-                        item += addEnd; // 当前块的所有元素（除了最后一个）加上前一个块的和addEnd
-                    });
-                } else if (endValuesPro_) { // 无前一块，直接将当前块的最后一个元素设为endValuesPro_的值
-                    endValuesPro_->set_value(*last); // 提醒 future
-                }
-
-            } catch (...) {
-                if (endValuesPro_) {
-                    endValuesPro_->set_exception(std::current_exception());
-                } else {
-                    throw;
-                }
-            }
-        }
-    };
-
-    unsigned long length = std::distance(first, last);
-    if (!length) return;
-
-    unsigned long minPerThread   = 30;
-    unsigned long maxThreads     = (length + minPerThread - 1) / minPerThread;
-    unsigned long hardwareThread = std::thread::hardware_concurrency();
-    unsigned long numThreads     = std::min(hardwareThread != 0 ? hardwareThread : 2, maxThreads);
-    unsigned long blockSize      = length / numThreads;
-
-    /*
-    1 2 3,  4  5  6,  7  8
-    1 3 6  10 15 21  28 36
-
-    t1: 1 3 6                           p1=6
-    t2: (4 9 15).add(6)=>(10,15,21); f2=p1=6, p2=21
-    t:  (7 15).add(21) =>(28,36)   ; f3=p2=21
-    */
-    std::vector<std::thread>             threads(numThreads - 1);
-    std::vector<std::promise<valueType>> endValuesPro(numThreads - 1); // 前一个线程的累加结果
-    std::vector<std::future<valueType>>  previousEndValuesFuture;      // future获取前一个线程的promise
-    previousEndValuesFuture.reserve(numThreads - 1);
-    Join_Thread joinThread(threads);
-    Iterator    blockStart = first;
-
-    for (unsigned long index = 0; index < numThreads - 1; ++index) {
-        Iterator blockEnd = blockStart;
-        std::advance(blockEnd, blockSize - 1); // 17
-
-        // 不是第一个块线程，传入前一个块的部分和结果，并存储当前块的部分和结果。
-        threads[index] = std::thread(processChunk(), blockStart, blockEnd,
-                                     (index != 0) ? &previousEndValuesFuture[index - 1] : 0, &endValuesPro[index]);
-        blockStart     = blockEnd;
-        ++blockStart;
-
-        // 当前块的部分和结果的future对象存入previousEndValuesFuture中，以便传递给下一个线程。
-        previousEndValuesFuture.push_back(endValuesPro[index].get_future());
-    }
-
-    // 处理最后一块数据
-    Iterator finalElement = blockStart;
-    // 21
-    std::advance(finalElement, std::distance(blockStart, last) - 1);
-    // 22
-    processChunk()(blockStart, finalElement, (numThreads > 1) ? &previousEndValuesFuture.back() : 0, 0);
-}
\ No newline at end of file
+void paraller_partial_sum(Iterator first, Iterator last, Partitioner partitioner = Partitioner(),
+                          Executor &executor = default_executor()) {
+    using valueType = typename std::iterator_traits<Iterator>::value_type;
+    parallel_inclusive_scan(first, last, first, std::plus<valueType>(), partitioner, executor);
+}
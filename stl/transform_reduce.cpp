@@ -0,0 +1,141 @@
+/***
+ * @Description: 并行 transform_reduce / reduce, 算术类型走 SIMD 内核
+ */
+#include "threadPool/cache_padded.hpp"
+#include "threadPool/partitioner.hpp"
+#include "threadPool/simd.hpp"
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @brief 恒等变换, 作为 transform 时 transform_reduce 退化为 reduce
+struct Identity {
+    template <typename T>
+    T &&operator()(T &&value_) const {
+        return std::forward<T>(value_);
+    }
+};
+
+namespace reduce_detail {
+
+/// @brief 连续内存上的 T 求和, 且累加类型就是元素类型时走 simd::sum
+template <typename Iterator, typename T, typename Reduce, typename Transform>
+using use_simd_sum =
+    std::integral_constant<bool, simd::is_vectorizable<T>::value && is_contiguous_iterator<Iterator>::value &&
+                                     std::is_same<typename std::iterator_traits<Iterator>::value_type, T>::value &&
+                                     simd::is_plus<T, Reduce>::value && std::is_same<Transform, Identity>::value>;
+
+/// @brief 两段连续内存上的 T 内积时走 simd::dot
+template <typename Iterator1, typename Iterator2, typename T, typename Reduce, typename Transform>
+using use_simd_dot =
+    std::integral_constant<bool, simd::is_vectorizable<T>::value && is_contiguous_iterator<Iterator1>::value &&
+                                     is_contiguous_iterator<Iterator2>::value &&
+                                     std::is_same<typename std::iterator_traits<Iterator1>::value_type, T>::value &&
+                                     std::is_same<typename std::iterator_traits<Iterator2>::value_type, T>::value &&
+                                     simd::is_plus<T, Reduce>::value && simd::is_multiplies<T, Transform>::value>;
+
+/// @brief 块内归约, 以首元素变换后的值为初值 (reduce 不要求有单位元)
+template <typename Iterator, typename T, typename Reduce, typename Transform>
+T reduce_block(Iterator first, Iterator last, Reduce &reduce, Transform &transform, std::false_type) {
+    T result = transform(*first);
+    for (++first; first != last; ++first) {
+        result = reduce(std::move(result), transform(*first));
+    }
+    return result;
+}
+
+template <typename Iterator, typename T, typename Reduce, typename Transform>
+T reduce_block(Iterator first, Iterator last, Reduce &, Transform &, std::true_type) {
+    return simd::sum(&*first, std::distance(first, last));
+}
+
+template <typename Iterator1, typename Iterator2, typename T, typename Reduce, typename Transform>
+T reduce_block(Iterator1 first1, Iterator1 last1, Iterator2 first2, Reduce &reduce, Transform &transform,
+               std::false_type) {
+    T result = transform(*first1, *first2);
+    for (++first1, ++first2; first1 != last1; ++first1, ++first2) {
+        result = reduce(std::move(result), transform(*first1, *first2));
+    }
+    return result;
+}
+
+template <typename Iterator1, typename Iterator2, typename T, typename Reduce, typename Transform>
+T reduce_block(Iterator1 first1, Iterator1 last1, Iterator2 first2, Reduce &, Transform &, std::true_type) {
+    return simd::dot(&*first1, &*first2, std::distance(first1, last1));
+}
+
+/// @brief 各块结果写入按缓存行隔开的槽位, 结束后按块号顺序与 init 合并
+/// @tparam Block T(std::size_t chunk), 块的起止迭代器由调用方用 chunk_starts 预先求出
+template <typename T, typename Reduce, typename Block>
+T reduce_chunks(PartitionPlan const &plan_, T init_, Reduce &reduce_, Block block_, Executor &executor_) {
+    if (!plan_.length) return init_;
+
+    std::vector<CachePadded<T>> partials(plan_.chunkCount);
+    run_partitioned(
+        plan_, [&](std::size_t chunk_, std::size_t, std::size_t) { partials[chunk_].value = block_(chunk_); },
+        executor_);
+
+    for (auto &partial : partials) {
+        init_ = reduce_(std::move(init_), std::move(partial.value));
+    }
+    return init_;
+}
+
+} // namespace reduce_detail
+
+/// @brief 并行 transform_reduce: init reduce transform(first[0]) reduce ... reduce transform(first[n-1])
+/// reduce 需满足结合律, 各块结果按块号顺序合并, 因此不要求交换律.
+/// transform 为 Identity、reduce 为加法且元素是连续存放的算术类型时, 块内使用 SIMD 求和.
+/// @tparam Iterator  至少为前向迭代器
+/// @param first
+/// @param last
+/// @param init        初始值
+/// @param reduce      二元归约运算
+/// @param transform   一元变换
+/// @param partitioner 划分策略
+/// @param executor    执行器, 默认共享的StealThreadPool
+/// @return T
+template <typename Iterator, typename T, typename Reduce, typename Transform>
+T parallel_transform_reduce(Iterator first, Iterator last, T init, Reduce reduce, Transform transform,
+                            Partitioner partitioner = Partitioner(), Executor &executor = default_executor()) {
+    using Simd = reduce_detail::use_simd_sum<Iterator, T, Reduce, Transform>;
+
+    PartitionPlan const         plan   = partitioner.plan(std::distance(first, last));
+    std::vector<Iterator> const starts = chunk_starts(plan, first);
+    return reduce_detail::reduce_chunks(
+        plan, std::move(init), reduce,
+        [&](std::size_t chunk_) {
+            return reduce_detail::reduce_block<Iterator, T>(starts[chunk_], starts[chunk_ + 1], reduce, transform,
+                                                            Simd());
+        },
+        executor);
+}
+
+/// @brief 两个区间的并行 transform_reduce, transform 为二元运算;
+/// reduce 为加法、transform 为乘法时即内积, 连续存放的算术类型走 SIMD
+template <typename Iterator1, typename Iterator2, typename T, typename Reduce, typename Transform>
+T parallel_transform_reduce(Iterator1 first1, Iterator1 last1, Iterator2 first2, T init, Reduce reduce,
+                            Transform transform, Partitioner partitioner = Partitioner(),
+                            Executor &executor = default_executor()) {
+    using Simd = reduce_detail::use_simd_dot<Iterator1, Iterator2, T, Reduce, Transform>;
+
+    PartitionPlan const          plan    = partitioner.plan(std::distance(first1, last1));
+    std::vector<Iterator1> const starts1 = chunk_starts(plan, first1);
+    std::vector<Iterator2> const starts2 = chunk_starts(plan, first2);
+    return reduce_detail::reduce_chunks(
+        plan, std::move(init), reduce,
+        [&](std::size_t chunk_) {
+            return reduce_detail::reduce_block<Iterator1, Iterator2, T>(starts1[chunk_], starts1[chunk_ + 1],
+                                                                        starts2[chunk_], reduce, transform, Simd());
+        },
+        executor);
+}
+
+/// @brief 并行 reduce, 即 transform 为 Identity 的 transform_reduce
+template <typename Iterator, typename T, typename Reduce = std::plus<>>
+T parallel_reduce(Iterator first, Iterator last, T init, Reduce reduce = Reduce(),
+                  Partitioner partitioner = Partitioner(), Executor &executor = default_executor()) {
+    return parallel_transform_reduce(first, last, std::move(init), reduce, Identity(), partitioner, executor);
+}
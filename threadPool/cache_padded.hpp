@@ -0,0 +1,18 @@
+#ifndef __CACHE_PADDED__
+#define __CACHE_PADDED__
+
+#include <cstddef>
+
+/// @brief 缓存行大小, x86 与多数 ARM 为 64 字节
+constexpr std::size_t kCacheLineSize = 64;
+
+/// @brief value 后补一整个缓存行, 数组中相邻元素的 value 之间至少隔 kCacheLineSize 字节,
+/// 无论数组起始地址是否对齐都不会落在同一缓存行, 不同线程各写一个元素时不会伪共享
+/// @tparam T
+template <typename T>
+struct CachePadded {
+    T    value;
+    char pad[kCacheLineSize];
+};
+
+#endif //__CACHE_PADDED__
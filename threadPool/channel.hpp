@@ -0,0 +1,477 @@
+#ifndef __CHANNEL__
+#define __CHANNEL__
+
+#include "queue_latency.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @brief 非阻塞 / 限时操作的结果
+enum class ChannelStatus {
+    Success,
+    Empty,   // try_receive: 当前没有数据
+    Full,    // try_send: 缓冲区已满 (无缓冲通道: 没有等待中的接收方)
+    Timeout, // *_for: 期限内未完成
+    Closed,  // 通道已关闭 (接收方向: 关闭且已取空)
+};
+
+namespace channel_detail {
+
+using Clock = std::chrono::steady_clock;
+
+/// @brief Select 的等待点: 一个 Select 同时挂在多个通道上, 任一通道有数据或关闭时被唤醒
+/// 锁顺序: 通道锁 -> 等待点锁, Select 线程持等待点锁时不会再去拿通道锁
+class SelectWaiter {
+public:
+    SelectWaiter()
+        : _signaled(false) {}
+
+    void notify() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _signaled = true;
+        _condv.notify_one();
+    }
+
+    /// @return 被唤醒返回 true, 到期返回 false
+    bool wait(Clock::time_point const *deadline_) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        bool const signaled = deadline_ ? _condv.wait_until(lock, *deadline_, [this]() { return _signaled; })
+                                        : (_condv.wait(lock, [this]() { return _signaled; }), true);
+        _signaled = false;
+        return signaled;
+    }
+
+private:
+    std::mutex              _mtx;
+    std::condition_variable _condv;
+    bool                    _signaled;
+};
+
+inline std::size_t round_up_pow2(std::size_t n_) {
+    std::size_t size = 1;
+    while (size < n_) size <<= 1;
+    return size;
+}
+
+} // namespace channel_detail
+
+/// @brief CSP 通道, 环形缓冲区 + 互斥锁, 全程移动语义
+/// 只在有线程等待时才 notify, 批量收发一次加锁搬运多条消息.
+/// capacity == 0 为无缓冲通道: send 在接收方取走值之后才返回, 同一时刻最多一个值在途.
+/// close() 后 send 失败, receive 取完剩余数据后失败.
+/// @tparam T 至少可移动构造; receive 系列要求可移动赋值
+template <typename T>
+class Channel {
+public:
+    explicit Channel(std::size_t capacity_ = 0)
+        : _capacity(capacity_)
+        , _limit(std::max<std::size_t>(capacity_, 1))
+        , _mask(channel_detail::round_up_pow2(_limit) - 1)
+        , _ring(new Slot[_mask + 1])
+#ifdef QUEUE_LATENCY_TRACKING
+        , _stamps(new std::uint64_t[_mask + 1])
+#endif
+        , _head(0)
+        , _tail(0)
+        , _sendWaiters(0)
+        , _recvWaiters(0)
+        , _closed(false) {}
+    Channel(const Channel &)            = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    ~Channel() {
+        for (; _head != _tail; ++_head) {
+            slot(_head)->~T();
+        }
+    }
+
+    /// @brief 阻塞发送, 通道关闭时返回 false
+    bool send(T const &value_) { return send_impl(value_, nullptr) == ChannelStatus::Success; }
+    bool send(T &&value_) { return send_impl(std::move(value_), nullptr) == ChannelStatus::Success; }
+
+    /// @brief 不阻塞; 失败时 value_ 保持原样
+    ChannelStatus try_send(T const &value_) { return try_send_impl(value_); }
+    ChannelStatus try_send(T &&value_) { return try_send_impl(std::move(value_)); }
+
+    /// @brief 最多等待 timeout_; 超时时 value_ 保持原样 (无缓冲通道上未被取走的值会撤回)
+    template <typename Rep, typename Period>
+    ChannelStatus send_for(T &&value_, std::chrono::duration<Rep, Period> const &timeout_) {
+        channel_detail::Clock::time_point const deadline = channel_detail::Clock::now() + timeout_;
+        return send_impl(std::move(value_), &deadline);
+    }
+    template <typename Rep, typename Period>
+    ChannelStatus send_for(T const &value_, std::chrono::duration<Rep, Period> const &timeout_) {
+        channel_detail::Clock::time_point const deadline = channel_detail::Clock::now() + timeout_;
+        return send_impl(value_, &deadline);
+    }
+
+    /// @brief 批量发送 first_ 起的 count_ 个元素(移动), 缓冲区有多少空位就一次搬多少
+    /// @return 实际发送的个数, 小于 count_ 说明中途关闭
+    template <typename InputIterator>
+    std::size_t send_n(InputIterator first_, std::size_t count_) {
+        if (_capacity == 0) {
+            std::size_t sent = 0;
+            for (; sent < count_ && send(std::move(*first_)); ++sent, ++first_) {
+            }
+            return sent;
+        }
+        std::size_t                  sent = 0;
+        std::unique_lock<std::mutex> lock(_mtx);
+        while (sent < count_) {
+            wait(lock, _condSend, _sendWaiters, [this]() { return _closed || !full(); }, nullptr);
+            if (_closed) break;
+            std::size_t const batch = std::min(count_ - sent, _limit - size_locked());
+            for (std::size_t i = 0; i < batch; ++i, ++first_) {
+                push_locked(std::move(*first_));
+            }
+            sent += batch;
+            notify_receivers(batch);
+        }
+        return sent;
+    }
+
+    /// @brief 阻塞接收, 通道关闭且已取空时返回 false
+    bool receive(T &value_) { return receive_impl(value_, nullptr) == ChannelStatus::Success; }
+
+    ChannelStatus try_receive(T &value_) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_head == _tail) return _closed ? ChannelStatus::Closed : ChannelStatus::Empty;
+        pop_locked(value_);
+        notify_senders(1);
+        return ChannelStatus::Success;
+    }
+
+    template <typename Rep, typename Period>
+    ChannelStatus receive_for(T &value_, std::chrono::duration<Rep, Period> const &timeout_) {
+        channel_detail::Clock::time_point const deadline = channel_detail::Clock::now() + timeout_;
+        return receive_impl(value_, &deadline);
+    }
+
+    /// @brief 阻塞到至少有一条数据, 然后一次取走至多 max_ 条
+    /// @return 取到的条数, 0 表示通道已关闭且取空
+    template <typename OutputIterator>
+    std::size_t receive_n(OutputIterator out_, std::size_t max_) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        wait(lock, _condRecv, _recvWaiters, [this]() { return _closed || _head != _tail; }, nullptr);
+        return drain_locked(out_, max_);
+    }
+
+    /// @brief 不阻塞, 取走当前已有的至多 max_ 条
+    template <typename OutputIterator>
+    std::size_t try_receive_n(OutputIterator out_, std::size_t max_) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return drain_locked(out_, max_);
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _closed = true;
+        _condSend.notify_all();
+        _condRecv.notify_all();
+        for (auto *selector : _selectors) {
+            selector->notify();
+        }
+    }
+
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _closed;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return size_locked();
+    }
+
+    std::size_t capacity() const { return _capacity; }
+
+    /// @brief 供 Select 挂载等待点: 之后每次有数据写入或关闭都会通知它
+    void attach(channel_detail::SelectWaiter *selector_) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _selectors.push_back(selector_);
+    }
+
+    void detach(channel_detail::SelectWaiter *selector_) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _selectors.erase(std::remove(_selectors.begin(), _selectors.end(), selector_), _selectors.end());
+    }
+
+#ifdef QUEUE_LATENCY_TRACKING
+    /// @brief 消息从写入缓冲区到被接收的等待时间分布 (纳秒)
+    latency::Snapshot latency_snapshot() const { return _latency.snapshot(); }
+    void              reset_latency() { _latency.reset(); }
+#endif
+
+private:
+    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    T          *slot(std::size_t index_) { return reinterpret_cast<T *>(&_ring[index_ & _mask]); }
+    std::size_t size_locked() const { return _tail - _head; }
+    bool        full() const { return size_locked() >= _limit; }
+
+    template <typename U>
+    void push_locked(U &&value_) {
+        new (slot(_tail)) T(std::forward<U>(value_));
+#ifdef QUEUE_LATENCY_TRACKING
+        _stamps[_tail & _mask] = latency::now_ns();
+#endif
+        ++_tail;
+    }
+
+    void pop_locked(T &value_) {
+        T *const item = slot(_head);
+        value_        = std::move(*item);
+        item->~T();
+        record_latency(_head);
+        ++_head;
+    }
+
+    template <typename OutputIterator>
+    std::size_t drain_locked(OutputIterator &out_, std::size_t max_) {
+        std::size_t const count = std::min(max_, size_locked());
+        for (std::size_t i = 0; i < count; ++i, ++_head) {
+            T *const item = slot(_head);
+            *out_         = std::move(*item);
+            ++out_;
+            item->~T();
+            record_latency(_head);
+        }
+        notify_senders(count);
+        return count;
+    }
+
+    /// @brief 记录 index_ 处消息的等待时间, 未开启统计时为空函数
+    void record_latency(std::size_t index_) {
+#ifdef QUEUE_LATENCY_TRACKING
+        _latency.record_since(_stamps[index_ & _mask]);
+#else
+        (void)index_;
+#endif
+    }
+
+    void notify_receivers(std::size_t count_) {
+        if (_recvWaiters) {
+            if (count_ > 1) {
+                _condRecv.notify_all();
+            } else {
+                _condRecv.notify_one();
+            }
+        }
+        for (auto *selector : _selectors) {
+            selector->notify();
+        }
+    }
+
+    void notify_senders(std::size_t count_) {
+        if (!_sendWaiters || !count_) return;
+        // 无缓冲通道上等"被取走"和等空位的发送方共用条件变量, 只能全部唤醒
+        if (count_ > 1 || _capacity == 0) {
+            _condSend.notify_all();
+        } else {
+            _condSend.notify_one();
+        }
+    }
+
+    /// @brief 带等待计数的条件等待, deadline_ 为空时不限时
+    /// @return 条件满足返回 true, 到期返回 false
+    template <typename Predicate>
+    static bool wait(std::unique_lock<std::mutex> &lock_, std::condition_variable &condv_, std::size_t &waiters_,
+                     Predicate pred_, channel_detail::Clock::time_point const *deadline_) {
+        if (pred_()) return true;
+        ++waiters_;
+        bool satisfied = true;
+        if (deadline_) {
+            satisfied = condv_.wait_until(lock_, *deadline_, pred_);
+        } else {
+            condv_.wait(lock_, pred_);
+        }
+        --waiters_;
+        return satisfied;
+    }
+
+    /// @brief 无缓冲发送超时撤回时把值还给调用方; const 引用的调用方本就保留着原值
+    static void give_back(T &target_, T &&value_) { target_ = std::move(value_); }
+    static void give_back(T const &, T &&) {}
+
+    template <typename U>
+    ChannelStatus send_impl(U &&value_, channel_detail::Clock::time_point const *deadline_) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        if (!wait(lock, _condSend, _sendWaiters, [this]() { return _closed || !full(); }, deadline_)) {
+            return ChannelStatus::Timeout;
+        }
+        if (_closed) return ChannelStatus::Closed;
+
+        std::size_t const ticket = _tail;
+        push_locked(std::forward<U>(value_));
+        notify_receivers(1);
+        if (_capacity != 0) return ChannelStatus::Success;
+
+        // 无缓冲: 等接收方取走; 关闭后剩余的值仍可被取走, 视为发送成功
+        if (!wait(lock, _condSend, _sendWaiters, [this, ticket]() { return _closed || _head > ticket; }, deadline_)) {
+            T *const item = slot(ticket);
+            give_back(value_, std::move(*item));
+            item->~T();
+            --_tail;
+            notify_senders(1);
+            return ChannelStatus::Timeout;
+        }
+        return ChannelStatus::Success;
+    }
+
+    template <typename U>
+    ChannelStatus try_send_impl(U &&value_) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_closed) return ChannelStatus::Closed;
+        if (full()) return ChannelStatus::Full;
+        // 无缓冲: 只有已经有接收方在等时才能交出去. 挂着的 Select 醒来后只取一个分支的值,
+        // 不能保证取走这一个, 所以不算作接收方
+        if (_capacity == 0 && _recvWaiters == 0) return ChannelStatus::Full;
+        push_locked(std::forward<U>(value_));
+        notify_receivers(1);
+        return ChannelStatus::Success;
+    }
+
+    ChannelStatus receive_impl(T &value_, channel_detail::Clock::time_point const *deadline_) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        if (!wait(lock, _condRecv, _recvWaiters, [this]() { return _closed || _head != _tail; }, deadline_)) {
+            return ChannelStatus::Timeout;
+        }
+        if (_head == _tail) return ChannelStatus::Closed;
+        pop_locked(value_);
+        notify_senders(1);
+        return ChannelStatus::Success;
+    }
+
+    std::size_t const                           _capacity;
+    std::size_t const                           _limit;
+    std::size_t const                           _mask;
+    std::unique_ptr<Slot[]>                     _ring;
+#ifdef QUEUE_LATENCY_TRACKING
+    std::unique_ptr<std::uint64_t[]> _stamps;
+    latency::Histogram               _latency;
+#endif
+    std::size_t                                 _head;
+    std::size_t                                 _tail;
+    std::size_t                                 _sendWaiters;
+    std::size_t                                 _recvWaiters;
+    bool                                        _closed;
+    mutable std::mutex                          _mtx;
+    std::condition_variable                     _condSend;
+    std::condition_variable                     _condRecv;
+    std::vector<channel_detail::SelectWaiter *> _selectors;
+};
+
+/// @brief 在多个通道上同时等待接收, 不需要为每个通道开线程
+/// 先轮询各通道 (起点轮转, 避免总偏向第一个), 都没有数据时把同一个等待点挂到所有通道上再等.
+/// @code
+///     Select select;
+///     select.on_receive(numbers, [](int n) { ... }).on_receive(words, [](std::string w) { ... });
+///     while (select.wait() != Select::kClosed) {}
+/// @endcode
+class Select {
+public:
+    enum : std::size_t {
+        kTimeout = static_cast<std::size_t>(-1), // wait_for 到期 / try_select 没有就绪的通道
+        kClosed  = static_cast<std::size_t>(-2), // 所有通道都已关闭且取空
+    };
+
+    Select()
+        : _next(0) {}
+    Select(const Select &)            = delete;
+    Select &operator=(const Select &) = delete;
+
+    /// @brief 登记一个接收分支, 收到值时在调用 wait 的线程上执行 handler_(T)
+    template <typename T, typename Handler>
+    Select &on_receive(Channel<T> &channel_, Handler handler_) {
+        _cases.emplace_back(new ReceiveCase<T, Handler>(channel_, std::move(handler_)));
+        return *this;
+    }
+
+    /// @brief 阻塞到某个分支收到值
+    /// @return 执行的分支下标, 或 kClosed
+    std::size_t wait() { return run(nullptr); }
+
+    template <typename Rep, typename Period>
+    std::size_t wait_for(std::chrono::duration<Rep, Period> const &timeout_) {
+        channel_detail::Clock::time_point const deadline = channel_detail::Clock::now() + timeout_;
+        return run(&deadline);
+    }
+
+    /// @brief 不阻塞
+    std::size_t try_select() { return poll(); }
+
+private:
+    struct CaseBase {
+        virtual ~CaseBase() {}
+        virtual ChannelStatus fire()                                   = 0;
+        virtual void          attach(channel_detail::SelectWaiter *w_) = 0;
+        virtual void          detach(channel_detail::SelectWaiter *w_) = 0;
+    };
+
+    template <typename T, typename Handler>
+    struct ReceiveCase : CaseBase {
+        ReceiveCase(Channel<T> &channel_, Handler handler_)
+            : channel(channel_)
+            , handler(std::move(handler_)) {}
+
+        ChannelStatus fire() override {
+            T                   value;
+            ChannelStatus const status = channel.try_receive(value);
+            if (status == ChannelStatus::Success) handler(std::move(value));
+            return status;
+        }
+        void attach(channel_detail::SelectWaiter *w_) override { channel.attach(w_); }
+        void detach(channel_detail::SelectWaiter *w_) override { channel.detach(w_); }
+
+        Channel<T> &channel;
+        Handler     handler;
+    };
+
+    std::size_t poll() {
+        std::size_t const count  = _cases.size();
+        std::size_t       closed = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t const   index  = (_next + i) % count;
+            ChannelStatus const status = _cases[index]->fire();
+            if (status == ChannelStatus::Success) {
+                _next = index + 1;
+                return index;
+            }
+            if (status == ChannelStatus::Closed) ++closed;
+        }
+        return closed == count ? kClosed : kTimeout;
+    }
+
+    std::size_t run(channel_detail::Clock::time_point const *deadline_) {
+        for (;;) {
+            std::size_t result = poll();
+            if (result != kTimeout) return result;
+
+            channel_detail::SelectWaiter waiter;
+            for (auto &branch : _cases) {
+                branch->attach(&waiter);
+            }
+            // 挂载前写入的数据不会通知等待点, 挂载后再查一次
+            result       = poll();
+            bool expired = false;
+            if (result == kTimeout) expired = !waiter.wait(deadline_);
+            for (auto &branch : _cases) {
+                branch->detach(&waiter);
+            }
+            if (result != kTimeout) return result;
+            if (expired) return poll();
+        }
+    }
+
+    std::vector<std::unique_ptr<CaseBase>> _cases;
+    std::size_t                            _next;
+};
+
+#endif //__CHANNEL__
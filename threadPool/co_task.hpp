@@ -0,0 +1,271 @@
+#ifndef __CO_TASK__
+#define __CO_TASK__
+
+// 协程任务需要 C++20 (cmake -DCONCURRENCY_CPP20=ON), C++14 下本头文件为空
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define CO_TASK_ENABLED 1
+#endif
+#endif
+
+#ifdef CO_TASK_ENABLED
+
+#include "executor.hpp"
+#include "wait_group.hpp"
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+template <typename T = void>
+class CoTask;
+
+namespace co_detail {
+
+/// @brief 任务状态: 运行中 / 已有等待者 / 已结束 / 所有者已放弃(结束时自行销毁协程帧)
+enum TaskState : int { kRunning = 0, kAwaited = 1, kDone = 2, kDetached = 3 };
+
+class PromiseBase {
+public:
+    /// @brief 结束时与等待者交换状态: 等待者先到则对称转移回等待者, 否则挂起等它来取结果
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle_) noexcept {
+            PromiseBase &promise  = handle_.promise();
+            int const    previous = promise.state.exchange(kDone, std::memory_order_acq_rel);
+            if (previous == kAwaited) return promise.continuation;
+            if (previous == kDetached) handle_.destroy();
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    /// @brief 惰性启动: co_await 或 spawn 时才开始执行
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter        final_suspend() const noexcept { return {}; }
+    void                unhandled_exception() noexcept { exception = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr      exception;
+    std::atomic<int>        state{kRunning};
+    bool                    started = false;
+};
+
+template <typename T>
+class Promise : public PromiseBase {
+public:
+    CoTask<T> get_return_object() noexcept;
+
+    void return_value(T value_) { _value.emplace(std::move(value_)); }
+
+    T result() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*_value);
+    }
+
+private:
+    std::optional<T> _value;
+};
+
+template <>
+class Promise<void> : public PromiseBase {
+public:
+    CoTask<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+} // namespace co_detail
+
+/// @brief 可 co_await 的惰性协程任务
+/// co_await 未启动的任务时以对称转移直接切入子任务, 子任务结束再转移回来, 调用链多深都不增长栈
+/// (依赖编译器把对称转移编译成尾调用, GCC 需开启优化);
+/// spawn 后任务在线程池上并发执行, 稍后 co_await 时若未结束则挂起, 由子任务结束的线程恢复等待者.
+/// 已启动但没等到结果就析构的任务, 结束时自行销毁协程帧.
+/// @tparam T 结果类型
+template <typename T>
+class CoTask {
+public:
+    using promise_type = co_detail::Promise<T>;
+    using Handle       = std::coroutine_handle<promise_type>;
+
+    class ReadyAwaiter {
+    public:
+        explicit ReadyAwaiter(Handle handle_) noexcept
+            : _handle(handle_) {}
+
+        bool await_ready() const noexcept { return !_handle; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting_) noexcept {
+            promise_type &promise = _handle.promise();
+            promise.continuation  = awaiting_;
+            if (!promise.started) {
+                promise.started = true;
+                promise.state.store(co_detail::kAwaited, std::memory_order_relaxed);
+                return _handle;
+            }
+            // 已结束时保持 kDone, 析构时才会销毁协程帧
+            int expected = co_detail::kRunning;
+            if (promise.state.compare_exchange_strong(expected, co_detail::kAwaited, std::memory_order_acq_rel,
+                                                      std::memory_order_acquire)) {
+                return std::noop_coroutine();
+            }
+            return awaiting_;
+        }
+
+        void await_resume() const noexcept {}
+
+    protected:
+        Handle _handle;
+    };
+
+    class Awaiter : public ReadyAwaiter {
+    public:
+        using ReadyAwaiter::ReadyAwaiter;
+
+        T await_resume() {
+            if (!this->_handle) throw std::logic_error("CoTask: awaiting an empty task");
+            return this->_handle.promise().result();
+        }
+    };
+
+    CoTask() noexcept = default;
+    explicit CoTask(Handle handle_) noexcept
+        : _handle(handle_) {}
+    CoTask(CoTask &&other_) noexcept
+        : _handle(std::exchange(other_._handle, {})) {}
+    CoTask &operator=(CoTask &&other_) noexcept {
+        if (this != &other_) {
+            release();
+            _handle = std::exchange(other_._handle, {});
+        }
+        return *this;
+    }
+    CoTask(const CoTask &)            = delete;
+    CoTask &operator=(const CoTask &) = delete;
+    ~CoTask() { release(); }
+
+    bool valid() const noexcept { return static_cast<bool>(_handle); }
+
+    /// @brief 是否已执行完毕 (结果或异常已就绪)
+    bool done() const noexcept {
+        return _handle && _handle.promise().state.load(std::memory_order_acquire) == co_detail::kDone;
+    }
+
+    /// @brief 在 scheduler_ 上开始执行, 之后仍需 co_await 取结果
+    /// @tparam Scheduler 提供 post(可调用对象), 如 Executor / StealThreadPool
+    template <typename Scheduler>
+    void start_on(Scheduler &scheduler_) {
+        if (!_handle || _handle.promise().started) throw std::logic_error("CoTask: task already started");
+        Handle handle             = _handle;
+        _handle.promise().started = true;
+        try {
+            scheduler_.post([handle]() { handle.resume(); });
+        } catch (...) {
+            _handle.promise().started = false;
+            throw;
+        }
+    }
+
+    Awaiter operator co_await() const noexcept { return Awaiter(_handle); }
+
+    /// @brief 只等待结束, 不取结果也不抛出任务中的异常
+    ReadyAwaiter when_ready() const noexcept { return ReadyAwaiter(_handle); }
+
+private:
+    void release() noexcept {
+        if (!_handle) return;
+        promise_type &promise = _handle.promise();
+        if (promise.started &&
+            promise.state.exchange(co_detail::kDetached, std::memory_order_acq_rel) != co_detail::kDone) {
+            _handle = nullptr; // 仍在运行, 由 FinalAwaiter 销毁
+            return;
+        }
+        _handle.destroy();
+        _handle = nullptr;
+    }
+
+    Handle _handle;
+};
+
+namespace co_detail {
+
+template <typename T>
+CoTask<T> Promise<T>::get_return_object() noexcept {
+    return CoTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline CoTask<void> Promise<void>::get_return_object() noexcept {
+    return CoTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+/// @brief 立即执行、结束时自行销毁的协程, 仅供 sync_wait 使用
+struct Detached {
+    struct promise_type {
+        Detached           get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void               return_void() const noexcept {}
+        void               unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+template <typename T>
+Detached notify_when_ready(CoTask<T> &task_, WaitGroup &group_) {
+    co_await task_.when_ready();
+    group_.done();
+}
+
+} // namespace co_detail
+
+/// @brief 挂起当前协程, 把恢复操作投递给 scheduler_, 之后的代码在其线程上执行
+template <typename Scheduler>
+class ScheduleAwaiter {
+public:
+    explicit ScheduleAwaiter(Scheduler &scheduler_) noexcept
+        : _scheduler(scheduler_) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle_) { _scheduler.post([handle_]() { handle_.resume(); }); }
+    void await_resume() const noexcept {}
+
+private:
+    Scheduler &_scheduler;
+};
+
+/// @brief co_await schedule_on(pool) 切换到线程池上继续执行
+template <typename Scheduler>
+ScheduleAwaiter<Scheduler> schedule_on(Scheduler &scheduler_) noexcept {
+    return ScheduleAwaiter<Scheduler>(scheduler_);
+}
+
+/// @brief 在 scheduler_ 上启动 task_ 并返回它, 调用方继续做自己的事, 之后再 co_await 汇合
+template <typename T, typename Scheduler>
+CoTask<T> spawn(CoTask<T> task_, Scheduler &scheduler_) {
+    task_.start_on(scheduler_);
+    return task_;
+}
+
+/// @brief 在非协程代码中运行 task_ 并取结果, 等待期间帮 scheduler_ 执行排队任务
+/// @tparam Scheduler 提供 run_pending_task()
+template <typename T, typename Scheduler = Executor>
+T sync_wait(CoTask<T> task_, Scheduler &scheduler_ = default_executor()) {
+    WaitGroup group;
+    group.add();
+    co_detail::notify_when_ready(task_, group);
+    group.wait([&scheduler_]() { return scheduler_.run_pending_task(); });
+    return task_.operator co_await().await_resume();
+}
+
+#endif // CO_TASK_ENABLED
+
+#endif //__CO_TASK__
@@ -0,0 +1,299 @@
+#ifndef __CONCURRENT_CACHE__
+#define __CONCURRENT_CACHE__
+
+#include "profiled_mutex.hpp"
+#include "sharded_counter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#if __cplusplus >= 201703L
+using CacheSharedMutex = std::shared_mutex;
+#else
+using CacheSharedMutex = std::shared_timed_mutex;
+#endif
+
+struct CacheStats {
+    std::uint64_t hits        = 0;
+    std::uint64_t misses      = 0; // 含过期
+    std::uint64_t evictions   = 0; // 因容量被淘汰
+    std::uint64_t expirations = 0; // 因 TTL 被删除
+
+    double hit_ratio() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0; }
+};
+
+/// @brief 分片的 CLOCK 淘汰缓存: 与 ThreadSafeLookUpTable 一样按 hash(key) % 分片数 分桶, 每个分片一把读写锁.
+/// 命中只在分片的共享锁下把条目的引用位置 1, 不挪动链表, 命中之间不互斥, 也没有全局链表锁;
+/// 插入在分片的独占锁下进行, 超出容量时时钟指针转过链表, 清掉引用位, 淘汰第一个没被再次访问 (或已过期) 的条目.
+/// 容量按条目计, 或给出 weigher 按字节等自定义权重计 (权重为 0 的条目按 1 计, 否则条目数不受限);
+/// 容量分给各分片, 各分片之和恰好是总容量, 单个条目不能超过一个分片的容量.
+/// 分片数默认与 ThreadSafeLookUpTable 的桶数相同, 取质数: 整数键的 std::hash 是恒等映射, 取余 2 的幂只看低位.
+/// @tparam Hash 分片选择与分片内索引共用
+/// @tparam SharedMutex 分片锁, 换成 ProfiledMutex<CacheSharedMutex> 可统计锁竞争
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename SharedMutex = CacheSharedMutex>
+class ConcurrentCache {
+public:
+    using clock_type = std::chrono::steady_clock;
+    /// @brief 条目权重, 为空时每个条目计 1
+    using Weigher = std::function<std::size_t(Key const &, Value const &)>;
+
+    static constexpr unsigned kDefaultShards = 23;
+
+    /// @param capacity_ 总容量 (条目数, 或 weigher 的权重之和)
+    /// @param ttl_ 条目存活时间, 为 0 时不过期
+    /// @param num_shards_ 分片数, 限制在 [1, capacity_] 内, 容量不为 0 时每个分片至少能放一个条目
+    ConcurrentCache(std::size_t capacity_, clock_type::duration ttl_ = clock_type::duration::zero(),
+                    Weigher weigher_ = Weigher(), unsigned num_shards_ = kDefaultShards, Hash const &hasher_ = Hash())
+        : _vecShards(std::max<std::size_t>(1, std::min<std::size_t>(num_shards_, capacity_)))
+        , _ttl(ttl_)
+        , _weigher(std::move(weigher_))
+        , _hasher(hasher_) {
+        // 余数分给前几个分片
+        std::size_t const shards    = _vecShards.size();
+        std::size_t const base      = capacity_ / shards;
+        std::size_t const remainder = capacity_ % shards;
+        for (std::size_t i = 0; i < shards; ++i) {
+            _vecShards[i].reset(new Shard(base + (i < remainder ? 1 : 0), _hasher));
+        }
+    }
+
+    ConcurrentCache(const ConcurrentCache &)            = delete;
+    ConcurrentCache &operator=(const ConcurrentCache &) = delete;
+
+    /// @brief 命中时拷贝到 value_
+    bool get(Key const &key_, Value &value_) {
+        Shard &shard = get_shard(key_);
+        switch (shard.get(key_, value_, _ttl != clock_type::duration::zero())) {
+        case Lookup::hit:
+            _hits.add();
+            return true;
+        case Lookup::expired:
+            if (shard.erase_expired(key_)) _expirations.add();
+            break;
+        case Lookup::miss:
+            break;
+        }
+        _misses.add();
+        return false;
+    }
+
+    Value value_for(Key const &key_, Value const &default_value_ = Value()) {
+        Value value;
+        return get(key_, value) ? value : default_value_;
+    }
+
+    /// @brief 添加或覆盖
+    /// @return 条目权重超过分片容量时返回 false, 不缓存 (同 key 的旧值也被删除)
+    bool put(Key const &key_, Value const &value_) {
+        std::size_t const            charge = _weigher ? std::max<std::size_t>(1, _weigher(key_, value_)) : 1;
+        clock_type::time_point const expires =
+            _ttl == clock_type::duration::zero() ? clock_type::time_point::max() : clock_type::now() + _ttl;
+        std::size_t const evicted = get_shard(key_).put(key_, value_, charge, expires);
+        if (evicted == kRejected) return false;
+        if (evicted) _evictions.add(evicted);
+        return true;
+    }
+
+    /// @brief 命中直接返回, 否则调用 load_(key_) 并缓存结果.
+    /// 加载在锁外进行, 同一 key 同时未命中时会各自加载一次
+    template <typename Load>
+    Value get_or_load(Key const &key_, Load load_) {
+        Value value;
+        if (get(key_, value)) return value;
+        value = load_(key_);
+        put(key_, value);
+        return value;
+    }
+
+    bool erase(Key const &key_) { return get_shard(key_).erase(key_); }
+
+    void clear() {
+        for (auto &shard : _vecShards) shard->clear();
+    }
+
+    /// @brief 条目数, 并发修改时是近似值
+    std::size_t size() const {
+        std::size_t count = 0;
+        for (auto const &shard : _vecShards) count += shard->size();
+        return count;
+    }
+
+    /// @brief 权重之和, 并发修改时是近似值
+    std::size_t usage() const {
+        std::size_t total = 0;
+        for (auto const &shard : _vecShards) total += shard->usage();
+        return total;
+    }
+
+    CacheStats stats() const {
+        CacheStats stats;
+        stats.hits        = _hits.load();
+        stats.misses      = _misses.load();
+        stats.evictions   = _evictions.load();
+        stats.expirations = _expirations.load();
+        return stats;
+    }
+
+private:
+    static constexpr std::size_t kRejected = static_cast<std::size_t>(-1);
+
+    enum class Lookup { hit, miss, expired };
+
+    class Shard {
+        struct Entry {
+            Entry(Key const &key_, Value const &value_, std::size_t charge_, clock_type::time_point expires_)
+                : key(key_)
+                , value(value_)
+                , charge(charge_)
+                , expires(expires_)
+                , referenced(false) {}
+
+            Key const              key;
+            Value                  value;
+            std::size_t            charge;
+            clock_type::time_point expires;
+            std::atomic<bool>      referenced; // 命中时在共享锁下置位
+        };
+
+        using entry_list     = std::list<Entry>;
+        using entry_iterator = typename entry_list::iterator;
+
+    public:
+        Shard(std::size_t capacity_, Hash const &hasher_)
+            : _capacity(capacity_)
+            , _usage(0)
+            , _index(0, hasher_)
+            , _hand(_entries.end()) {
+            name_lock(_smtx, "ConcurrentCache::shard");
+        }
+
+        Lookup get(Key const &key_, Value &value_, bool check_expiry_) const {
+            std::shared_lock<SharedMutex> shared_lock(_smtx);
+            auto const                    found = _index.find(key_);
+            if (found == _index.end()) return Lookup::miss;
+            Entry &entry = *found->second;
+            if (check_expiry_ && entry.expires <= clock_type::now()) return Lookup::expired;
+            // 已置位时不再写, 热点条目的缓存行不会在读者之间来回搬
+            if (!entry.referenced.load(std::memory_order_relaxed)) {
+                entry.referenced.store(true, std::memory_order_relaxed);
+            }
+            value_ = entry.value;
+            return Lookup::hit;
+        }
+
+        /// @return 淘汰的条目数, 或 kRejected
+        std::size_t put(Key const &key_, Value const &value_, std::size_t charge_, clock_type::time_point expires_) {
+            std::unique_lock<SharedMutex> unique_lock(_smtx);
+            auto const                    found = _index.find(key_);
+            if (found != _index.end()) remove(found->second);
+            if (charge_ > _capacity) return kRejected;
+
+            std::size_t                  evicted = 0;
+            clock_type::time_point const now     = clock_type::now();
+            while (_usage + charge_ > _capacity) {
+                evict_one(now);
+                ++evicted;
+            }
+            // 插在指针之前, 新条目要等指针转完一圈才会被考察
+            entry_iterator const entry = _entries.emplace(_hand, key_, value_, charge_, expires_);
+            _index.emplace(key_, entry);
+            _usage += charge_;
+            return evicted;
+        }
+
+        bool erase(Key const &key_) {
+            std::unique_lock<SharedMutex> unique_lock(_smtx);
+            auto const                    found = _index.find(key_);
+            if (found == _index.end()) return false;
+            remove(found->second);
+            return true;
+        }
+
+        /// @brief 共享锁下发现过期后, 换独占锁再确认一次
+        bool erase_expired(Key const &key_) {
+            std::unique_lock<SharedMutex> unique_lock(_smtx);
+            auto const                    found = _index.find(key_);
+            if (found == _index.end() || found->second->expires > clock_type::now()) return false;
+            remove(found->second);
+            return true;
+        }
+
+        void clear() {
+            std::unique_lock<SharedMutex> unique_lock(_smtx);
+            _index.clear();
+            _entries.clear();
+            _hand  = _entries.end();
+            _usage = 0;
+        }
+
+        std::size_t size() const {
+            std::shared_lock<SharedMutex> shared_lock(_smtx);
+            return _entries.size();
+        }
+
+        std::size_t usage() const {
+            std::shared_lock<SharedMutex> shared_lock(_smtx);
+            return _usage;
+        }
+
+    private:
+        /// @brief 持独占锁, 链表非空时调用; 每个条目最多看两遍, 第二遍时引用位都已清掉
+        void evict_one(clock_type::time_point now_) {
+            for (;;) {
+                if (_hand == _entries.end()) _hand = _entries.begin();
+                Entry &entry = *_hand;
+                if (entry.referenced.load(std::memory_order_relaxed) && entry.expires > now_) {
+                    entry.referenced.store(false, std::memory_order_relaxed);
+                    ++_hand;
+                    continue;
+                }
+                remove(_hand);
+                return;
+            }
+        }
+
+        /// @brief 持独占锁调用, 删除的是指针所指条目时指针移到下一个
+        void remove(entry_iterator entry_) {
+            _index.erase(entry_->key);
+            _usage -= entry_->charge;
+            if (_hand == entry_) {
+                _hand = _entries.erase(entry_);
+            } else {
+                _entries.erase(entry_);
+            }
+        }
+
+        std::size_t const                             _capacity;
+        std::size_t                                   _usage;
+        entry_list                                    _entries; // 时钟环, 指针走到末尾回到开头
+        std::unordered_map<Key, entry_iterator, Hash> _index;
+        entry_iterator                                _hand;
+        mutable SharedMutex                           _smtx;
+    };
+
+    /// @brief 与 ThreadSafeLookUpTable::get_bucket 相同: hash(key) 对分片数取余
+    Shard &get_shard(Key const &key_) const {
+        std::size_t const shard_idx = _hasher(key_) % _vecShards.size();
+        return *_vecShards[shard_idx];
+    }
+
+    std::vector<std::unique_ptr<Shard>> _vecShards;
+    clock_type::duration const          _ttl;
+    Weigher const                       _weigher;
+    Hash                                _hasher;
+    ShardedCounter                      _hits;
+    ShardedCounter                      _misses;
+    ShardedCounter                      _evictions;
+    ShardedCounter                      _expirations;
+};
+
+#endif //__CONCURRENT_CACHE__
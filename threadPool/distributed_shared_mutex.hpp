@@ -0,0 +1,88 @@
+#ifndef __DISTRIBUTED_SHARED_MUTEX__
+#define __DISTRIBUTED_SHARED_MUTEX__
+
+#include "cache_padded.hpp"
+#include "sharded_counter.hpp"
+#include "spin_lock.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/// @brief 分布式读写锁: 每个线程在自己的分片上登记读者, 读者之间不写同一缓存行; 写者置位后扫描全部分片等读者退出.
+/// 读加锁是本分片上的一次原子加加一次读, 读多写少时吞吐随核数增长; 代价是写加锁要扫 Slots 个缓存行.
+/// 满足 SharedLockable, 可替换 std::shared_mutex, 用于 DNService / ThreadSafeLookUpTable.
+/// 写者优先: 写者置位后新来的读者让路, 读者不会饿死写者.
+/// @tparam Slots 读者分片数, 线程数超过时多个线程共用一片, 结果仍然正确
+template <std::size_t Slots = 16>
+class BasicDistributedSharedMutex {
+public:
+    BasicDistributedSharedMutex()
+        : _writer(false) {
+        for (auto &slot : _readers) slot.value.store(0, std::memory_order_relaxed);
+    }
+    BasicDistributedSharedMutex(const BasicDistributedSharedMutex &)            = delete;
+    BasicDistributedSharedMutex &operator=(const BasicDistributedSharedMutex &) = delete;
+
+    void lock_shared() {
+        std::atomic<std::uint32_t> &slot = local_slot();
+        Backoff                     backoff;
+        for (;;) {
+            // seq_cst: 要么写者扫描时看到这次登记, 要么这里看到写者已置位
+            slot.fetch_add(1, std::memory_order_seq_cst);
+            if (!_writer.load(std::memory_order_seq_cst)) return;
+            slot.fetch_sub(1, std::memory_order_release);
+            while (_writer.load(std::memory_order_relaxed)) backoff.pause();
+        }
+    }
+
+    bool try_lock_shared() {
+        std::atomic<std::uint32_t> &slot = local_slot();
+        slot.fetch_add(1, std::memory_order_seq_cst);
+        if (!_writer.load(std::memory_order_seq_cst)) return true;
+        slot.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    /// 写者按各分片之和判断, 在别的线程上释放读锁 (分片不同) 也正确
+    void unlock_shared() { local_slot().fetch_sub(1, std::memory_order_release); }
+
+    void lock() {
+        _writerMtx.lock();
+        _writer.store(true, std::memory_order_seq_cst);
+        Backoff backoff;
+        while (readers() != 0) backoff.pause();
+    }
+
+    bool try_lock() {
+        if (!_writerMtx.try_lock()) return false;
+        _writer.store(true, std::memory_order_seq_cst);
+        if (readers() == 0) return true;
+        _writer.store(false, std::memory_order_release);
+        _writerMtx.unlock();
+        return false;
+    }
+
+    void unlock() {
+        _writer.store(false, std::memory_order_release);
+        _writerMtx.unlock();
+    }
+
+private:
+    std::atomic<std::uint32_t> &local_slot() { return _readers[thread_shard_index() % Slots].value; }
+
+    /// @brief 读者总数; 单个分片可能因跨线程释放而回绕, 只看总和
+    std::uint32_t readers() const {
+        std::uint32_t sum = 0;
+        for (auto const &slot : _readers) sum += slot.value.load(std::memory_order_seq_cst);
+        return sum;
+    }
+
+    CachePadded<std::atomic<std::uint32_t>> _readers[Slots];
+    std::atomic<bool>                       _writer;
+    std::mutex                              _writerMtx; // 写者之间互斥
+};
+
+using DistributedSharedMutex = BasicDistributedSharedMutex<>;
+
+#endif //__DISTRIBUTED_SHARED_MUTEX__
@@ -0,0 +1,73 @@
+#ifndef __EVENT_COUNT__
+#define __EVENT_COUNT__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/// @brief 事件计数: 让无锁结构也能阻塞等待, 没有等待者时通知只是一次原子读
+/// 等待方协议:
+///     auto key = ec.prepare_wait();
+///     if (条件已满足) { ec.cancel_wait(); return; }
+///     ec.wait(key);
+/// 通知方在让条件成立之后调用 notify_one / notify_all.
+/// prepare_wait 登记之后的通知都会改变纪元, wait 不会错过它.
+class EventCount {
+public:
+    using Key = std::uint32_t;
+
+    EventCount()
+        : _state(0) {}
+    EventCount(const EventCount &)            = delete;
+    EventCount &operator=(const EventCount &) = delete;
+
+    Key prepare_wait() {
+        std::uint64_t const previous = _state.fetch_add(kWaiterInc, std::memory_order_seq_cst);
+        // 与通知方的栅栏配对: 要么通知方看到等待者, 要么等待方重新检查时看到条件成立
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return static_cast<Key>(previous >> kEpochShift);
+    }
+
+    void cancel_wait() { _state.fetch_sub(kWaiterInc, std::memory_order_seq_cst); }
+
+    void wait(Key key_) {
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _condv.wait(lock, [this, key_]() { return epoch() != key_; });
+        }
+        _state.fetch_sub(kWaiterInc, std::memory_order_seq_cst);
+    }
+
+    void notify_one() { notify(false); }
+    void notify_all() { notify(true); }
+
+private:
+    static constexpr std::uint64_t kWaiterInc  = 1;
+    static constexpr std::uint64_t kWaiterMask = 0xffffffffu;
+    static constexpr int           kEpochShift = 32;
+    static constexpr std::uint64_t kEpochInc   = std::uint64_t(1) << kEpochShift;
+
+    Key epoch() const { return static_cast<Key>(_state.load(std::memory_order_acquire) >> kEpochShift); }
+
+    void notify(bool all_) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((_state.load(std::memory_order_relaxed) & kWaiterMask) == 0) return;
+        {
+            // 持锁推进纪元, 等待方检查谓词与进入睡眠之间不会漏掉
+            std::lock_guard<std::mutex> lock(_mtx);
+            _state.fetch_add(kEpochInc, std::memory_order_seq_cst);
+        }
+        if (all_) {
+            _condv.notify_all();
+        } else {
+            _condv.notify_one();
+        }
+    }
+
+    std::atomic<std::uint64_t> _state; // 高 32 位纪元, 低 32 位等待者数
+    std::mutex                 _mtx;
+    std::condition_variable    _condv;
+};
+
+#endif //__EVENT_COUNT__
@@ -0,0 +1,63 @@
+#ifndef __EXECUTOR__
+#define __EXECUTOR__
+
+#include "future_thread_pool.hpp"
+#include "steal_thread_pool.hpp"
+#include <cstddef>
+#include <thread>
+
+/// @brief 并行算法投递任务的接口
+/// 算法只需要"把任务交出去"和"等待时帮忙跑一个任务", 具体由哪个线程池执行由调用方决定
+class Executor {
+public:
+    virtual ~Executor() {}
+
+    virtual void post(FunctionWrapper task_) = 0;
+
+    /// @brief 在调用线程上执行一个排队任务
+    /// @return 没有可执行的任务时返回false
+    virtual bool run_pending_task() { return false; }
+
+    /// @brief 可同时执行任务的线程数
+    virtual std::size_t concurrency() const = 0;
+};
+
+/// @brief 把任务转交给线程池, Pool 需提供 post / run_pending_task / thread_count
+/// @tparam Pool
+template <typename Pool>
+class PoolExecutor : public Executor {
+public:
+    explicit PoolExecutor(Pool &pool_)
+        : _pool(pool_) {}
+
+    void        post(FunctionWrapper task_) override { _pool.post(std::move(task_)); }
+    bool        run_pending_task() override { return _pool.run_pending_task(); }
+    std::size_t concurrency() const override { return _pool.thread_count(); }
+
+private:
+    Pool &_pool;
+};
+
+/// @brief 每个任务新建一个分离线程, 即改用线程池之前的做法, 用于对比
+class ThreadExecutor : public Executor {
+public:
+    static ThreadExecutor &instance() {
+        static ThreadExecutor executor;
+        return executor;
+    }
+
+    void post(FunctionWrapper task_) override { std::thread(std::move(task_)).detach(); }
+
+    std::size_t concurrency() const override {
+        unsigned long const hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads != 0 ? hardwareThreads : 2;
+    }
+};
+
+/// @brief 默认执行器: 全局共享的 StealThreadPool
+inline Executor &default_executor() {
+    static PoolExecutor<StealThreadPool> executor(StealThreadPool::instance());
+    return executor;
+}
+
+#endif //__EXECUTOR__
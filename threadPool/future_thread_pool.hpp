@@ -9,6 +9,7 @@
 #define __FUTURE_THREAD_POOL__
 
 #include "join_thread.hpp"
+#include "task_trace.hpp"
 #include "thread_safe_queue.hpp"
 #include <future>
 #include <memory>
@@ -55,6 +56,7 @@ private:
     ThreadSafeQueue<FunctionWrapper> _workQueue;
     std::vector<std::thread>         _threads;
     JoinThread                       _joiner;
+    trace::TaskTracer                _tracer;
 
 public:
     static FutureThreadPool &instance() {
@@ -72,20 +74,24 @@ public:
     std::future<typename std::result_of<FunctionType()>::type> submit(FunctionType f) {
         using resultType = typename std::result_of<FunctionType()>::type;
         // using resultType = decltype(f());
-        std::packaged_task<resultType()> task(std::move(f));
+        std::packaged_task<resultType()> task(_tracer.wrap(std::move(f)));
         std::future<resultType>          res(task.get_future());
         _workQueue.push(std::move(task));
         return res;
     }
 
+    /// @brief 逐任务调度记录, 需定义 POOL_TASK_TRACING
+    trace::TaskTracer &tracer() { return _tracer; }
+
 private:
     FutureThreadPool()
         : _doneFlag(false)
-        , _joiner(_threads) {
+        , _joiner(_threads)
+        , _tracer(std::thread::hardware_concurrency()) {
         size_t const threadCount = std::thread::hardware_concurrency();
         try {
             for (size_t i = 0; i < threadCount; ++i) {
-                _threads.push_back(std::thread(&FutureThreadPool::work_thread, this));
+                _threads.push_back(std::thread(&FutureThreadPool::work_thread, this, i));
             }
         } catch (const std::exception &e) {
             _doneFlag = true;
@@ -93,7 +99,8 @@ private:
         }
     }
 
-    void work_thread() {
+    void work_thread(size_t index_) {
+        _tracer.bind_worker(index_);
         while (!_doneFlag) {
             FunctionWrapper task;
             if (_workQueue.try_pop(task)) {
@@ -0,0 +1,187 @@
+#ifndef __HAZARD_POINTER__
+#define __HAZARD_POINTER__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/// @brief 危险指针: 无锁结构中被摘下的结点先 retire, 确认没有线程还在读它之后再释放
+/// 每个线程占用一条记录 (kSlotsPerThread 个槽位), 读共享指针前先 protect 到槽位里;
+/// retire 的结点攒够一批后扫描所有槽位, 不在其中的才真正删除. 线程退出时未能删除的结点交给全局列表, 由其他线程接手.
+namespace hazard {
+
+constexpr std::size_t kSlotsPerThread = 2;
+
+namespace detail {
+
+struct Record {
+    Record()
+        : active(true)
+        , next(nullptr) {
+        for (auto &slot : slots) slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    std::atomic<void *> slots[kSlotsPerThread];
+    std::atomic<bool>   active;
+    Record             *next; // 记录只追加不删除, 发布后不再修改
+};
+
+struct Retired {
+    void *pointer;
+    void (*deleter)(void *);
+};
+
+class Domain {
+public:
+    /// @brief 域永不析构: 线程池工作线程可能在静态析构之后才退出, 其 ThreadState 仍要归还记录
+    static Domain &instance() {
+        static Domain *domain = new Domain;
+        return *domain;
+    }
+
+    /// @brief 复用已退出线程留下的记录, 没有则新建并挂到表头
+    Record *acquire() {
+        for (Record *record = _head.load(std::memory_order_acquire); record; record = record->next) {
+            bool expected = false;
+            if (!record->active.load(std::memory_order_relaxed) &&
+                record->active.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return record;
+            }
+        }
+        Record *record = new Record;
+        record->next   = _head.load(std::memory_order_relaxed);
+        while (!_head.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+        _recordCount.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    void release(Record *record_) {
+        for (auto &slot : record_->slots) slot.store(nullptr, std::memory_order_release);
+        record_->active.store(false, std::memory_order_release);
+    }
+
+    std::size_t record_count() const { return _recordCount.load(std::memory_order_relaxed); }
+
+    void collect_hazards(std::vector<void *> &out_) const {
+        for (Record *record = _head.load(std::memory_order_acquire); record; record = record->next) {
+            for (auto &slot : record->slots) {
+                if (void *pointer = slot.load(std::memory_order_seq_cst)) out_.push_back(pointer);
+            }
+        }
+    }
+
+    void orphan(std::vector<Retired> &retired_) {
+        if (retired_.empty()) return;
+        std::lock_guard<std::mutex> lock(_mtx);
+        _orphans.insert(_orphans.end(), retired_.begin(), retired_.end());
+        retired_.clear();
+    }
+
+    void adopt(std::vector<Retired> &retired_) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        retired_.insert(retired_.end(), _orphans.begin(), _orphans.end());
+        _orphans.clear();
+    }
+
+private:
+    Domain()
+        : _head(nullptr)
+        , _recordCount(0) {}
+
+    std::atomic<Record *>    _head;
+    std::atomic<std::size_t> _recordCount;
+    std::mutex               _mtx;
+    std::vector<Retired>     _orphans;
+};
+
+class ThreadState {
+public:
+    ThreadState()
+        : _domain(Domain::instance())
+        , _record(_domain.acquire()) {}
+    ThreadState(const ThreadState &)            = delete;
+    ThreadState &operator=(const ThreadState &) = delete;
+
+    ~ThreadState() {
+        _domain.release(_record);
+        scan();
+        _domain.orphan(_retired);
+    }
+
+    std::atomic<void *> &slot(std::size_t index_) { return _record->slots[index_]; }
+
+    void retire(void *pointer_, void (*deleter_)(void *)) {
+        _retired.push_back(Retired{pointer_, deleter_});
+        // 阈值与槽位总数成正比, 每次扫描至少能释放一半, 摊还 O(1)
+        if (_retired.size() >= std::max<std::size_t>(64, 2 * kSlotsPerThread * _domain.record_count())) scan();
+    }
+
+    void scan() {
+        _domain.adopt(_retired);
+        if (_retired.empty()) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _hazards.clear();
+        _domain.collect_hazards(_hazards);
+        std::sort(_hazards.begin(), _hazards.end());
+
+        auto kept = std::partition(_retired.begin(), _retired.end(), [this](Retired const &retired_) {
+            return std::binary_search(_hazards.begin(), _hazards.end(), retired_.pointer);
+        });
+        for (auto it = kept; it != _retired.end(); ++it) {
+            it->deleter(it->pointer);
+        }
+        _retired.erase(kept, _retired.end());
+    }
+
+private:
+    Domain              &_domain;
+    Record              *_record;
+    std::vector<Retired> _retired;
+    std::vector<void *>  _hazards;
+};
+
+inline ThreadState &local() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+} // namespace detail
+
+/// @brief 把 source_ 当前的值登记到本线程第 slot_ 个槽位并返回; 返回后该结点不会被释放, 直到 clear
+template <typename T>
+T *protect(std::size_t slot_, std::atomic<T *> const &source_) {
+    std::atomic<void *> &slot    = detail::local().slot(slot_);
+    T                   *pointer = source_.load(std::memory_order_relaxed);
+    for (;;) {
+        slot.store(pointer, std::memory_order_seq_cst);
+        T *const current = source_.load(std::memory_order_seq_cst);
+        if (current == pointer) return pointer;
+        pointer = current;
+    }
+}
+
+inline void clear(std::size_t slot_) { detail::local().slot(slot_).store(nullptr, std::memory_order_release); }
+
+/// @brief 结点已从结构中摘下, 没有槽位指向它时 delete
+template <typename T>
+void retire(T *pointer_) {
+    detail::local().retire(pointer_, [](void *p_) { delete static_cast<T *>(p_); });
+}
+
+/// @brief 同上, 由 deleter_ 回收 (如放回结点池)
+template <typename T>
+void retire(T *pointer_, void (*deleter_)(void *)) {
+    detail::local().retire(pointer_, deleter_);
+}
+
+/// @brief 立即扫描本线程 retire 的结点 (连同已退出线程留下的), 释放没有槽位指向的.
+/// 结点很大而 retire 很少时 (如整份映射的旧版本) 在 retire 后调用, 不必攒满一批, 占用的内存只与正在读的线程数有关
+inline void scan() { detail::local().scan(); }
+
+} // namespace hazard
+
+#endif //__HAZARD_POINTER__
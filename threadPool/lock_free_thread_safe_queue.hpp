@@ -0,0 +1,179 @@
+#ifndef __LOCK_FREE_THREAD_SAFE_QUEUE__
+#define __LOCK_FREE_THREAD_SAFE_QUEUE__
+
+#include "event_count.hpp"
+#include "hazard_pointer.hpp"
+#include "queue_latency.hpp"
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/// @brief Michael-Scott 无锁队列, 接口与互斥锁版 ThreadSafeQueue 相同, 可直接替换
+/// 头结点是哑结点, push 只 CAS 尾部, pop 只 CAS 头部; 摘下的结点经危险指针回收.
+/// 每次 push 一次分配 (数据就地构造在结点里), 阻塞等待靠 EventCount, 没有等待者时 push 不碰互斥锁.
+/// @tparam T 元素类型, 需可移动构造
+template <typename T>
+class LockFreeThreadSafeQueue {
+public:
+    LockFreeThreadSafeQueue() {
+        Node *dummy = new Node;
+        _head.store(dummy, std::memory_order_relaxed);
+        _tail.store(dummy, std::memory_order_relaxed);
+    }
+    LockFreeThreadSafeQueue(const LockFreeThreadSafeQueue &)            = delete;
+    LockFreeThreadSafeQueue &operator=(const LockFreeThreadSafeQueue &) = delete;
+
+    /// @brief 析构时不能再有其他线程访问队列
+    ~LockFreeThreadSafeQueue() {
+        Node *node = _head.load(std::memory_order_relaxed);
+        Node *next = node->next.load(std::memory_order_relaxed);
+        delete node; // 哑结点的数据已被取走
+        for (node = next; node; node = next) {
+            next = node->next.load(std::memory_order_relaxed);
+            node->value()->~T();
+            delete node;
+        }
+    }
+
+    void push(T new_value) {
+        Node *node = new Node;
+        ::new (static_cast<void *>(&node->storage)) T(std::move(new_value));
+#ifdef QUEUE_LATENCY_TRACKING
+        node->enqueueNs = latency::now_ns(); // 发布 (release CAS) 之前写入, 之后不再修改
+#endif
+
+        for (;;) {
+            Node *tail = hazard::protect(0, _tail);
+            Node *next = tail->next.load(std::memory_order_acquire);
+            if (tail != _tail.load(std::memory_order_acquire)) continue;
+            if (next != nullptr) {
+                // 尾指针落后, 帮上一个 push 推进
+                _tail.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (tail->next.compare_exchange_weak(next, node, std::memory_order_release, std::memory_order_relaxed)) {
+                _tail.compare_exchange_strong(tail, node, std::memory_order_release, std::memory_order_relaxed);
+                break;
+            }
+        }
+        hazard::clear(0);
+        _event.notify_one();
+    }
+
+    /// @brief 队列为空则等待，不为空则pop()
+    void wait_and_pop(T &value) {
+        for (;;) {
+            if (try_pop(value)) return;
+            EventCount::Key const key = _event.prepare_wait();
+            if (try_pop(value)) {
+                _event.cancel_wait();
+                return;
+            }
+            _event.wait(key);
+        }
+    }
+
+    std::shared_ptr<T> wait_and_pop() {
+        for (;;) {
+            if (std::shared_ptr<T> res = try_pop()) return res;
+            EventCount::Key const key = _event.prepare_wait();
+            if (std::shared_ptr<T> res = try_pop()) {
+                _event.cancel_wait();
+                return res;
+            }
+            _event.wait(key);
+        }
+    }
+
+    bool try_pop(T &value) {
+        Node *node = pop_node();
+        if (!node) return false;
+        value = std::move(*node->value());
+        node->value()->~T();
+        hazard::clear(1);
+        return true;
+    }
+
+    std::shared_ptr<T> try_pop() {
+        Node *node = pop_node();
+        if (!node) return std::shared_ptr<T>();
+        std::shared_ptr<T> res;
+        try {
+            res = std::make_shared<T>(std::move(*node->value()));
+        } catch (...) {
+            node->value()->~T();
+            hazard::clear(1);
+            throw;
+        }
+        node->value()->~T();
+        hazard::clear(1);
+        return res;
+    }
+
+    bool empty() const {
+        Node *head  = hazard::protect(0, _head);
+        bool  empty = head->next.load(std::memory_order_acquire) == nullptr;
+        hazard::clear(0);
+        return empty;
+    }
+
+#ifdef QUEUE_LATENCY_TRACKING
+    /// @brief 元素从 push 到被取出的等待时间分布 (纳秒)
+    latency::Snapshot latency_snapshot() const { return _latency.snapshot(); }
+    void              reset_latency() { _latency.reset(); }
+#endif
+
+private:
+    struct Node {
+        Node()
+            : next(nullptr) {}
+
+        T *value() { return reinterpret_cast<T *>(&storage); }
+
+        std::atomic<Node *>                                        next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+#ifdef QUEUE_LATENCY_TRACKING
+        std::uint64_t enqueueNs;
+#endif
+    };
+
+    /// @brief 摘下头部哑结点, 返回新的哑结点 (其数据归调用方, 此时仍由槽位 1 保护), 空队列返回 nullptr
+    /// 新哑结点的数据只有 CAS 成功的线程会访问, 之后的 pop 只取再下一个结点的数据.
+    Node *pop_node() {
+        for (;;) {
+            Node *head = hazard::protect(0, _head);
+            Node *next = hazard::protect(1, head->next);
+            if (head != _head.load(std::memory_order_acquire)) continue;
+            if (next == nullptr) {
+                hazard::clear(0);
+                hazard::clear(1);
+                return nullptr;
+            }
+            Node *tail = _tail.load(std::memory_order_acquire);
+            if (head == tail) {
+                // 尾指针还指着要摘下的结点, 先推进它, 否则 retire 后尾指针悬空
+                _tail.compare_exchange_weak(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                hazard::clear(0);
+                hazard::retire(head);
+#ifdef QUEUE_LATENCY_TRACKING
+                _latency.record_since(next->enqueueNs);
+#endif
+                return next;
+            }
+        }
+    }
+
+    std::atomic<Node *> _head;
+    std::atomic<Node *> _tail;
+    mutable EventCount  _event;
+#ifdef QUEUE_LATENCY_TRACKING
+    latency::Histogram _latency;
+#endif
+};
+
+#endif //__LOCK_FREE_THREAD_SAFE_QUEUE__
@@ -83,11 +83,32 @@ void test_steal_thread() {
     }
     std::cout << std::endl;
 }
+#ifdef CO_TASK_ENABLED
+void test_co_steal_thread() {
+    spdlog::info("test_co_steal_thread:");
+    auto                               seed = std::chrono::system_clock::now().time_since_epoch().count();
+    std::uniform_int_distribution<int> u(-1000, 1000);
+    std::default_random_engine         e(seed);
+    std::list<int>                     nList;
+    for (size_t i = 0; i < 30; ++i)
+        nList.push_back(u(e));
+
+    auto sortList = co_steal_pool_thread_sort<int>(nList);
+    for (auto &e : sortList) {
+        std::cout << e << " ";
+    }
+    std::cout << std::endl;
+}
+#endif
+
 int main() {
     // test_simple_thread();
     // test_future_thread();
     // test_notify_thread();
     // test_parallen_thread();
     test_steal_thread();
+#ifdef CO_TASK_ENABLED
+    // test_co_steal_thread();
+#endif
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#ifndef __NODE_POOL__
+#define __NODE_POOL__
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/// @brief 定长结点内存池: 每线程一条空闲链, 不加锁; 链过长时整批交给全局, 空时整批取回
+/// 生产者分配、消费者释放的队列里结点经全局链流转, 平均每 BatchSize 个结点才加一次锁.
+/// 只提供原始内存, 构造与析构由调用方 placement new / 显式析构.
+/// @tparam Node 结点类型, 决定块大小
+/// @tparam BatchSize 线程与全局之间一次搬运的块数
+template <typename Node, std::size_t BatchSize = 64>
+class NodePool {
+public:
+    static void *allocate() {
+        if (Cache *cache = local_cache()) {
+            if (!cache->head) refill(*cache);
+            if (FreeBlock *block = cache->head) {
+                cache->head = block->next;
+                --cache->count;
+                return block;
+            }
+        }
+        return ::operator new(kBlockSize);
+    }
+
+    static void deallocate(void *pointer_) {
+        FreeBlock *block = static_cast<FreeBlock *>(pointer_);
+        Cache     *cache = local_cache();
+        if (!cache) {
+            // 线程退出阶段本线程的缓存已析构, 直接还给全局
+            block->next = nullptr;
+            give_back(Chain{block, 1});
+            return;
+        }
+        block->next = cache->head;
+        cache->head = block;
+        if (++cache->count >= 2 * BatchSize) spill(*cache, BatchSize);
+    }
+
+    /// @brief 全局链上的空闲块数, 调试用
+    static std::size_t global_free() {
+        Global                     &global = instance();
+        std::lock_guard<std::mutex> lock(global.mtx);
+        std::size_t                 total = 0;
+        for (auto const &chain : global.chains) total += chain.count;
+        return total;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    static constexpr std::size_t kBlockSize = sizeof(Node) < sizeof(FreeBlock) ? sizeof(FreeBlock) : sizeof(Node);
+    static_assert(alignof(Node) <= alignof(std::max_align_t), "NodePool: over-aligned node");
+
+    struct Chain {
+        FreeBlock  *head;
+        std::size_t count;
+    };
+
+    struct Global {
+        std::mutex         mtx;
+        std::vector<Chain> chains;
+    };
+
+    enum CacheState : int { kFresh = 0, kAlive = 1, kDead = 2 };
+
+    struct Cache {
+        explicit Cache(int &state_)
+            : head(nullptr)
+            , count(0)
+            , state(state_) {
+            instance();
+            state = kAlive;
+        }
+
+        ~Cache() {
+            if (head) give_back(Chain{head, count});
+            state = kDead;
+        }
+
+        FreeBlock  *head;
+        std::size_t count;
+        int        &state;
+    };
+
+    /// @brief 全局链永不析构: 静态析构阶段 (如危险指针域释放遗留结点) 仍可能归还内存
+    static Global &instance() {
+        static Global *global = new Global;
+        return *global;
+    }
+
+    static Cache *local_cache() {
+        static thread_local int state = kFresh;
+        if (state == kDead) return nullptr;
+        static thread_local Cache cache(state);
+        return &cache;
+    }
+
+    static void refill(Cache &cache_) {
+        Global                     &global = instance();
+        std::lock_guard<std::mutex> lock(global.mtx);
+        if (global.chains.empty()) return;
+        Chain const chain = global.chains.back();
+        global.chains.pop_back();
+        cache_.head  = chain.head;
+        cache_.count = chain.count;
+    }
+
+    static void spill(Cache &cache_, std::size_t count_) {
+        FreeBlock *head = cache_.head;
+        FreeBlock *last = head;
+        for (std::size_t i = 1; i < count_; ++i) last = last->next;
+        cache_.head = last->next;
+        cache_.count -= count_;
+        last->next = nullptr;
+        give_back(Chain{head, count_});
+    }
+
+    static void give_back(Chain chain_) {
+        Global                     &global = instance();
+        std::lock_guard<std::mutex> lock(global.mtx);
+        global.chains.push_back(chain_);
+    }
+};
+
+#endif //__NODE_POOL__
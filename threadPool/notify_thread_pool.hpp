@@ -10,11 +10,13 @@
 
 #include "future_thread_pool.hpp"
 #include "join_thread.hpp"
+#include "task_trace.hpp"
 #include "thread_safe_queue.hpp"
 
 class NotifyThreadPool {
 private:
-    void worker_thread() {
+    void worker_thread(size_t index_) {
+        _tracer.bind_worker(index_);
         while (!_doneFlag) {
             auto taskPtr = _workQueue.wait_and_pop();
             if (taskPtr == nullptr) continue;
@@ -38,20 +40,24 @@ public:
     std::future<typename std::result_of<FunctionType()>::type> submit(FunctionType f) {
         // typedef typename std::result_of<FunctionType()>::type result_type;
         using resultType = decltype(f());
-        std::packaged_task<resultType()> task(std::move(f));
+        std::packaged_task<resultType()> task(_tracer.wrap(std::move(f)));
         std::future<resultType>          res(task.get_future());
         _workQueue.push(std::move(task));
         return res;
     }
 
+    /// @brief 逐任务调度记录, 需定义 POOL_TASK_TRACING
+    trace::TaskTracer &tracer() { return _tracer; }
+
 private:
     NotifyThreadPool()
         : _doneFlag(false)
-        , _joiner(_threads) {
+        , _joiner(_threads)
+        , _tracer(std::thread::hardware_concurrency()) {
         unsigned const threadCount = std::thread::hardware_concurrency();
         try {
             for (size_t i = 0; i < threadCount; ++i) {
-                _threads.push_back(std::thread(&NotifyThreadPool::worker_thread, this));
+                _threads.push_back(std::thread(&NotifyThreadPool::worker_thread, this, i));
             }
         } catch (const std::exception &e) {
             _doneFlag = true;
@@ -65,6 +71,7 @@ private:
     ThreadSafeQueue<FunctionWrapper> _workQueue;
     std::vector<std::thread>         _threads;
     JoinThread                       _joiner;
+    trace::TaskTracer                _tracer;
 };
 
 #endif // __NOTIFY_THREAD_POOL_
\ No newline at end of file
@@ -16,6 +16,7 @@
 #define __PARALLEL_FOREACH__
 #include "future_thread_pool.hpp"
 #include "notify_thread_pool.hpp"
+#include "partitioner.hpp"
 #include "simple_thread_pool.hpp"
 #include <algorithm>
 #include <future>
@@ -23,76 +24,79 @@
 #include <thread>
 #include <vector>
 
+/// @brief 对划分出的第 chunk 块元素执行f, 各块起点由 chunk_starts 预先求出
+/// @tparam Iterator
+/// @tparam Func
+template <typename Iterator, typename Func>
+struct ForeachBlock {
+    std::vector<Iterator> starts;
+    Func                  f;
+
+    void operator()(std::size_t chunk_, std::size_t, std::size_t) const {
+        std::for_each(starts[chunk_], starts[chunk_ + 1], f);
+    }
+};
+
 /// @brief simple while thread for foreach
 /// @tparam Iterator
 /// @tparam Func
 /// @param first
 /// @param last
 /// @param f
+/// @param partitioner
 template <typename Iterator, typename Func>
-void simple_foreach(Iterator first, Iterator last, Func f) {
+void simple_foreach(Iterator first, Iterator last, Func f, Partitioner partitioner = Partitioner()) {
     unsigned long const length = std::distance(first, last);
     if (!length) return;
-    unsigned long const minPerThread = 25;
-    unsigned long const numThreads   = (length + minPerThread - 1) / minPerThread;
-    unsigned long const blockSize    = length / numThreads;
-
-    std::vector<std::future<void>> futures(numThreads - 1);
-    Iterator                       blockStart = first;
-    for (size_t i = 0; i < (numThreads - 1); ++i) {
-        Iterator blockEnd = blockStart;
-        std::advance(blockEnd, blockSize);
+    ChunkScheduler                     scheduler(partitioner.plan(length));
+    ForeachBlock<Iterator, Func> const block{chunk_starts(scheduler.plan(), first), f};
 
-        SimpleThreadPool::instance().submit([=]() { std::for_each(blockStart, blockEnd, f); });
-        blockStart = blockEnd;
+    SimpleThreadPool &pool = SimpleThreadPool::instance();
+    WaitGroup         group;
+    for (size_t i = 1; i < scheduler.plan().workerCount; ++i) {
+        pool.submit([&scheduler, &block, i]() { scheduler.work(i, block); }, group);
     }
-    std::for_each(blockStart, last, f);
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    scheduler.work(0, block);
+    // 等待期间帮忙执行队列中的任务, 避免在池内调用时所有线程互相等待
+    group.wait([&pool]() { return pool.run_pending_task(); });
+    scheduler.rethrow_if_failed();
 }
 
 template <typename Iterator, typename Func>
-void future_foreach(Iterator first, Iterator last, Func f) {
+void future_foreach(Iterator first, Iterator last, Func f, Partitioner partitioner = Partitioner()) {
     unsigned long length = std::distance(first, last);
     if (!length) return;
-    unsigned long const minPerThread = 25;
-    unsigned long const numThreads   = (length + minPerThread - 1) / minPerThread;
-    unsigned long       blockSize    = length / numThreads;
+    ChunkScheduler                     scheduler(partitioner.plan(length));
+    ForeachBlock<Iterator, Func> const block{chunk_starts(scheduler.plan(), first), f};
 
-    std::vector<std::future<void>> futures(numThreads - 1);
-    Iterator                       blockStart = first;
-    for (size_t i = 0; i < (numThreads - 1); ++i) {
-        Iterator blockEnd = blockStart;
-        std::advance(blockEnd, blockSize);
-
-        futures[i] = FutureThreadPool::instance().submit([=]() { std::for_each(blockStart, blockEnd, f); });
-        blockStart = blockEnd;
+    std::vector<std::future<void>> futures;
+    for (size_t i = 1; i < scheduler.plan().workerCount; ++i) {
+        futures.push_back(
+            FutureThreadPool::instance().submit([&scheduler, &block, i]() { scheduler.work(i, block); }));
     }
-    std::for_each(blockStart, last, f);
+    scheduler.work(0, block);
     for (auto &future : futures)
         future.get();
+    scheduler.rethrow_if_failed();
 }
 
 template <typename Iterator, typename Func>
-void notify_foreach(Iterator first, Iterator last, Func f) {
+void notify_foreach(Iterator first, Iterator last, Func f, Partitioner partitioner = Partitioner()) {
     unsigned long length = std::distance(first, last);
     if (!length) return;
-    unsigned long const minPerThread = 25;
-    unsigned long const numThreads   = (length + minPerThread - 1) / minPerThread;
-    unsigned long       blockSize    = length / numThreads;
-
-    std::vector<std::future<void>> futures(numThreads - 1);
-    Iterator                       blockStart = first;
-    for (size_t i = 0; i < (numThreads - 1); ++i) {
-        Iterator blockEnd = blockStart;
-        std::advance(blockEnd, blockSize);
+    ChunkScheduler                     scheduler(partitioner.plan(length));
+    ForeachBlock<Iterator, Func> const block{chunk_starts(scheduler.plan(), first), f};
 
-        futures[i] = NotifyThreadPool::instance().submit([=]() { std::for_each(blockStart, blockEnd, f); });
-        blockStart = blockEnd;
+    std::vector<std::future<void>> futures;
+    for (size_t i = 1; i < scheduler.plan().workerCount; ++i) {
+        futures.push_back(
+            NotifyThreadPool::instance().submit([&scheduler, &block, i]() { scheduler.work(i, block); }));
     }
-    std::for_each(blockStart, last, f);
+    scheduler.work(0, block);
     for (auto &future : futures) {
         future.get();
     }
+    scheduler.rethrow_if_failed();
 }
 
 #endif //__PARALLEL_FOREACH__
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef __PARALLEL_INVOKE__
+#define __PARALLEL_INVOKE__
+
+#include "executor.hpp"
+#include "wait_group.hpp"
+#include <atomic>
+#include <exception>
+#include <memory>
+
+/// @brief fork-join: right_ 投递给执行器, 调用线程执行 left_, 两者都完成后返回
+/// 与 run_partitioned 相同的认领方式: 调用线程做完 left_ 后, right_ 若还没被池线程认领就自己执行,
+/// 因此递归的分治算法在池线程内嵌套调用也不会死等. 任一方抛出的异常在两者都结束后重新抛出(left_ 优先).
+/// @tparam Left  void()
+/// @tparam Right void()
+/// @param left_
+/// @param right_
+/// @param executor_
+template <typename Left, typename Right>
+void parallel_invoke(Left &&left_, Right &&right_, Executor &executor_ = default_executor()) {
+    struct SharedState {
+        explicit SharedState(Right &right_)
+            : claimed(false)
+            , right(right_) {}
+        bool claim() { return !claimed.exchange(true, std::memory_order_acq_rel); }
+
+        std::atomic_bool   claimed;
+        WaitGroup          group;
+        std::exception_ptr exception;
+        Right             &right;
+    };
+    std::shared_ptr<SharedState> state = std::make_shared<SharedState>(right_);
+
+    state->group.add();
+    try {
+        executor_.post([state]() {
+            if (!state->claim()) return;
+            try {
+                state->right();
+            } catch (...) {
+                state->exception = std::current_exception();
+            }
+            state->group.done();
+        });
+    } catch (...) {
+        // 投递失败, 由下面的调用线程认领执行
+    }
+
+    std::exception_ptr leftException;
+    try {
+        left_();
+    } catch (...) {
+        leftException = std::current_exception();
+    }
+
+    if (state->claim()) {
+        try {
+            right_();
+        } catch (...) {
+            state->exception = std::current_exception();
+        }
+        state->group.done();
+    }
+    state->group.wait([&executor_]() { return executor_.run_pending_task(); });
+
+    if (leftException) std::rethrow_exception(leftException);
+    if (state->exception) std::rethrow_exception(state->exception);
+}
+
+#endif //__PARALLEL_INVOKE__
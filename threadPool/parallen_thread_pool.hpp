@@ -10,6 +10,7 @@
 
 #include "future_thread_pool.hpp"
 #include "join_thread.hpp"
+#include "task_trace.hpp"
 #include "thread_safe_queue.hpp"
 #include <atomic>
 
@@ -17,7 +18,8 @@ class ParallenThreadPool {
 
 private:
     void work_thread(int index_) {
-        while (_doneFlag) {
+        _tracer.bind_worker(index_);
+        while (!_doneFlag) {
             auto taskPtr = _threadWorkQueues[index_].wait_and_pop();
             if (taskPtr == nullptr) continue;
             (*taskPtr)();
@@ -47,17 +49,21 @@ public:
         _atmIndex.store(index);
 
         using returnType = decltype(f());
-        std::packaged_task<returnType()> task(std::move(f));
+        std::packaged_task<returnType()> task(_tracer.wrap(std::move(f)));
         std::future<returnType>          res(task.get_future());
         _threadWorkQueues[index].push(std::move(task));
         return res;
     }
 
+    /// @brief 逐任务调度记录, 需定义 POOL_TASK_TRACING
+    trace::TaskTracer &tracer() { return _tracer; }
+
 private:
     ParallenThreadPool()
         : _doneFlag(false)
         , _joiner(_threads)
-        , _atmIndex(0) {
+        , _atmIndex(0)
+        , _tracer(std::thread::hardware_concurrency()) {
 
         unsigned const thread_count = std::thread::hardware_concurrency();
         try {
@@ -83,6 +89,7 @@ private:
     std::vector<ThreadSafeQueue<FunctionWrapper>> _threadWorkQueues;
     std::vector<std::thread>                      _threads;
     std::atomic<int>                              _atmIndex;
+    trace::TaskTracer                             _tracer;
 };
 
 #endif //__PARALLEN_THREAD_POOL__
\ No newline at end of file
@@ -0,0 +1,285 @@
+#ifndef __PARTITIONER__
+#define __PARTITIONER__
+
+#include "executor.hpp"
+#include "wait_group.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief 划分策略
+/// Static : 按线程数等分成大块, 每个线程一块 (原先各算法的做法)
+/// Dynamic: 切成固定大小的小块, 线程从共享计数器领取下一块
+/// Auto   : 每个线程先拿一段连续的小块, 做完后从其他线程剩余部分的后半段窃取
+enum class PartitionKind { Static, Dynamic, Auto };
+
+/// @brief 一次划分的结果: [0, length) 被切成 chunkCount 块, 由 workerCount 个线程处理
+struct PartitionPlan {
+    PartitionKind kind;
+    std::size_t   length;
+    std::size_t   chunkSize;
+    std::size_t   chunkCount;
+    std::size_t   workerCount;
+
+    std::size_t chunk_begin(std::size_t chunk_) const { return chunk_ * chunkSize; }
+    std::size_t chunk_end(std::size_t chunk_) const {
+        return (chunk_ + 1 == chunkCount) ? length : (chunk_ + 1) * chunkSize;
+    }
+};
+
+/// @brief 一次遍历求出各块的起始迭代器, 末尾追加 last, 共 chunkCount + 1 个
+/// 非随机访问迭代器 (如 std::list) 只走一遍, 而不是每块都从 first 前进
+template <typename Iterator>
+std::vector<Iterator> chunk_starts(PartitionPlan const &plan_, Iterator first_) {
+    std::vector<Iterator> starts;
+    starts.reserve(plan_.chunkCount + 1);
+    starts.push_back(first_);
+    for (std::size_t i = 0; i < plan_.chunkCount; ++i) {
+        std::advance(first_, plan_.chunk_end(i) - plan_.chunk_begin(i));
+        starts.push_back(first_);
+    }
+    return starts;
+}
+
+/// @brief 并行算法共用的划分器
+/// grain 对 Static 表示每个线程最少处理的元素数, 对 Dynamic 表示块大小(0 为自动),
+/// 对 Auto 表示最小的窃取单位. maxWorkers 为 0 时使用硬件线程数.
+class Partitioner {
+public:
+    static constexpr std::size_t kDefaultGrain    = 1024;
+    static constexpr std::size_t kChunksPerWorker = 8;
+
+    explicit Partitioner(PartitionKind kind_ = PartitionKind::Auto, std::size_t grain_ = 0,
+                         std::size_t maxWorkers_ = 0)
+        : _kind(kind_)
+        , _grain(grain_)
+        , _maxWorkers(maxWorkers_) {}
+
+    static Partitioner static_blocks(std::size_t minPerThread_ = kDefaultGrain) {
+        return Partitioner(PartitionKind::Static, minPerThread_);
+    }
+    static Partitioner dynamic_chunks(std::size_t chunkSize_ = 0) {
+        return Partitioner(PartitionKind::Dynamic, chunkSize_);
+    }
+    static Partitioner auto_split(std::size_t minGrain_ = kDefaultGrain) {
+        return Partitioner(PartitionKind::Auto, minGrain_);
+    }
+
+    PartitionKind kind() const { return _kind; }
+    std::size_t   grain() const { return _grain != 0 ? _grain : kDefaultGrain; }
+
+    std::size_t max_workers() const {
+        if (_maxWorkers != 0) return _maxWorkers;
+        unsigned long const hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads != 0 ? hardwareThreads : 2;
+    }
+
+    PartitionPlan plan(std::size_t length_) const {
+        PartitionPlan plan{_kind, length_, 0, 0, 0};
+        if (!length_) return plan;
+
+        std::size_t const maxWorkers = max_workers();
+        if (_kind == PartitionKind::Static) {
+            std::size_t const minPerThread = grain();
+            std::size_t const maxThreads   = (length_ + minPerThread - 1) / minPerThread;
+            plan.workerCount               = std::min(maxWorkers, maxThreads);
+            plan.chunkCount                = plan.workerCount;
+            plan.chunkSize                 = length_ / plan.workerCount;
+            return plan;
+        }
+
+        // Dynamic 指定了块大小就照用; 否则每个线程约分 kChunksPerWorker 块, 但不小于 grain
+        if (_kind == PartitionKind::Dynamic && _grain != 0) {
+            plan.chunkSize = _grain;
+        } else {
+            std::size_t const minGrain = (_kind == PartitionKind::Dynamic) ? kDefaultGrain : grain();
+            plan.chunkSize             = std::max(minGrain, length_ / (maxWorkers * kChunksPerWorker));
+        }
+        plan.chunkCount  = (length_ + plan.chunkSize - 1) / plan.chunkSize;
+        plan.workerCount = std::min(maxWorkers, plan.chunkCount);
+        return plan;
+    }
+
+private:
+    PartitionKind _kind;
+    std::size_t   _grain;
+    std::size_t   _maxWorkers;
+};
+
+/// @brief 按划分结果把块分发给各个线程
+/// 每个线程调用一次 work(worker, body), body(chunk, begin, end) 处理一块.
+/// body 抛出的第一个异常被保存, 其余线程不再领取新块, 由 rethrow_if_failed() 重新抛出.
+class ChunkScheduler {
+public:
+    explicit ChunkScheduler(PartitionPlan const &plan_)
+        : _plan(plan_)
+        , _next(0)
+        , _cancelled(false)
+        , _failed(false)
+        , _slots(new Slot[plan_.workerCount != 0 ? plan_.workerCount : 1]) {
+        if (_plan.kind == PartitionKind::Dynamic) return;
+        // Static 每个线程恰好一块; Auto 先按线程把块号连续均分
+        std::size_t const perWorker = _plan.workerCount ? _plan.chunkCount / _plan.workerCount : 0;
+        std::size_t const remainder = _plan.workerCount ? _plan.chunkCount % _plan.workerCount : 0;
+        std::size_t       lo        = 0;
+        for (std::size_t i = 0; i < _plan.workerCount; ++i) {
+            std::size_t const hi = lo + perWorker + (i < remainder ? 1 : 0);
+            _slots[i].lo         = lo;
+            _slots[i].hi         = hi;
+            lo                   = hi;
+        }
+    }
+    ChunkScheduler(const ChunkScheduler &)            = delete;
+    ChunkScheduler &operator=(const ChunkScheduler &) = delete;
+
+    PartitionPlan const &plan() const { return _plan; }
+
+    /// @brief 第worker_个线程的工作循环, 领不到块时返回
+    /// @tparam Body void(std::size_t chunk, std::size_t begin, std::size_t end)
+    template <typename Body>
+    void work(std::size_t worker_, Body &body_) {
+        std::size_t chunk = 0;
+        while (!cancelled() && next_chunk(worker_, chunk)) {
+            try {
+                body_(chunk, _plan.chunk_begin(chunk), _plan.chunk_end(chunk));
+            } catch (...) {
+                fail(std::current_exception());
+                return;
+            }
+        }
+    }
+
+    /// @brief 通知所有线程不再领取新块
+    void cancel() { _cancelled.store(true, std::memory_order_release); }
+    bool cancelled() const { return _cancelled.load(std::memory_order_acquire); }
+
+    void rethrow_if_failed() {
+        if (_failed.load(std::memory_order_acquire)) std::rethrow_exception(_exception);
+    }
+
+private:
+    /// @brief 每个线程自己的块区间 [lo, hi), 按缓存行隔开
+    struct Slot {
+        std::mutex  mtx;
+        std::size_t lo = 0;
+        std::size_t hi = 0;
+        char        pad[64];
+    };
+
+    bool next_chunk(std::size_t worker_, std::size_t &chunk_) {
+        if (_plan.kind == PartitionKind::Dynamic) {
+            chunk_ = _next.fetch_add(1, std::memory_order_relaxed);
+            return chunk_ < _plan.chunkCount;
+        }
+        if (pop_front(_slots[worker_], chunk_)) return true;
+        if (_plan.kind == PartitionKind::Static) return false;
+        return steal(worker_, chunk_);
+    }
+
+    static bool pop_front(Slot &slot_, std::size_t &chunk_) {
+        std::lock_guard<std::mutex> lock(slot_.mtx);
+        if (slot_.lo == slot_.hi) return false;
+        chunk_ = slot_.lo++;
+        return true;
+    }
+
+    /// @brief 从其他线程剩余区间中切走后一半, 第一块立即执行, 其余放入自己的区间
+    bool steal(std::size_t worker_, std::size_t &chunk_) {
+        for (std::size_t i = 1; i < _plan.workerCount; ++i) {
+            Slot       &victim = _slots[(worker_ + i) % _plan.workerCount];
+            std::size_t stolenLo, stolenHi;
+            {
+                std::lock_guard<std::mutex> lock(victim.mtx);
+                std::size_t const           remaining = victim.hi - victim.lo;
+                if (remaining == 0) continue;
+                stolenLo  = victim.lo + remaining / 2;
+                stolenHi  = victim.hi;
+                victim.hi = stolenLo;
+            }
+            Slot                       &own = _slots[worker_];
+            std::lock_guard<std::mutex> lock(own.mtx);
+            own.lo = stolenLo + 1;
+            own.hi = stolenHi;
+            chunk_ = stolenLo;
+            return true;
+        }
+        return false;
+    }
+
+    void fail(std::exception_ptr exception_) {
+        std::lock_guard<std::mutex> lock(_mtxException);
+        if (!_failed.load(std::memory_order_relaxed)) {
+            _exception = exception_;
+            _failed.store(true, std::memory_order_release);
+        }
+        cancel();
+    }
+
+    PartitionPlan            _plan;
+    std::atomic<std::size_t> _next;
+    std::atomic_bool         _cancelled;
+    std::atomic_bool         _failed;
+    std::mutex               _mtxException;
+    std::exception_ptr       _exception;
+    std::unique_ptr<Slot[]>  _slots;
+};
+
+/// @brief 把 workerCount - 1 个工作循环投递给执行器, 调用线程执行第0个
+/// 每个工作循环只会被执行一次: 池线程和调用线程谁先认领谁执行.
+/// 调用线程做完自己那份后认领还没开始的, 因此池内嵌套调用或池线程全忙时也不会死等.
+/// 共享状态由投递出去的任务共同持有, 晚到的任务只会认领失败, 不会访问已返回的栈帧.
+/// @tparam Body void(std::size_t chunk, std::size_t begin, std::size_t end)
+/// @param plan_
+/// @param body_
+/// @param executor_
+template <typename Body>
+void run_partitioned(PartitionPlan const &plan_, Body body_, Executor &executor_ = default_executor()) {
+    if (!plan_.workerCount) return;
+
+    struct SharedState {
+        explicit SharedState(PartitionPlan const &plan_, Body &body_)
+            : scheduler(plan_)
+            , claimed(new std::atomic_bool[plan_.workerCount])
+            , body(body_) {
+            for (std::size_t i = 0; i < plan_.workerCount; ++i)
+                claimed[i].store(false, std::memory_order_relaxed);
+        }
+        bool claim(std::size_t worker_) { return !claimed[worker_].exchange(true, std::memory_order_acq_rel); }
+
+        ChunkScheduler                      scheduler;
+        std::unique_ptr<std::atomic_bool[]> claimed;
+        WaitGroup                           group;
+        Body                               &body;
+    };
+    std::shared_ptr<SharedState> state = std::make_shared<SharedState>(plan_, body_);
+
+    state->group.add(plan_.workerCount - 1);
+    for (std::size_t i = 1; i < plan_.workerCount; ++i) {
+        try {
+            executor_.post([state, i]() {
+                if (!state->claim(i)) return;
+                state->scheduler.work(i, state->body);
+                state->group.done();
+            });
+        } catch (...) {
+            break; // 投递失败的工作循环由下面的调用线程认领执行
+        }
+    }
+
+    state->scheduler.work(0, body_);
+    for (std::size_t i = 1; i < plan_.workerCount; ++i) {
+        if (!state->claim(i)) continue;
+        state->scheduler.work(i, body_);
+        state->group.done();
+    }
+    state->group.wait([&executor_]() { return executor_.run_pending_task(); });
+    state->scheduler.rethrow_if_failed();
+}
+
+#endif //__PARTITIONER__
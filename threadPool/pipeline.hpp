@@ -0,0 +1,541 @@
+#ifndef __PIPELINE__
+#define __PIPELINE__
+
+#include "channel.hpp"
+#include "sharded_counter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct PipelineOptions {
+    std::size_t capacity = 1024;  // 相邻阶段之间通道的容量, 满时上游阻塞 (背压)
+    std::size_t batch    = 64;    // 每次从通道搬运的最大条数
+    bool        ordered  = false; // sink 按 push 的顺序收到结果 (sink 只能单线程)
+};
+
+/// @brief 单个阶段的统计
+struct StageStats {
+    std::string   name;
+    std::size_t   parallelism;
+    std::uint64_t items;
+    double        busySeconds;    // 各工作线程执行 f 的耗时之和, 不含等待通道的时间
+    double        blockedSeconds; // 下游通道满时阻塞在发送上的时间之和 (被背压), 不计入 busySeconds
+    double        utilization;    // busySeconds / (墙钟时间 * parallelism), 接近 1 说明该阶段是瓶颈
+    double        itemsPerSecond; // 按墙钟时间
+    double        avgQueue;       // 每次取批量前输入通道的平均积压
+    std::size_t   maxQueue;
+    std::size_t   queueCapacity;
+};
+
+struct PipelineStats {
+    double                  seconds = 0;
+    std::vector<StageStats> stages;
+
+    /// @brief 利用率最高的阶段下标, 应优先给它加并行度
+    std::size_t bottleneck() const {
+        std::size_t best = 0;
+        for (std::size_t i = 1; i < stages.size(); ++i) {
+            if (stages[i].utilization > stages[best].utilization) best = i;
+        }
+        return best;
+    }
+
+    std::string to_string() const {
+        std::ostringstream out;
+        out.setf(std::ios::fixed);
+        out.precision(2);
+        for (std::size_t i = 0; i < stages.size(); ++i) {
+            StageStats const &s = stages[i];
+            out << s.name << " x" << s.parallelism << ": " << s.items << " items, " << s.itemsPerSecond << " items/s, "
+                << "utilization " << s.utilization * 100 << "%, blocked " << s.blockedSeconds << "s, "
+                << "queue avg " << s.avgQueue << " max " << s.maxQueue << "/" << s.queueCapacity
+                << (i == bottleneck() ? "  <- bottleneck" : "") << "\n";
+        }
+        return out.str();
+    }
+};
+
+namespace pipeline_detail {
+
+using Clock = std::chrono::steady_clock;
+
+/// @brief 通道中流动的条目带上 push 时的序号, ordered 模式下 sink 据此重排
+/// 某阶段处理一条时抛出, 下游改收不带值的跳过标记 (skip), ordered sink 据此越过该序号继续交付
+template <typename T>
+class Sequenced {
+public:
+    Sequenced(std::uint64_t seq_, T value_)
+        : seq(seq_)
+        , _hasValue(true) {
+        new (&_storage) T(std::move(value_));
+    }
+    Sequenced(Sequenced &&other_)
+        : seq(other_.seq)
+        , _hasValue(other_._hasValue) {
+        if (_hasValue) new (&_storage) T(std::move(other_.value()));
+    }
+    Sequenced &operator=(Sequenced &&other_) {
+        if (this == &other_) return *this;
+        reset();
+        seq = other_.seq;
+        if (other_._hasValue) {
+            new (&_storage) T(std::move(other_.value()));
+            _hasValue = true;
+        }
+        return *this;
+    }
+    Sequenced(const Sequenced &)            = delete;
+    Sequenced &operator=(const Sequenced &) = delete;
+    ~Sequenced() { reset(); }
+
+    static Sequenced skip(std::uint64_t seq_) { return Sequenced(seq_); }
+
+    bool has_value() const { return _hasValue; }
+    T   &value() { return *reinterpret_cast<T *>(&_storage); }
+
+    std::uint64_t seq;
+
+private:
+    explicit Sequenced(std::uint64_t seq_)
+        : seq(seq_)
+        , _hasValue(false) {}
+
+    void reset() {
+        if (!_hasValue) return;
+        value().~T();
+        _hasValue = false;
+    }
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type _storage;
+    bool                                                        _hasValue;
+};
+
+struct StageCounters {
+    StageCounters(std::string name_, std::size_t parallelism_, std::size_t capacity_)
+        : name(std::move(name_))
+        , parallelism(parallelism_)
+        , capacity(capacity_)
+        , queueMax(0) {}
+
+    void sample_queue(std::size_t size_) {
+        queueSamples.add();
+        queueTotal.add(size_);
+        std::size_t current = queueMax.load(std::memory_order_relaxed);
+        while (size_ > current && !queueMax.compare_exchange_weak(current, size_, std::memory_order_relaxed)) {
+        }
+    }
+
+    StageStats snapshot(double seconds_) const {
+        StageStats stats;
+        stats.name           = name;
+        stats.parallelism    = parallelism;
+        stats.items          = items.load();
+        stats.busySeconds    = busyNanos.load() * 1e-9;
+        stats.blockedSeconds = blockedNanos.load() * 1e-9;
+        stats.utilization    = seconds_ > 0 ? stats.busySeconds / (seconds_ * parallelism) : 0;
+        stats.itemsPerSecond = seconds_ > 0 ? stats.items / seconds_ : 0;
+        std::uint64_t const samples = queueSamples.load();
+        stats.avgQueue      = samples ? static_cast<double>(queueTotal.load()) / samples : 0;
+        stats.maxQueue      = queueMax.load(std::memory_order_relaxed);
+        stats.queueCapacity = capacity;
+        return stats;
+    }
+
+    std::string const        name;
+    std::size_t const        parallelism;
+    std::size_t const        capacity;
+    ShardedCounter           items; // 各工作线程并发累加, 按线程分片
+    ShardedCounter           busyNanos;
+    ShardedCounter           blockedNanos;
+    ShardedCounter           queueSamples;
+    ShardedCounter           queueTotal;
+    std::atomic<std::size_t> queueMax;
+};
+
+class StageRunner {
+public:
+    virtual ~StageRunner() {}
+    virtual void start(std::vector<std::thread> &threads_) = 0;
+};
+
+/// @brief 所有阶段共享: 选项、阶段列表、统计和第一个异常
+struct Graph {
+    explicit Graph(PipelineOptions const &options_)
+        : options(options_) {}
+
+    void fail(std::exception_ptr exception_) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!exception) exception = std::move(exception_);
+    }
+
+    PipelineOptions const                       options;
+    std::vector<std::unique_ptr<StageRunner>>   stages;
+    std::vector<std::shared_ptr<StageCounters>> counters;
+    std::mutex                                  mtx;
+    std::exception_ptr                          exception;
+};
+
+/// @brief 一批批取输入, 计时处理, 交给 consume_; 阶段的最后一个线程退出时调用 on_last_exit_
+/// consume_ 返回其中阻塞在下游通道上的时长, 这部分记为 blocked 而不是 busy
+template <typename In, typename Consume, typename Exit>
+void run_worker(Channel<Sequenced<In>> &input_, Graph &graph_, StageCounters &counters_, Consume consume_,
+                std::atomic<std::size_t> &alive_, Exit on_last_exit_) {
+    std::vector<Sequenced<In>> batch;
+    batch.reserve(graph_.options.batch);
+    for (;;) {
+        counters_.sample_queue(input_.size());
+        batch.clear();
+        if (!input_.receive_n(std::back_inserter(batch), graph_.options.batch)) break;
+
+        Clock::time_point const begin   = Clock::now();
+        Clock::duration         blocked = Clock::duration::zero();
+        try {
+            blocked = consume_(batch);
+        } catch (...) {
+            // 记录第一个异常, 继续取空输入以免上游阻塞; 本批结果丢弃
+            graph_.fail(std::current_exception());
+        }
+        Clock::duration const elapsed = Clock::now() - begin;
+        counters_.busyNanos.add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed - blocked).count());
+        counters_.blockedNanos.add(std::chrono::duration_cast<std::chrono::nanoseconds>(blocked).count());
+        counters_.items.add(batch.size());
+    }
+    if (alive_.fetch_sub(1, std::memory_order_acq_rel) == 1) on_last_exit_();
+}
+
+template <typename In, typename Out, typename F>
+class MapStage : public StageRunner {
+public:
+    MapStage(Graph &graph_, std::shared_ptr<StageCounters> counters_, std::shared_ptr<Channel<Sequenced<In>>> input_,
+             std::shared_ptr<Channel<Sequenced<Out>>> output_, F f_)
+        : _graph(graph_)
+        , _counters(std::move(counters_))
+        , _input(std::move(input_))
+        , _output(std::move(output_))
+        , _f(std::move(f_))
+        , _alive(0) {}
+
+    void start(std::vector<std::thread> &threads_) override {
+        _alive = _counters->parallelism;
+        for (std::size_t i = 0; i < _counters->parallelism; ++i) {
+            threads_.emplace_back([this]() {
+                F                           f = _f; // 每个工作线程一份拷贝
+                std::vector<Sequenced<Out>> results;
+                results.reserve(_graph.options.batch);
+                run_worker(
+                    *_input, _graph, *_counters,
+                    [&](std::vector<Sequenced<In>> &batch_) {
+                        results.clear();
+                        for (auto &item : batch_) {
+                            if (!item.has_value()) {
+                                results.push_back(Sequenced<Out>::skip(item.seq));
+                                continue;
+                            }
+                            try {
+                                results.push_back(Sequenced<Out>(item.seq, f(std::move(item.value()))));
+                            } catch (...) {
+                                // 只丢弃出错的这一条, 本批其余结果照常发出; 第一个异常在 finish 时抛出
+                                _graph.fail(std::current_exception());
+                                if (_graph.options.ordered) results.push_back(Sequenced<Out>::skip(item.seq));
+                            }
+                        }
+                        Clock::time_point const sendBegin = Clock::now();
+                        _output->send_n(results.begin(), results.size());
+                        return Clock::now() - sendBegin;
+                    },
+                    _alive, [this]() { _output->close(); });
+            });
+        }
+    }
+
+private:
+    Graph                                   &_graph;
+    std::shared_ptr<StageCounters>           _counters;
+    std::shared_ptr<Channel<Sequenced<In>>>  _input;
+    std::shared_ptr<Channel<Sequenced<Out>>> _output;
+    F                                        _f;
+    std::atomic<std::size_t>                 _alive;
+};
+
+template <typename In, typename F>
+class SinkStage : public StageRunner {
+public:
+    SinkStage(Graph &graph_, std::shared_ptr<StageCounters> counters_, std::shared_ptr<Channel<Sequenced<In>>> input_,
+              F f_)
+        : _graph(graph_)
+        , _counters(std::move(counters_))
+        , _input(std::move(input_))
+        , _f(std::move(f_))
+        , _alive(0) {}
+
+    void start(std::vector<std::thread> &threads_) override {
+        _alive = _counters->parallelism;
+        for (std::size_t i = 0; i < _counters->parallelism; ++i) {
+            threads_.emplace_back([this]() {
+                F f = _f;
+                if (_graph.options.ordered) {
+                    run_ordered(f);
+                    return;
+                }
+                run_worker(
+                    *_input, _graph, *_counters,
+                    [&](std::vector<Sequenced<In>> &batch_) {
+                        for (auto &item : batch_) {
+                            if (item.has_value()) f(std::move(item.value()));
+                        }
+                        return Clock::duration::zero();
+                    },
+                    _alive, []() {});
+            });
+        }
+    }
+
+private:
+    struct LaterFirst {
+        bool operator()(Sequenced<In> const &a_, Sequenced<In> const &b_) const { return a_.seq > b_.seq; }
+    };
+
+    /// @brief 乱序到达的条目暂存在小顶堆里, 等到下一个序号才交给 f
+    void run_ordered(F &f_) {
+        std::priority_queue<Sequenced<In>, std::vector<Sequenced<In>>, LaterFirst> pending;
+        std::uint64_t                                                             next = 0;
+        run_worker(
+            *_input, _graph, *_counters,
+            [&](std::vector<Sequenced<In>> &batch_) {
+                for (auto &item : batch_) {
+                    pending.push(std::move(item));
+                }
+                while (!pending.empty() && pending.top().seq == next) {
+                    // 先出堆再交给 f, f 抛出时只丢弃这一条, 后续序号照常推进
+                    Sequenced<In> item = pop_top(pending);
+                    ++next;
+                    if (item.has_value()) f_(std::move(item.value()));
+                }
+                return Clock::duration::zero();
+            },
+            _alive, []() {});
+        // 上游出错丢弃过条目时序号会有空洞, 剩余的按序交出
+        while (!pending.empty()) {
+            Sequenced<In> item = pop_top(pending);
+            if (!item.has_value()) continue;
+            try {
+                f_(std::move(item.value()));
+            } catch (...) {
+                _graph.fail(std::current_exception());
+            }
+        }
+    }
+
+    template <typename Heap>
+    static Sequenced<In> pop_top(Heap &heap_) {
+        // priority_queue::top 只给 const 引用, 值移走后立即 pop, 不再参与比较
+        Sequenced<In> item = std::move(const_cast<Sequenced<In> &>(heap_.top()));
+        heap_.pop();
+        return item;
+    }
+
+    Graph                                  &_graph;
+    std::shared_ptr<StageCounters>          _counters;
+    std::shared_ptr<Channel<Sequenced<In>>> _input;
+    F                                       _f;
+    std::atomic<std::size_t>                _alive;
+};
+
+} // namespace pipeline_detail
+
+/// @brief 搭建完成、可运行的流水线; 输入端由调用方 push, 结束时 finish() 汇总统计
+/// @tparam In 输入类型
+template <typename In>
+class Pipeline {
+public:
+    Pipeline(std::shared_ptr<pipeline_detail::Graph>                   graph_,
+             std::shared_ptr<Channel<pipeline_detail::Sequenced<In>>> input_)
+        : _graph(std::move(graph_))
+        , _input(std::move(input_))
+        , _nextSeq(0)
+        , _started(false)
+        , _begin(pipeline_detail::Clock::now()) {}
+    Pipeline(Pipeline &&other_)
+        : _graph(std::move(other_._graph))
+        , _input(std::move(other_._input))
+        , _threads(std::move(other_._threads))
+        , _nextSeq(other_._nextSeq.load())
+        , _started(other_._started)
+        , _begin(other_._begin) {
+        other_._started = false;
+    }
+    Pipeline(const Pipeline &)            = delete;
+    Pipeline &operator=(const Pipeline &) = delete;
+
+    ~Pipeline() {
+        if (!_started) return;
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+
+    /// @brief 为每个阶段启动 parallelism 个工作线程
+    void start() {
+        if (_started) throw std::logic_error("Pipeline: already started");
+        _started = true;
+        _begin   = pipeline_detail::Clock::now();
+        for (auto &stage : _graph->stages) {
+            stage->start(_threads);
+        }
+    }
+
+    /// @brief 送入一条, 第一个阶段积压满时阻塞 (背压); 已 finish 时返回 false
+    bool push(In value_) {
+        std::uint64_t const seq = _nextSeq.fetch_add(1, std::memory_order_relaxed);
+        return _input->send(pipeline_detail::Sequenced<In>(seq, std::move(value_)));
+    }
+
+    /// @brief 按批送入 [first_, last_) (移动), 返回送入条数
+    template <typename Iterator>
+    std::size_t push_n(Iterator first_, Iterator last_) {
+        std::vector<pipeline_detail::Sequenced<In>> batch;
+        batch.reserve(_graph->options.batch);
+        std::size_t pushed = 0;
+        while (first_ != last_) {
+            batch.clear();
+            for (; first_ != last_ && batch.size() < _graph->options.batch; ++first_) {
+                batch.push_back(pipeline_detail::Sequenced<In>(0, std::move(*first_)));
+            }
+            std::uint64_t const seq = _nextSeq.fetch_add(batch.size(), std::memory_order_relaxed);
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                batch[i].seq = seq + i;
+            }
+            std::size_t const sent = _input->send_n(batch.begin(), batch.size());
+            pushed += sent;
+            if (sent < batch.size()) break;
+        }
+        return pushed;
+    }
+
+    /// @brief 运行中的统计快照
+    PipelineStats stats() const {
+        PipelineStats stats;
+        stats.seconds = std::chrono::duration<double>(pipeline_detail::Clock::now() - _begin).count();
+        for (auto &counters : _graph->counters) {
+            stats.stages.push_back(counters->snapshot(stats.seconds));
+        }
+        return stats;
+    }
+
+    /// @brief 关闭输入, 等各阶段依次取空退出; 有阶段抛出过异常时在这里重新抛出
+    PipelineStats finish() {
+        if (!_started) throw std::logic_error("Pipeline: not started");
+        _input->close();
+        for (auto &thread : _threads) {
+            if (thread.joinable()) thread.join();
+        }
+        PipelineStats result = stats();
+        if (_graph->exception) {
+            std::exception_ptr exception = _graph->exception;
+            _graph->exception            = nullptr;
+            std::rethrow_exception(exception);
+        }
+        return result;
+    }
+
+    /// @brief start + push_n + finish
+    template <typename Iterator>
+    PipelineStats run(Iterator first_, Iterator last_) {
+        start();
+        push_n(first_, last_);
+        return finish();
+    }
+
+private:
+    std::shared_ptr<pipeline_detail::Graph>                   _graph;
+    std::shared_ptr<Channel<pipeline_detail::Sequenced<In>>> _input;
+    std::vector<std::thread>                                  _threads;
+    std::atomic<std::uint64_t>                                _nextSeq;
+    bool                                                      _started;
+    pipeline_detail::Clock::time_point                        _begin;
+};
+
+/// @brief 逐级声明阶段: 每个阶段有名字、并行度, 与上一阶段之间是容量为 options.capacity 的通道
+/// @code
+///     auto pipeline = make_pipeline<std::string>(options)
+///                         .stage("parse", 4, [](std::string line) { return parse(line); })
+///                         .stage("enrich", 2, [](Record r) { return enrich(std::move(r)); })
+///                         .sink("sink", [&](Record r) { store(r); });
+///     PipelineStats stats = pipeline.run(lines.begin(), lines.end());
+/// @endcode
+/// @tparam In  流水线输入类型
+/// @tparam Out 当前最后一个阶段的输出类型
+template <typename In, typename Out = In>
+class PipelineBuilder {
+public:
+    PipelineBuilder(std::shared_ptr<pipeline_detail::Graph>                    graph_,
+                    std::shared_ptr<Channel<pipeline_detail::Sequenced<In>>>  input_,
+                    std::shared_ptr<Channel<pipeline_detail::Sequenced<Out>>> tail_)
+        : _graph(std::move(graph_))
+        , _input(std::move(input_))
+        , _tail(std::move(tail_)) {}
+
+    /// @brief 追加一个变换阶段
+    /// @tparam F R(Out), 每个工作线程持有一份拷贝
+    template <typename F>
+    PipelineBuilder<In, typename std::decay<decltype(std::declval<F &>()(std::declval<Out>()))>::type>
+    stage(std::string name_, std::size_t parallelism_, F f_) {
+        using Next = typename std::decay<decltype(std::declval<F &>()(std::declval<Out>()))>::type;
+        auto counters = add_counters(std::move(name_), parallelism_);
+        auto output   = std::make_shared<Channel<pipeline_detail::Sequenced<Next>>>(_graph->options.capacity);
+        _graph->stages.emplace_back(
+            new pipeline_detail::MapStage<Out, Next, F>(*_graph, counters, _tail, output, std::move(f_)));
+        return PipelineBuilder<In, Next>(_graph, _input, output);
+    }
+
+    /// @brief 追加终点阶段, 得到可运行的流水线; ordered 模式下 parallelism_ 必须为 1
+    template <typename F>
+    Pipeline<In> sink(std::string name_, F f_, std::size_t parallelism_ = 1) {
+        if (_graph->options.ordered && parallelism_ != 1) {
+            throw std::invalid_argument("Pipeline: an ordered sink must be single-threaded");
+        }
+        auto counters = add_counters(std::move(name_), parallelism_);
+        _graph->stages.emplace_back(new pipeline_detail::SinkStage<Out, F>(*_graph, counters, _tail, std::move(f_)));
+        return Pipeline<In>(_graph, _input);
+    }
+
+private:
+    std::shared_ptr<pipeline_detail::StageCounters> add_counters(std::string name_, std::size_t parallelism_) {
+        if (!parallelism_) throw std::invalid_argument("Pipeline: parallelism must be positive");
+        auto counters =
+            std::make_shared<pipeline_detail::StageCounters>(std::move(name_), parallelism_, _tail->capacity());
+        _graph->counters.push_back(counters);
+        return counters;
+    }
+
+    std::shared_ptr<pipeline_detail::Graph>                    _graph;
+    std::shared_ptr<Channel<pipeline_detail::Sequenced<In>>>  _input;
+    std::shared_ptr<Channel<pipeline_detail::Sequenced<Out>>> _tail;
+};
+
+template <typename In>
+PipelineBuilder<In> make_pipeline(PipelineOptions const &options_ = PipelineOptions()) {
+    PipelineOptions options = options_;
+    options.capacity        = std::max<std::size_t>(options.capacity, 1);
+    options.batch           = std::max<std::size_t>(options.batch, 1);
+    auto graph              = std::make_shared<pipeline_detail::Graph>(options);
+    auto input              = std::make_shared<Channel<pipeline_detail::Sequenced<In>>>(options.capacity);
+    return PipelineBuilder<In>(graph, input, input);
+}
+
+#endif //__PIPELINE__
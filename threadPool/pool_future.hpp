@@ -0,0 +1,593 @@
+#ifndef __POOL_FUTURE__
+#define __POOL_FUTURE__
+
+#include "executor.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @brief 线程池上的 future: 完成时把 then 登记的后续任务投递给执行器, 而不是占住一个线程阻塞 get()
+/// 与 std::future 一样只能消费一次, get() / then() 之后失效.
+template <typename T>
+class PoolFuture;
+
+/// @brief PoolFuture<void> 在 when_all 的 tuple 中对应的占位值
+struct Unit {};
+
+namespace future_detail {
+
+template <typename T>
+using Stored = typename std::conditional<std::is_void<T>::value, Unit, T>::type;
+
+/// @brief future 与 promise / 后续任务之间共享的状态
+/// 完成时在锁内置位 _ready 并取走登记的回调, 解锁后依次执行; 完成后登记的回调立即在登记线程执行.
+template <typename T>
+class SharedState {
+public:
+    explicit SharedState(Executor &executor_)
+        : _executor(&executor_)
+        , _ready(false) {}
+    SharedState(const SharedState &)            = delete;
+    SharedState &operator=(const SharedState &) = delete;
+
+    Executor &executor() const { return *_executor; }
+
+    bool ready() const { return _ready.load(std::memory_order_acquire); }
+
+    /// @brief 仅在 ready() 之后调用
+    bool               failed() const { return static_cast<bool>(_exception); }
+    std::exception_ptr exception() const { return _exception; }
+    Stored<T>          take_value() { return std::move(*_value); }
+
+    void set_value(Stored<T> value_) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        check_unsatisfied();
+        _value.reset(new Stored<T>(std::move(value_)));
+        complete(lock);
+    }
+
+    void set_exception(std::exception_ptr exception_) {
+        std::unique_lock<std::mutex> lock(_mtx);
+        check_unsatisfied();
+        _exception = std::move(exception_);
+        complete(lock);
+    }
+
+    void on_ready(FunctionWrapper callback_) {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (!_ready.load(std::memory_order_relaxed)) {
+                _callbacks.push_back(std::move(callback_));
+                return;
+            }
+        }
+        callback_();
+    }
+
+    /// @brief 等待期间帮执行器跑排队任务, 池线程内等待嵌套任务也不会死等
+    void wait() {
+        while (!ready()) {
+            if (_executor->run_pending_task()) continue;
+            std::unique_lock<std::mutex> lock(_mtx);
+            _condv.wait_for(lock, kHelpInterval, [this]() { return ready(); });
+        }
+    }
+
+    Stored<T> take() {
+        wait();
+        if (_exception) std::rethrow_exception(_exception);
+        return take_value();
+    }
+
+private:
+    void check_unsatisfied() const {
+        if (_ready.load(std::memory_order_relaxed)) {
+            throw std::future_error(std::future_errc::promise_already_satisfied);
+        }
+    }
+
+    void complete(std::unique_lock<std::mutex> &lock_) {
+        _ready.store(true, std::memory_order_release);
+        std::vector<FunctionWrapper> callbacks;
+        callbacks.swap(_callbacks);
+        _condv.notify_all();
+        lock_.unlock();
+        for (auto &callback : callbacks) {
+            callback();
+        }
+    }
+
+    static constexpr std::chrono::milliseconds kHelpInterval{1};
+
+    Executor                    *_executor;
+    std::atomic_bool             _ready;
+    std::mutex                   _mtx;
+    std::condition_variable      _condv;
+    std::unique_ptr<Stored<T>>   _value;
+    std::exception_ptr           _exception;
+    std::vector<FunctionWrapper> _callbacks;
+};
+
+template <typename T>
+constexpr std::chrono::milliseconds SharedState<T>::kHelpInterval;
+
+/// @brief 返回 PoolFuture<U> 的后续任务展开为 PoolFuture<U>, 而不是 PoolFuture<PoolFuture<U>>
+template <typename R>
+struct unwrap {
+    using type = R;
+};
+
+template <typename U>
+struct unwrap<PoolFuture<U>> {
+    using type = U;
+};
+
+template <typename F, typename T>
+struct continuation_result {
+    using type = typename std::decay<decltype(std::declval<F &>()(std::declval<T>()))>::type;
+};
+
+template <typename F>
+struct continuation_result<F, void> {
+    using type = typename std::decay<decltype(std::declval<F &>()())>::type;
+};
+
+template <typename T>
+struct AllResult {
+    using type = std::vector<T>;
+};
+
+template <>
+struct AllResult<void> {
+    using type = void;
+};
+
+template <typename T>
+struct AnyResult {
+    using type = std::pair<std::size_t, T>;
+};
+
+template <>
+struct AnyResult<void> {
+    using type = std::size_t;
+};
+
+struct FutureAccess {
+    template <typename T>
+    static PoolFuture<T> make(std::shared_ptr<SharedState<T>> state_) {
+        return PoolFuture<T>(std::move(state_));
+    }
+
+    template <typename T>
+    static std::shared_ptr<SharedState<T>> release(PoolFuture<T> &future_) {
+        if (!future_._state) throw std::future_error(std::future_errc::no_state);
+        return std::move(future_._state);
+    }
+};
+
+/// @brief 把 call_() 的结果写入 target_, 结果本身是 PoolFuture 时等它完成后转交
+template <typename R>
+struct Fulfil {
+    template <typename Call>
+    static void apply(std::shared_ptr<SharedState<R>> const &target_, Call &call_) {
+        target_->set_value(call_());
+    }
+};
+
+template <>
+struct Fulfil<void> {
+    template <typename Call>
+    static void apply(std::shared_ptr<SharedState<void>> const &target_, Call &call_) {
+        call_();
+        target_->set_value(Unit());
+    }
+};
+
+template <typename U>
+struct Fulfil<PoolFuture<U>> {
+    template <typename Call>
+    static void apply(std::shared_ptr<SharedState<U>> const &target_, Call &call_) {
+        PoolFuture<U>                   inner  = call_();
+        std::shared_ptr<SharedState<U>> source = FutureAccess::release(inner);
+        source->on_ready([source, target_]() {
+            if (source->failed()) {
+                target_->set_exception(source->exception());
+            } else {
+                target_->set_value(source->take_value());
+            }
+        });
+    }
+};
+
+template <typename R, typename Call>
+void run(std::shared_ptr<SharedState<typename unwrap<R>::type>> const &target_, Call &call_) {
+    try {
+        Fulfil<R>::apply(target_, call_);
+    } catch (...) {
+        target_->set_exception(std::current_exception());
+    }
+}
+
+template <typename T>
+struct Invoke {
+    template <typename F>
+    static auto apply(F &f_, SharedState<T> &source_) -> decltype(f_(std::declval<T>())) {
+        return f_(source_.take_value());
+    }
+};
+
+template <>
+struct Invoke<void> {
+    template <typename F>
+    static auto apply(F &f_, SharedState<void> &) -> decltype(f_()) {
+        return f_();
+    }
+};
+
+/// @brief when_all 的计数: 第一个失败者负责写异常, 无人失败时最后一个到达者负责汇总结果
+class JoinCounter {
+public:
+    enum Arrival { Pending, FirstFailure, Complete };
+
+    explicit JoinCounter(std::size_t count_)
+        : _remaining(count_)
+        , _failed(false) {}
+
+    Arrival arrive(bool failed_) {
+        // 失败者不递减计数, 因此一旦有人失败就不会再出现 Complete
+        if (failed_) return _failed.exchange(true, std::memory_order_acq_rel) ? Pending : FirstFailure;
+        return _remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 ? Complete : Pending;
+    }
+
+private:
+    std::atomic<std::size_t> _remaining;
+    std::atomic_bool         _failed;
+};
+
+template <typename T>
+std::vector<T> collect(std::vector<std::shared_ptr<SharedState<T>>> &sources_) {
+    std::vector<T> values;
+    values.reserve(sources_.size());
+    for (auto &source : sources_) {
+        values.push_back(source->take_value());
+    }
+    return values;
+}
+
+inline Unit collect(std::vector<std::shared_ptr<SharedState<void>>> &) { return Unit(); }
+
+template <typename T>
+std::pair<std::size_t, T> make_any(std::size_t index_, T value_) {
+    return std::pair<std::size_t, T>(index_, std::move(value_));
+}
+
+inline std::size_t make_any(std::size_t index_, Unit) { return index_; }
+
+template <typename... Ts>
+class TupleJoin : public std::enable_shared_from_this<TupleJoin<Ts...>> {
+public:
+    using Result = std::tuple<Stored<Ts>...>;
+
+    TupleJoin(std::shared_ptr<SharedState<Result>> target_, std::shared_ptr<SharedState<Ts>>... sources_)
+        : _counter(sizeof...(Ts))
+        , _sources(std::move(sources_)...)
+        , _target(std::move(target_)) {}
+
+    void subscribe() { subscribe(std::index_sequence_for<Ts...>()); }
+
+private:
+    template <std::size_t... I>
+    void subscribe(std::index_sequence<I...>) {
+        int expand[] = {0, (subscribe_one<I>(), 0)...};
+        (void)expand;
+    }
+
+    template <std::size_t I>
+    void subscribe_one() {
+        std::shared_ptr<TupleJoin> self = this->shared_from_this();
+        std::get<I>(_sources)->on_ready([self]() { self->arrive(*std::get<I>(self->_sources)); });
+    }
+
+    template <typename Source>
+    void arrive(Source &source_) {
+        switch (_counter.arrive(source_.failed())) {
+        case JoinCounter::FirstFailure:
+            _target->set_exception(source_.exception());
+            break;
+        case JoinCounter::Complete:
+            try {
+                _target->set_value(collect(std::index_sequence_for<Ts...>()));
+            } catch (...) {
+                _target->set_exception(std::current_exception());
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    template <std::size_t... I>
+    Result collect(std::index_sequence<I...>) {
+        return Result(std::get<I>(_sources)->take_value()...);
+    }
+
+    JoinCounter                                     _counter;
+    std::tuple<std::shared_ptr<SharedState<Ts>>...> _sources;
+    std::shared_ptr<SharedState<Result>>            _target;
+};
+
+} // namespace future_detail
+
+template <typename T>
+class PoolFuture {
+public:
+    PoolFuture() = default;
+
+    bool valid() const { return static_cast<bool>(_state); }
+
+    /// @brief 结果(或异常)是否已就绪, 不阻塞
+    bool ready() const { return state().ready(); }
+
+    /// @brief 阻塞到就绪, 等待期间帮执行器跑排队任务
+    void wait() const { state().wait(); }
+
+    /// @brief 取出结果, 失败时重新抛出异常; 之后 future 失效
+    T get() {
+        std::shared_ptr<future_detail::SharedState<T>> state = future_detail::FutureAccess::release(*this);
+        return static_cast<T>(state->take());
+    }
+
+    /// @brief 后续任务所在的执行器
+    Executor &executor() const { return state().executor(); }
+
+    /// @brief 就绪后把 f_(value) 投递给 executor_, 返回后续任务的 future; 之后本 future 失效
+    /// 本 future 失败时不调用 f_, 异常直接传给返回的 future. f_ 返回 PoolFuture<U> 时结果展开为 PoolFuture<U>.
+    /// @tparam F R(T), T 为 void 时为 R()
+    /// @param executor_
+    /// @param f_
+    /// @return
+    template <typename F>
+    PoolFuture<typename future_detail::unwrap<typename future_detail::continuation_result<F, T>::type>::type>
+    then(Executor &executor_, F f_) {
+        using R      = typename future_detail::continuation_result<F, T>::type;
+        using Target = future_detail::SharedState<typename future_detail::unwrap<R>::type>;
+
+        std::shared_ptr<future_detail::SharedState<T>> source   = future_detail::FutureAccess::release(*this);
+        std::shared_ptr<Target>                        target   = std::make_shared<Target>(executor_);
+        Executor                                      *executor = &executor_;
+        source->on_ready([source, target, executor, f = std::move(f_)]() mutable {
+            if (source->failed()) {
+                target->set_exception(source->exception());
+                return;
+            }
+            try {
+                executor->post([source, target, f = std::move(f)]() mutable {
+                    auto call = [&]() { return future_detail::Invoke<T>::apply(f, *source); };
+                    future_detail::run<R>(target, call);
+                });
+            } catch (...) {
+                target->set_exception(std::current_exception());
+            }
+        });
+        return future_detail::FutureAccess::make(std::move(target));
+    }
+
+    /// @brief 后续任务投递到本 future 的执行器
+    template <typename F>
+    PoolFuture<typename future_detail::unwrap<typename future_detail::continuation_result<F, T>::type>::type>
+    then(F f_) {
+        return then(executor(), std::move(f_));
+    }
+
+private:
+    friend struct future_detail::FutureAccess;
+
+    explicit PoolFuture(std::shared_ptr<future_detail::SharedState<T>> state_)
+        : _state(std::move(state_)) {}
+
+    future_detail::SharedState<T> &state() const {
+        if (!_state) throw std::future_error(std::future_errc::no_state);
+        return *_state;
+    }
+
+    std::shared_ptr<future_detail::SharedState<T>> _state;
+};
+
+/// @brief 手动完成的 PoolFuture; 未设置结果就析构时, future 得到 broken_promise
+template <typename T>
+class PoolPromise {
+public:
+    explicit PoolPromise(Executor &executor_ = default_executor())
+        : _state(std::make_shared<future_detail::SharedState<T>>(executor_))
+        , _retrieved(false) {}
+    PoolPromise(PoolPromise &&)                 = default;
+    PoolPromise &operator=(PoolPromise &&)      = delete;
+    PoolPromise(const PoolPromise &)            = delete;
+    PoolPromise &operator=(const PoolPromise &) = delete;
+
+    ~PoolPromise() {
+        if (_state && !_state->ready()) {
+            _state->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+    PoolFuture<T> get_future() {
+        if (!_state) throw std::future_error(std::future_errc::no_state);
+        if (_retrieved) throw std::future_error(std::future_errc::future_already_retrieved);
+        _retrieved = true;
+        return future_detail::FutureAccess::make(_state);
+    }
+
+    void set_value(future_detail::Stored<T> value_) { checked_state().set_value(std::move(value_)); }
+
+    template <typename U = T, typename = typename std::enable_if<std::is_void<U>::value>::type>
+    void set_value() {
+        checked_state().set_value(Unit());
+    }
+
+    void set_exception(std::exception_ptr exception_) { checked_state().set_exception(std::move(exception_)); }
+
+private:
+    future_detail::SharedState<T> &checked_state() {
+        if (!_state) throw std::future_error(std::future_errc::no_state);
+        return *_state;
+    }
+
+    std::shared_ptr<future_detail::SharedState<T>> _state;
+    bool                                           _retrieved;
+};
+
+/// @brief 把 f_ 投递给执行器, 返回其结果的 PoolFuture; f_ 返回 PoolFuture<U> 时展开
+/// @tparam F R()
+/// @param f_
+/// @param executor_
+/// @return
+template <typename F>
+PoolFuture<typename future_detail::unwrap<typename future_detail::continuation_result<F, void>::type>::type>
+pool_async(F f_, Executor &executor_ = default_executor()) {
+    using R      = typename future_detail::continuation_result<F, void>::type;
+    using Target = future_detail::SharedState<typename future_detail::unwrap<R>::type>;
+
+    std::shared_ptr<Target> target = std::make_shared<Target>(executor_);
+    executor_.post([target, f = std::move(f_)]() mutable { future_detail::run<R>(target, f); });
+    return future_detail::FutureAccess::make(std::move(target));
+}
+
+/// @brief 已就绪的 PoolFuture
+template <typename T>
+PoolFuture<typename std::decay<T>::type> make_ready_future(T &&value_, Executor &executor_ = default_executor()) {
+    using Value = typename std::decay<T>::type;
+    auto state  = std::make_shared<future_detail::SharedState<Value>>(executor_);
+    state->set_value(std::forward<T>(value_));
+    return future_detail::FutureAccess::make(std::move(state));
+}
+
+inline PoolFuture<void> make_ready_future(Executor &executor_ = default_executor()) {
+    auto state = std::make_shared<future_detail::SharedState<void>>(executor_);
+    state->set_value(Unit());
+    return future_detail::FutureAccess::make(std::move(state));
+}
+
+/// @brief 全部就绪后得到按原顺序排列的结果; 任一失败时立即以第一个异常结束
+/// 结果 future 使用第一个 future 的执行器, 为空时使用默认执行器并立即就绪.
+/// @tparam T
+/// @param futures_
+/// @return PoolFuture<std::vector<T>>, T 为 void 时为 PoolFuture<void>
+template <typename T>
+PoolFuture<typename future_detail::AllResult<T>::type> when_all(std::vector<PoolFuture<T>> futures_) {
+    using Result = typename future_detail::AllResult<T>::type;
+    using Source = std::shared_ptr<future_detail::SharedState<T>>;
+
+    struct Join {
+        explicit Join(std::size_t count_)
+            : counter(count_) {}
+        future_detail::JoinCounter                            counter;
+        std::vector<Source>                                   sources;
+        std::shared_ptr<future_detail::SharedState<Result>> target;
+    };
+
+    Executor &executor = futures_.empty() ? default_executor() : futures_.front().executor();
+    auto      join     = std::make_shared<Join>(futures_.size());
+    join->target       = std::make_shared<future_detail::SharedState<Result>>(executor);
+    join->sources.reserve(futures_.size());
+    for (auto &future : futures_) {
+        join->sources.push_back(future_detail::FutureAccess::release(future));
+    }
+    if (join->sources.empty()) {
+        join->target->set_value(future_detail::Stored<Result>());
+        return future_detail::FutureAccess::make(join->target);
+    }
+
+    std::shared_ptr<future_detail::SharedState<Result>> target = join->target;
+    for (Source const &source : join->sources) {
+        future_detail::SharedState<T> *raw = source.get();
+        source->on_ready([join, raw]() {
+            switch (join->counter.arrive(raw->failed())) {
+            case future_detail::JoinCounter::FirstFailure:
+                join->target->set_exception(raw->exception());
+                break;
+            case future_detail::JoinCounter::Complete:
+                try {
+                    join->target->set_value(future_detail::collect(join->sources));
+                } catch (...) {
+                    join->target->set_exception(std::current_exception());
+                }
+                break;
+            default:
+                break;
+            }
+        });
+    }
+    return future_detail::FutureAccess::make(std::move(target));
+}
+
+/// @brief 异构版本, 结果为各值组成的 tuple (void 对应 Unit)
+template <typename T, typename... Ts>
+PoolFuture<std::tuple<future_detail::Stored<T>, future_detail::Stored<Ts>...>> when_all(PoolFuture<T> first_,
+                                                                                         PoolFuture<Ts>... rest_) {
+    using Join   = future_detail::TupleJoin<T, Ts...>;
+    using Target = future_detail::SharedState<typename Join::Result>;
+
+    auto target = std::make_shared<Target>(first_.executor());
+    auto join   = std::make_shared<Join>(target, future_detail::FutureAccess::release(first_),
+                                       future_detail::FutureAccess::release(rest_)...);
+    join->subscribe();
+    return future_detail::FutureAccess::make(std::move(target));
+}
+
+/// @brief 第一个就绪(成功或失败)的 future 决定结果: 成功时为 (下标, 值), T 为 void 时只有下标
+/// @tparam T
+/// @param futures_ 不能为空
+/// @return
+template <typename T>
+PoolFuture<typename future_detail::AnyResult<T>::type> when_any(std::vector<PoolFuture<T>> futures_) {
+    using Result = typename future_detail::AnyResult<T>::type;
+    using Source = std::shared_ptr<future_detail::SharedState<T>>;
+
+    if (futures_.empty()) throw std::invalid_argument("when_any: no futures");
+
+    struct Race {
+        Race()
+            : decided(false) {}
+        std::atomic_bool                                      decided;
+        std::shared_ptr<future_detail::SharedState<Result>> target;
+    };
+
+    auto race    = std::make_shared<Race>();
+    race->target = std::make_shared<future_detail::SharedState<Result>>(futures_.front().executor());
+
+    std::vector<Source> sources;
+    sources.reserve(futures_.size());
+    for (auto &future : futures_) {
+        sources.push_back(future_detail::FutureAccess::release(future));
+    }
+    std::shared_ptr<future_detail::SharedState<Result>> target = race->target;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        Source source = sources[i];
+        source->on_ready([race, source, i]() {
+            if (race->decided.exchange(true, std::memory_order_acq_rel)) return;
+            if (source->failed()) {
+                race->target->set_exception(source->exception());
+                return;
+            }
+            try {
+                race->target->set_value(future_detail::make_any(i, source->take_value()));
+            } catch (...) {
+                race->target->set_exception(std::current_exception());
+            }
+        });
+    }
+    return future_detail::FutureAccess::make(std::move(target));
+}
+
+#endif //__POOL_FUTURE__
@@ -0,0 +1,243 @@
+#ifndef __PROFILED_MUTEX__
+#define __PROFILED_MUTEX__
+
+#include "sharded_counter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// 锁竞争统计.
+/// 加锁的容器 (ThreadSafeQueue / ThraedSafeList / ThreadSafeLookUpTable / CircularQueue / DNService) 把互斥量类型作为模板参数,
+/// 换成 ProfiledMutex<> 即可按锁名统计获取次数、竞争次数、累计等待时间与最长持有时间, lock_profile::report() 按等待时间排序,
+/// 排在最前的就是最热的锁. 默认模板参数仍是标准互斥量, 不改变原有行为.
+namespace lock_profile {
+
+inline std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/// @brief 同名的锁共用一份统计; 累加量按线程分片, 统计本身不会在锁之外再制造一个热点缓存行
+struct LockStats {
+    explicit LockStats(std::string name_)
+        : name(std::move(name_))
+        , maxHoldNs(0) {}
+
+    std::string const          name;
+    ShardedCounter             acquisitions; // 含共享方式
+    ShardedCounter             contended;    // 第一次 try_lock 失败、需要等待的次数
+    ShardedCounter             waitNs;
+    ShardedCounter             holdNs; // 只统计独占方式
+    std::atomic<std::uint64_t> maxHoldNs;
+};
+
+struct LockReport {
+    std::string   name;
+    std::uint64_t acquisitions = 0;
+    std::uint64_t contended    = 0;
+    std::uint64_t waitNs       = 0;
+    std::uint64_t holdNs       = 0;
+    std::uint64_t maxHoldNs    = 0;
+
+    double contention_ratio() const { return acquisitions ? static_cast<double>(contended) / acquisitions : 0; }
+};
+
+/// @brief 全局登记表, 不析构: 静态对象里的锁在程序退出时仍可能被使用
+class Registry {
+public:
+    static Registry &instance() {
+        static Registry *registry = new Registry;
+        return *registry;
+    }
+
+    /// @brief 按名字查表, 每次都要拿全局锁并构造 string; 频繁创建的锁应缓存结果 (见 name_lock)
+    LockStats &stats_for(char const *name_) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        ++_lookups;
+        std::unique_ptr<LockStats> &stats = _stats[name_];
+        if (!stats) stats.reset(new LockStats(name_));
+        return *stats;
+    }
+
+    /// @brief 按累计等待时间从高到低, 略过从未加锁的名字 (如改名前的默认名)
+    std::vector<LockReport> report() const {
+        std::vector<LockReport> reports;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            for (auto const &entry : _stats) {
+                LockStats const &stats = *entry.second;
+                LockReport       report;
+                report.name         = stats.name;
+                report.acquisitions = stats.acquisitions.load();
+                report.contended    = stats.contended.load();
+                report.waitNs       = stats.waitNs.load();
+                report.holdNs       = stats.holdNs.load();
+                report.maxHoldNs    = stats.maxHoldNs.load(std::memory_order_relaxed);
+                if (report.acquisitions) reports.push_back(std::move(report));
+            }
+        }
+        std::stable_sort(reports.begin(), reports.end(),
+                         [](LockReport const &a_, LockReport const &b_) { return a_.waitNs > b_.waitNs; });
+        return reports;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        for (auto &entry : _stats) {
+            LockStats &stats = *entry.second;
+            stats.acquisitions.reset();
+            stats.contended.reset();
+            stats.waitNs.reset();
+            stats.holdNs.reset();
+            stats.maxHoldNs.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief stats_for 被调用的次数, 用于确认加锁和建锁的热路径上没有查表
+    std::uint64_t lookups() const {
+        std::lock_guard<std::mutex> lock(_mtx);
+        return _lookups;
+    }
+
+private:
+    Registry()
+        : _lookups(0) {}
+
+    mutable std::mutex                                _mtx;
+    std::map<std::string, std::unique_ptr<LockStats>> _stats;
+    std::uint64_t                                     _lookups;
+};
+
+inline std::vector<LockReport> report() { return Registry::instance().report(); }
+inline void                    reset() { Registry::instance().reset(); }
+
+/// @brief 打印前 top_ 把锁的统计表
+inline void write_report(std::ostream &out_, std::size_t top_ = 20) {
+    std::vector<LockReport> const reports = report();
+    out_ << std::left << std::setw(32) << "lock" << std::right << std::setw(14) << "acquisitions" << std::setw(12)
+         << "contended" << std::setw(14) << "wait(us)" << std::setw(14) << "hold(us)" << std::setw(14)
+         << "max hold(us)" << '\n';
+    for (std::size_t i = 0; i < reports.size() && i < top_; ++i) {
+        LockReport const &r = reports[i];
+        out_ << std::left << std::setw(32) << r.name << std::right << std::setw(14) << r.acquisitions << std::setw(12)
+             << r.contended << std::fixed << std::setprecision(1) << std::setw(14) << r.waitNs / 1e3 << std::setw(14)
+             << r.holdNs / 1e3 << std::setw(14) << r.maxHoldNs / 1e3 << '\n';
+    }
+}
+
+} // namespace lock_profile
+
+/// @brief 带统计的互斥量, 可替换 std::mutex / std::shared_mutex 等 (满足 Lockable, 包装共享互斥量时也满足 SharedLockable)
+/// 先 try_lock, 失败才计为一次竞争并计时等待; 持有时间从拿到锁记到 unlock.
+/// 搭配条件变量时需用 std::condition_variable_any.
+/// @tparam Mutex 被包装的互斥量
+template <typename Mutex = std::mutex>
+class ProfiledMutex {
+public:
+    /// @brief 未命名的锁共用 "unnamed" 一份统计, 整个进程只查一次表
+    ProfiledMutex()
+        : ProfiledMutex(unnamed_stats()) {}
+    explicit ProfiledMutex(char const *name_)
+        : ProfiledMutex(lock_profile::Registry::instance().stats_for(name_)) {}
+    /// @brief 使用调用方已查好的统计, 不查表
+    explicit ProfiledMutex(lock_profile::LockStats &stats_)
+        : _stats(&stats_)
+        , _lockedAt(0) {}
+    ProfiledMutex(const ProfiledMutex &)            = delete;
+    ProfiledMutex &operator=(const ProfiledMutex &) = delete;
+
+    /// @brief 改名, 只能在开始使用前调用
+    void set_name(char const *name_) { _stats = &lock_profile::Registry::instance().stats_for(name_); }
+    void set_stats(lock_profile::LockStats &stats_) { _stats = &stats_; }
+
+    std::string const &name() const { return _stats->name; }
+
+    void lock() {
+        if (!_mutex.try_lock()) {
+            std::uint64_t const start = lock_profile::now_ns();
+            _mutex.lock();
+            contended(start);
+        }
+        acquired();
+        _lockedAt = lock_profile::now_ns();
+    }
+
+    bool try_lock() {
+        if (!_mutex.try_lock()) return false;
+        acquired();
+        _lockedAt = lock_profile::now_ns();
+        return true;
+    }
+
+    void unlock() {
+        std::uint64_t const hold = lock_profile::now_ns() - _lockedAt;
+        _mutex.unlock();
+        _stats->holdNs.add(hold);
+        std::uint64_t current = _stats->maxHoldNs.load(std::memory_order_relaxed);
+        while (hold > current &&
+               !_stats->maxHoldNs.compare_exchange_weak(current, hold, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// 以下仅当 Mutex 是共享互斥量时可用
+    void lock_shared() {
+        if (!_mutex.try_lock_shared()) {
+            std::uint64_t const start = lock_profile::now_ns();
+            _mutex.lock_shared();
+            contended(start);
+        }
+        acquired();
+    }
+
+    bool try_lock_shared() {
+        if (!_mutex.try_lock_shared()) return false;
+        acquired();
+        return true;
+    }
+
+    void unlock_shared() { _mutex.unlock_shared(); }
+
+private:
+    static lock_profile::LockStats &unnamed_stats() {
+        static lock_profile::LockStats &stats = lock_profile::Registry::instance().stats_for("unnamed");
+        return stats;
+    }
+
+    void acquired() { _stats->acquisitions.add(); }
+
+    void contended(std::uint64_t start_) {
+        _stats->contended.add();
+        _stats->waitNs.add(lock_profile::now_ns() - start_);
+    }
+
+    Mutex                    _mutex;
+    lock_profile::LockStats *_stats;
+    std::uint64_t            _lockedAt; // 只由持有者读写
+};
+
+/// @brief 给容器里的锁起名, 用于统计; 对普通互斥量是空操作.
+/// name_ 是名字时每次都查表; 每个元素一把锁的容器 (如链表结点) 改传返回 LockStats & 的函数,
+/// 由函数内的静态变量缓存查表结果, 插入元素时不再争登记表的全局锁
+template <typename Mutex, typename Name>
+inline void name_lock(Mutex &, Name) {}
+
+template <typename Mutex>
+inline void name_lock(ProfiledMutex<Mutex> &mutex_, char const *name_) {
+    mutex_.set_name(name_);
+}
+
+template <typename Mutex>
+inline void name_lock(ProfiledMutex<Mutex> &mutex_, lock_profile::LockStats &(*stats_)()) {
+    mutex_.set_stats(stats_());
+}
+
+#endif //__PROFILED_MUTEX__
@@ -0,0 +1,197 @@
+#ifndef __QUEUE_LATENCY__
+#define __QUEUE_LATENCY__
+
+#include "cache_padded.hpp"
+#include "sharded_counter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/// 队列的入队到出队等待时间统计.
+/// 定义 QUEUE_LATENCY_TRACKING (CMake: -DCONCURRENCY_QUEUE_LATENCY=ON) 后, ThreadSafeQueue / LockFreeThreadSafeQueue /
+/// LockFreeQueue / CircularQueue* / Channel 在 push 时给元素打时间戳, pop 时把等待时间记入队列自带的直方图,
+/// 并提供 latency_snapshot(); 未定义时结点里没有时间戳字段, 记录函数为空, 不产生任何开销.
+/// 直方图本身不受该宏控制, 可单独使用.
+namespace latency {
+
+inline std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/// @brief HDR 风格的对数-线性分桶: 小于 kSubBuckets 的值每个值一桶, 之后每个 2 的幂区间再均分 kSubBuckets 份,
+/// 相对误差不超过 1 / kSubBuckets; 超过 kMaxValue 的值计入最后一桶
+struct Buckets {
+    static constexpr unsigned      kSubBits    = 5;
+    static constexpr unsigned      kSubBuckets = 1u << kSubBits;
+    static constexpr unsigned      kMaxBits    = 36; // 2^36 ns 约 68 秒
+    static constexpr std::uint64_t kMaxValue   = (std::uint64_t(1) << kMaxBits) - 1;
+    static constexpr std::size_t   kCount      = (kMaxBits - kSubBits + 1) * kSubBuckets;
+
+    static std::size_t index_of(std::uint64_t value_) {
+        if (value_ > kMaxValue) value_ = kMaxValue;
+        if (value_ < kSubBuckets) return static_cast<std::size_t>(value_);
+        unsigned exponent = 0;
+        for (std::uint64_t v = value_; v >>= 1;) ++exponent;
+        unsigned const shift = exponent - kSubBits;
+        return (shift + 1) * kSubBuckets + static_cast<std::size_t>((value_ >> shift) - kSubBuckets);
+    }
+
+    /// @brief 桶内的最大值, 报告分位数时取它, 宁可高估也不低估
+    static std::uint64_t highest_of(std::size_t index_) {
+        if (index_ < kSubBuckets) return index_;
+        unsigned const      shift = static_cast<unsigned>(index_ / kSubBuckets) - 1;
+        std::uint64_t const lower = (kSubBuckets + index_ % kSubBuckets) << shift;
+        return lower + (std::uint64_t(1) << shift) - 1;
+    }
+};
+
+/// @brief 某一时刻的直方图副本, 单位纳秒
+class Snapshot {
+public:
+    Snapshot()
+        : _counts(Buckets::kCount, 0)
+        , _count(0)
+        , _sum(0)
+        , _min(std::numeric_limits<std::uint64_t>::max())
+        , _max(0) {}
+
+    std::uint64_t count() const { return _count; }
+    std::uint64_t min() const { return _count ? _min : 0; }
+    std::uint64_t max() const { return _max; }
+    double        mean() const { return _count ? static_cast<double>(_sum) / _count : 0; }
+
+    /// @brief 第 percentile_ (0..100) 百分位的等待时间, 精确到所在桶, 不超过记录到的最大值
+    std::uint64_t percentile(double percentile_) const {
+        if (_count == 0) return 0;
+        double const        clamped = std::min(100.0, std::max(0.0, percentile_));
+        std::uint64_t const rank    = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(clamped / 100.0 * static_cast<double>(_count) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < _counts.size(); ++i) {
+            seen += _counts[i];
+            if (seen >= rank) return std::max(min(), std::min(Buckets::highest_of(i), _max));
+        }
+        return _max;
+    }
+
+    /// @brief 合并另一份快照, 用于汇总多个队列
+    Snapshot &merge(Snapshot const &other_) {
+        for (std::size_t i = 0; i < _counts.size(); ++i) _counts[i] += other_._counts[i];
+        _count += other_._count;
+        _sum += other_._sum;
+        _min = std::min(_min, other_._min);
+        _max = std::max(_max, other_._max);
+        return *this;
+    }
+
+private:
+    friend class Histogram;
+
+    std::vector<std::uint64_t> _counts;
+    std::uint64_t              _count;
+    std::uint64_t              _sum;
+    std::uint64_t              _min;
+    std::uint64_t              _max;
+};
+
+/// @brief 无锁直方图: 按线程分成 kShards 个分片, 线程固定写自己那一片 (relaxed 原子加), 分片首次写入时才分配;
+/// snapshot() 汇总各分片, 与并发的 record 不互斥, 得到的是近似一致的副本.
+/// 分片数与 ShardedCounter 相同, 同一线程在两者中落在同一序号; 记录的线程超过 kShards 个时
+/// 多个线程共用一片, 结果仍然正确, 但共用的线程之间会争同一组计数与最值
+class Histogram {
+public:
+    static constexpr std::size_t kShards = ShardedCounter::kShards;
+
+    Histogram() {
+        for (auto &shard : _shards) shard.value.store(nullptr, std::memory_order_relaxed);
+    }
+    Histogram(const Histogram &)            = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    ~Histogram() {
+        for (auto &shard : _shards) delete shard.value.load(std::memory_order_relaxed);
+    }
+
+    void record(std::uint64_t value_) {
+        Shard &shard = local_shard();
+        shard.counts[Buckets::index_of(value_)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value_, std::memory_order_relaxed);
+        std::uint64_t current = shard.min.load(std::memory_order_relaxed);
+        while (value_ < current && !shard.min.compare_exchange_weak(current, value_, std::memory_order_relaxed)) {
+        }
+        current = shard.max.load(std::memory_order_relaxed);
+        while (value_ > current && !shard.max.compare_exchange_weak(current, value_, std::memory_order_relaxed)) {
+        }
+    }
+
+    /// @brief 记录从 stamp_ (now_ns()) 到现在的时间
+    void record_since(std::uint64_t stamp_) {
+        std::uint64_t const now = now_ns();
+        record(now > stamp_ ? now - stamp_ : 0);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snapshot;
+        for (auto const &slot : _shards) {
+            Shard const *shard = slot.value.load(std::memory_order_acquire);
+            if (!shard) continue;
+            for (std::size_t i = 0; i < Buckets::kCount; ++i) {
+                snapshot._counts[i] += shard->counts[i].load(std::memory_order_relaxed);
+            }
+            snapshot._sum += shard->sum.load(std::memory_order_relaxed);
+            snapshot._min = std::min(snapshot._min, shard->min.load(std::memory_order_relaxed));
+            snapshot._max = std::max(snapshot._max, shard->max.load(std::memory_order_relaxed));
+        }
+        for (std::uint64_t c : snapshot._counts) snapshot._count += c;
+        return snapshot;
+    }
+
+    /// @brief 清零, 不能与 record 并发
+    void reset() {
+        for (auto &slot : _shards) {
+            Shard *shard = slot.value.load(std::memory_order_relaxed);
+            if (shard) shard->clear();
+        }
+    }
+
+private:
+    struct Shard {
+        Shard() { clear(); }
+
+        void clear() {
+            for (auto &c : counts) c.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+            min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+            max.store(0, std::memory_order_relaxed);
+        }
+
+        std::atomic<std::uint64_t> counts[Buckets::kCount];
+        std::atomic<std::uint64_t> sum;
+        std::atomic<std::uint64_t> min;
+        std::atomic<std::uint64_t> max;
+    };
+
+    Shard &local_shard() {
+        std::atomic<Shard *> &slot  = _shards[thread_shard_index() % kShards].value;
+        Shard                *shard = slot.load(std::memory_order_acquire);
+        if (shard) return *shard;
+        Shard *fresh = new Shard;
+        if (slot.compare_exchange_strong(shard, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return *fresh;
+        }
+        delete fresh; // 同一分片的另一个线程先装好了
+        return *shard;
+    }
+
+    CachePadded<std::atomic<Shard *>> _shards[kShards];
+};
+
+} // namespace latency
+
+#endif //__QUEUE_LATENCY__
@@ -5,6 +5,7 @@
  * @LastEditors: Ye Guosheng
  * @Description:
  */
+#include "co_task.hpp"
 #include "notify_thread_pool.hpp"
 #include "parallen_thread_pool.hpp"
 #include "simple_thread_pool.hpp"
@@ -114,3 +115,35 @@ std::list<T> steal_pool_thread_sort(std::list<T> input) {
     res.splice(res.begin(), newLower.get());
     return res;
 }
+
+#ifdef CO_TASK_ENABLED
+/// @brief steal_pool_thread_sort 的协程版本: 较小一半 spawn 到池上, 汇合时 co_await 挂起而不是阻塞在 get() 上,
+/// 较大一半通过对称转移在本线程递归, 退化的划分也不会压深调用栈
+template <typename T>
+CoTask<std::list<T>> co_steal_sort(std::list<T> input, StealThreadPool &pool_) {
+    if (input.empty()) co_return input;
+
+    std::list<T> res;
+    res.splice(res.begin(), input, input.begin());
+    T const &partitionVal = *res.begin();
+
+    typename std::list<T>::iterator dividePoint =
+        std::partition(input.begin(), input.end(), [&](T const &value_) { return value_ < partitionVal; });
+
+    std::list<T> newLowerChunk;
+    newLowerChunk.splice(newLowerChunk.end(), input, input.begin(), dividePoint);
+
+    CoTask<std::list<T>> newLower = spawn(co_steal_sort(std::move(newLowerChunk), pool_), pool_);
+
+    std::list<T> newHigher = co_await co_steal_sort(std::move(input), pool_);
+    res.splice(res.end(), newHigher);
+    res.splice(res.begin(), co_await newLower);
+    co_return res;
+}
+
+template <typename T>
+std::list<T> co_steal_pool_thread_sort(std::list<T> input) {
+    StealThreadPool &pool = StealThreadPool::instance();
+    return sync_wait(co_steal_sort(std::move(input), pool), pool);
+}
+#endif // CO_TASK_ENABLED
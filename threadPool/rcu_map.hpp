@@ -0,0 +1,128 @@
+#ifndef __RCU_MAP__
+#define __RCU_MAP__
+
+#include "hazard_pointer.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/// @brief 读-复制-更新的映射表: 当前版本是一份不可变的 Map, 读者不加锁, 写者复制一份改完再整体发布.
+/// 点查只在本线程的危险指针槽位上登记当前版本, 不碰任何共享计数, 查询延迟与写者是否在改无关;
+/// snapshot() 返回带引用计数的整份副本, 可长时间遍历, 之后的更新不影响它.
+/// 被替换的版本经 hazard::retire 交给危险指针回收, 每次发布后立即扫描: 没有读者在看的旧版本当场释放,
+/// 仍被读者保护的留到下一次发布时再看, 积压的旧版本不超过同时在读的线程数.
+/// 写者之间用互斥量串行, 每次更新复制整个 Map, 只适合更新极少 (如百万次读一次写) 的场景.
+/// 查询期间占用危险指针第 0 个槽位, Value 的拷贝中不要再使用基于危险指针的结构.
+/// @tparam Key
+/// @tparam Value
+/// @tparam Map 底层映射, 需可拷贝, 提供 find / emplace / erase
+template <typename Key, typename Value, typename Map = std::unordered_map<Key, Value>>
+class RcuMap {
+public:
+    using map_type = Map;
+    using Snapshot = std::shared_ptr<Map const>;
+
+    RcuMap()
+        : _current(new Version(std::make_shared<Map>())) {}
+    explicit RcuMap(Map map_)
+        : _current(new Version(std::make_shared<Map>(std::move(map_)))) {}
+    RcuMap(const RcuMap &)            = delete;
+    RcuMap &operator=(const RcuMap &) = delete;
+
+    /// @brief 不能与读写并发
+    ~RcuMap() { delete _current.load(std::memory_order_relaxed); }
+
+    /// @brief 查找 key_, 找到时拷贝到 value_
+    bool find(Key const &key_, Value &value_) const {
+        Version const *const version = hazard::protect(0, _current);
+        auto const           it      = version->map->find(key_);
+        bool const           found   = it != version->map->end();
+        if (found) value_ = it->second;
+        hazard::clear(0);
+        return found;
+    }
+
+    Value value_for(Key const &key_, Value const &default_value_ = Value()) const {
+        Value value;
+        return find(key_, value) ? value : default_value_;
+    }
+
+    bool contains(Key const &key_) const {
+        Version const *const version = hazard::protect(0, _current);
+        bool const           found   = version->map->find(key_) != version->map->end();
+        hazard::clear(0);
+        return found;
+    }
+
+    std::size_t size() const {
+        Version const *const version = hazard::protect(0, _current);
+        std::size_t const    count   = version->map->size();
+        hazard::clear(0);
+        return count;
+    }
+
+    /// @brief 当前版本的只读副本, 持有期间不会被释放
+    Snapshot snapshot() const {
+        Version const *const version = hazard::protect(0, _current);
+        Snapshot             map     = version->map;
+        hazard::clear(0);
+        return map;
+    }
+
+    /// @brief 复制当前版本, 交给 update_(Map &) 修改后发布; 多处修改放在一次 update 里只复制一次
+    template <typename Update>
+    void update(Update update_) {
+        std::lock_guard<std::mutex> lock(_writerMtx);
+        std::shared_ptr<Map>        next = std::make_shared<Map>(*_current.load(std::memory_order_relaxed)->map);
+        update_(*next);
+        publish(std::move(next));
+    }
+
+    void insert_or_assign(Key const &key_, Value const &value_) {
+        update([&key_, &value_](Map &map_) {
+            auto const result = map_.emplace(key_, value_);
+            if (!result.second) result.first->second = value_;
+        });
+    }
+
+    /// @return key_ 不存在时返回 false, 不发布新版本
+    bool erase(Key const &key_) {
+        std::lock_guard<std::mutex> lock(_writerMtx);
+        Map const &current = *_current.load(std::memory_order_relaxed)->map;
+        if (current.find(key_) == current.end()) return false;
+        std::shared_ptr<Map> next = std::make_shared<Map>(current);
+        next->erase(key_);
+        publish(std::move(next));
+        return true;
+    }
+
+    /// @brief 整体替换
+    void assign(Map map_) {
+        std::lock_guard<std::mutex> lock(_writerMtx);
+        publish(std::make_shared<Map>(std::move(map_)));
+    }
+
+private:
+    /// @brief 危险指针保护的是版本结点, 结点持有 Map 的一份引用; 结点回收后, 还被 snapshot 持有的 Map 继续存活
+    struct Version {
+        explicit Version(Snapshot map_)
+            : map(std::move(map_)) {}
+
+        Snapshot const map;
+    };
+
+    /// @brief 持 _writerMtx 调用; 旧版本持有整份 Map, 不等 retire 攒满一批就扫描
+    void publish(Snapshot map_) {
+        Version *const previous = _current.exchange(new Version(std::move(map_)), std::memory_order_acq_rel);
+        hazard::retire(previous);
+        hazard::scan();
+    }
+
+    std::atomic<Version *> _current;
+    std::mutex             _writerMtx;
+};
+
+#endif //__RCU_MAP__
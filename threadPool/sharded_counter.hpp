@@ -0,0 +1,65 @@
+#ifndef __SHARDED_COUNTER__
+#define __SHARDED_COUNTER__
+
+#include "cache_padded.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief 线程的分片序号: 每个线程第一次调用时领一个递增编号, 之后固定不变;
+/// 同一线程在所有分片结构 (计数器、直方图) 里落在同一序号, 线程数不超过分片数时互不共享缓存行
+inline std::size_t thread_shard_index() {
+    static std::atomic<std::size_t> next(0);
+    thread_local std::size_t const  index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+/// @brief 按线程分片的统计计数器: 写只做本线程分片上的 relaxed 加法, 不同线程不争同一缓存行; 读时汇总各分片.
+/// 用于只增不读 (或很少读) 的统计量, 读到的是近似值, 不能用来做同步或判断
+/// @tparam Shards 分片数, 线程数超过时多个线程共用一片, 结果仍然正确
+template <std::size_t Shards = 16>
+class BasicShardedCounter {
+public:
+    static constexpr std::size_t kShards = Shards;
+
+    /// 常量初始化, 可安全地用作静态成员
+    constexpr BasicShardedCounter()
+        : _shards() {}
+    BasicShardedCounter(const BasicShardedCounter &)            = delete;
+    BasicShardedCounter &operator=(const BasicShardedCounter &) = delete;
+
+    void add(std::uint64_t delta_ = 1) {
+        _shards[thread_shard_index() % Shards].value.fetch_add(delta_, std::memory_order_relaxed);
+    }
+
+    BasicShardedCounter &operator++() {
+        add(1);
+        return *this;
+    }
+
+    BasicShardedCounter &operator+=(std::uint64_t delta_) {
+        add(delta_);
+        return *this;
+    }
+
+    /// @brief 各分片之和
+    std::uint64_t load() const {
+        std::uint64_t sum = 0;
+        for (auto const &shard : _shards) sum += shard.value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    operator std::uint64_t() const { return load(); }
+
+    /// @brief 清零, 与并发的 add 同时进行时可能漏掉部分计数
+    void reset() {
+        for (auto &shard : _shards) shard.value.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    CachePadded<std::atomic<std::uint64_t>> _shards[Shards];
+};
+
+using ShardedCounter = BasicShardedCounter<>;
+
+#endif //__SHARDED_COUNTER__
@@ -0,0 +1,289 @@
+#ifndef __SIMD__
+#define __SIMD__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// @brief 迭代器是否指向连续内存 (裸指针或 std::vector 的迭代器), 只有连续内存才能走 SIMD 路径
+template <typename Iterator, typename Value = typename std::iterator_traits<Iterator>::value_type>
+struct is_contiguous_iterator
+    : std::integral_constant<bool, std::is_pointer<Iterator>::value ||
+                                       std::is_same<Iterator, typename std::vector<Value>::iterator>::value ||
+                                       std::is_same<Iterator, typename std::vector<Value>::const_iterator>::value> {
+};
+
+/// @brief 输出迭代器(如 back_inserter)的 value_type 为 void, 只能走标量路径
+template <typename Iterator>
+struct is_contiguous_iterator<Iterator, void> : std::false_type {};
+
+namespace simd {
+
+/// @brief 运算是否为加法, std::plus<T> 与 std::plus<> 都算
+template <typename T, typename Op>
+struct is_plus : std::integral_constant<bool, std::is_same<Op, std::plus<T>>::value ||
+                                                  std::is_same<Op, std::plus<>>::value> {};
+
+/// @brief 运算是否为乘法
+template <typename T, typename Op>
+struct is_multiplies : std::integral_constant<bool, std::is_same<Op, std::multiplies<T>>::value ||
+                                                        std::is_same<Op, std::multiplies<>>::value> {};
+
+/// @brief SSE2 一个寄存器放 4 个 32 位元素, 目前只对这几种类型做向量化
+template <typename T>
+struct is_lane32 : std::integral_constant<bool, std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value ||
+                                                    std::is_same<T, float>::value> {};
+
+/// @brief T 在 Op 下是否有向量化的前缀和
+template <typename T, typename Op>
+struct can_scan : std::integral_constant<bool,
+#if defined(__SSE2__)
+                                         is_lane32<T>::value && is_plus<T, Op>::value
+#else
+                                         false
+#endif
+                                         > {
+};
+
+#if defined(__SSE2__)
+/// @brief 寄存器内 4 路前缀和: [a,b,c,d] -> [a,a+b,a+b+c,a+b+c+d]
+/// 两次错位相加, 无符号整数按位与有符号加法相同
+inline __m128i register_scan(__m128i x_) {
+    x_ = _mm_add_epi32(x_, _mm_slli_si128(x_, 4));
+    return _mm_add_epi32(x_, _mm_slli_si128(x_, 8));
+}
+inline __m128 register_scan(__m128 x_) {
+    x_ = _mm_add_ps(x_, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x_), 4)));
+    return _mm_add_ps(x_, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x_), 8)));
+}
+
+/// @brief 整数与浮点的 SSE2 操作, 让 prefix_sum 只写一份
+struct IntLanes {
+    using Reg = __m128i;
+    static Reg  load(void const *p_) { return _mm_loadu_si128(static_cast<__m128i const *>(p_)); }
+    static void store(void *p_, Reg x_) { _mm_storeu_si128(static_cast<__m128i *>(p_), x_); }
+    static Reg  add(Reg a_, Reg b_) { return _mm_add_epi32(a_, b_); }
+    static Reg  shift_one(Reg x_) { return _mm_slli_si128(x_, 4); }
+    static Reg  broadcast_last(Reg x_) { return _mm_shuffle_epi32(x_, _MM_SHUFFLE(3, 3, 3, 3)); }
+    template <typename T>
+    static Reg splat(T v_) {
+        return _mm_set1_epi32(static_cast<int32_t>(v_));
+    }
+    template <typename T>
+    static T first(Reg x_) {
+        return static_cast<T>(_mm_cvtsi128_si32(x_));
+    }
+};
+struct FloatLanes {
+    using Reg = __m128;
+    static Reg  load(void const *p_) { return _mm_loadu_ps(static_cast<float const *>(p_)); }
+    static void store(void *p_, Reg x_) { _mm_storeu_ps(static_cast<float *>(p_), x_); }
+    static Reg  add(Reg a_, Reg b_) { return _mm_add_ps(a_, b_); }
+    static Reg  shift_one(Reg x_) { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x_), 4)); }
+    static Reg  broadcast_last(Reg x_) { return _mm_shuffle_ps(x_, x_, _MM_SHUFFLE(3, 3, 3, 3)); }
+    template <typename T>
+    static Reg splat(T v_) {
+        return _mm_set1_ps(v_);
+    }
+    template <typename T>
+    static T first(Reg x_) {
+        return _mm_cvtss_f32(x_);
+    }
+};
+
+template <typename T>
+using LanesOf = typename std::conditional<std::is_same<T, float>::value, FloatLanes, IntLanes>::type;
+
+/// @brief 块内前缀和, 每次处理 4 个元素, carry 为前面所有元素之和
+/// inclusive: out[i] = carry + in[0] + ... + in[i]
+/// exclusive: out[i] = carry + in[0] + ... + in[i-1]
+/// in_ 与 out_ 可以是同一块内存 (原地扫描)
+/// @return carry + 全部元素之和
+template <typename T>
+T prefix_sum(T const *in_, T *out_, std::size_t n_, T carry_, bool inclusive_) {
+    using Lanes = LanesOf<T>;
+
+    typename Lanes::Reg carry = Lanes::splat(carry_);
+    std::size_t         i     = 0;
+    for (; i + 4 <= n_; i += 4) {
+        typename Lanes::Reg const local = register_scan(Lanes::load(in_ + i));
+        Lanes::store(out_ + i, Lanes::add(carry, inclusive_ ? local : Lanes::shift_one(local)));
+        carry = Lanes::add(carry, Lanes::broadcast_last(local));
+    }
+    T tail = Lanes::template first<T>(carry);
+    for (; i < n_; ++i) {
+        T const value = tail + in_[i];
+        out_[i]       = inclusive_ ? value : tail;
+        tail          = value;
+    }
+    return tail;
+}
+
+#endif // __SSE2__
+
+/// @brief sum / dot / find 支持的算术类型
+template <typename T>
+struct is_vectorizable
+    : std::integral_constant<bool, std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value ||
+                                       std::is_same<T, int64_t>::value || std::is_same<T, uint64_t>::value ||
+                                       std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_AVX2_DISPATCH 1
+#endif
+
+#if defined(__GNUC__)
+/// @brief 归约内核, Bytes 为向量宽度 (16: SSE, 32: AVX2)
+/// 用 GCC 向量扩展书写, 同一份代码在不同 target 下展开成对应宽度的指令.
+/// 两组累加器交替使用以掩盖加法延迟; 不以向量为参数或返回值, 避免跨 target 的 ABI 差异.
+template <typename T, std::size_t Bytes, bool Dot>
+__attribute__((always_inline)) inline T reduce_kernel(T const *a_, T const *b_, std::size_t n_) {
+    typedef T             Vec __attribute__((vector_size(Bytes)));
+    constexpr std::size_t kLanes = Bytes / sizeof(T);
+
+    Vec         acc0 = {}, acc1 = {};
+    std::size_t i    = 0;
+    for (; i + 2 * kLanes <= n_; i += 2 * kLanes) {
+        Vec x0, x1;
+        std::memcpy(&x0, a_ + i, Bytes);
+        std::memcpy(&x1, a_ + i + kLanes, Bytes);
+        if (Dot) {
+            Vec y0, y1;
+            std::memcpy(&y0, b_ + i, Bytes);
+            std::memcpy(&y1, b_ + i + kLanes, Bytes);
+            x0 *= y0;
+            x1 *= y1;
+        }
+        acc0 += x0;
+        acc1 += x1;
+    }
+    acc0 += acc1;
+
+    T result = T();
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+        result += acc0[lane];
+    }
+    for (; i < n_; ++i) {
+        result += Dot ? a_[i] * b_[i] : a_[i];
+    }
+    return result;
+}
+
+/// @brief 不指定 target, 按编译选项的基线指令集 (x86-64 上为 SSE2) 展开
+template <typename T, bool Dot>
+T reduce_baseline(T const *a_, T const *b_, std::size_t n_) {
+    return reduce_kernel<T, 16, Dot>(a_, b_, n_);
+}
+#endif
+
+#if defined(SIMD_AVX2_DISPATCH)
+template <typename T, bool Dot>
+__attribute__((target("avx2"))) T reduce_avx2(T const *a_, T const *b_, std::size_t n_) {
+    return reduce_kernel<T, 32, Dot>(a_, b_, n_);
+}
+
+/// @brief 运行时检测一次 CPU 是否支持 AVX2
+inline bool has_avx2() {
+    static bool const supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+template <typename T, bool Dot>
+T reduce(T const *a_, T const *b_, std::size_t n_) {
+#if defined(SIMD_AVX2_DISPATCH)
+    if (has_avx2()) return reduce_avx2<T, Dot>(a_, b_, n_);
+#endif
+#if defined(__GNUC__)
+    return reduce_baseline<T, Dot>(a_, b_, n_);
+#else
+    T result = T();
+    for (std::size_t i = 0; i < n_; ++i) {
+        result += Dot ? a_[i] * b_[i] : a_[i];
+    }
+    return result;
+#endif
+}
+
+/// @brief in_[0] + ... + in_[n_-1], 浮点按向量分组求和, 结果与顺序累加可能有舍入差异
+template <typename T>
+T sum(T const *in_, std::size_t n_) {
+    return reduce<T, false>(in_, nullptr, n_);
+}
+
+/// @brief a_[0] * b_[0] + ... + a_[n_-1] * b_[n_-1]
+template <typename T>
+T dot(T const *a_, T const *b_, std::size_t n_) {
+    return reduce<T, true>(a_, b_, n_);
+}
+
+#if defined(__GNUC__)
+/// @brief 查找内核, 每轮比较 4 个向量并把比较结果或在一起, 命中后在这一轮内逐个定位
+template <typename T, std::size_t Bytes>
+__attribute__((always_inline)) inline std::size_t find_kernel(T const *in_, std::size_t n_, T value_) {
+    typedef T             Vec __attribute__((vector_size(Bytes)));
+    constexpr std::size_t kLanes = Bytes / sizeof(T);
+    constexpr std::size_t kBlock = 4 * kLanes;
+
+    Vec const   needle = Vec{} + value_;
+    std::size_t i      = 0;
+    for (; i + kBlock <= n_; i += kBlock) {
+        Vec x0, x1, x2, x3;
+        std::memcpy(&x0, in_ + i, Bytes);
+        std::memcpy(&x1, in_ + i + kLanes, Bytes);
+        std::memcpy(&x2, in_ + i + 2 * kLanes, Bytes);
+        std::memcpy(&x3, in_ + i + 3 * kLanes, Bytes);
+        auto const hit = (x0 == needle) | (x1 == needle) | (x2 == needle) | (x3 == needle);
+        uint64_t   words[Bytes / sizeof(uint64_t)];
+        std::memcpy(words, &hit, Bytes);
+        uint64_t any = 0;
+        for (uint64_t word : words) {
+            any |= word;
+        }
+        if (any) break;
+    }
+    for (; i < n_; ++i) {
+        if (in_[i] == value_) return i;
+    }
+    return n_;
+}
+
+template <typename T>
+std::size_t find_baseline(T const *in_, std::size_t n_, T value_) {
+    return find_kernel<T, 16>(in_, n_, value_);
+}
+#endif
+
+#if defined(SIMD_AVX2_DISPATCH)
+template <typename T>
+__attribute__((target("avx2"))) std::size_t find_avx2(T const *in_, std::size_t n_, T value_) {
+    return find_kernel<T, 32>(in_, n_, value_);
+}
+#endif
+
+/// @brief 第一个等于 value_ 的下标, 没有时返回 n_
+template <typename T>
+std::size_t find(T const *in_, std::size_t n_, T value_) {
+#if defined(SIMD_AVX2_DISPATCH)
+    if (has_avx2()) return find_avx2(in_, n_, value_);
+#endif
+#if defined(__GNUC__)
+    return find_baseline(in_, n_, value_);
+#else
+    for (std::size_t i = 0; i < n_; ++i) {
+        if (in_[i] == value_) return i;
+    }
+    return n_;
+#endif
+}
+
+} // namespace simd
+
+#endif //__SIMD__
@@ -9,7 +9,9 @@
 #define __SIMPLE_THREAD_POOL__
 
 #include "join_thread.hpp"
+#include "task_trace.hpp"
 #include "thread_safe_queue.hpp"
+#include "wait_group.hpp"
 #include <atomic>
 #include <functional>
 
@@ -28,17 +30,47 @@ public:
 
     template <typename FunctionType>
     void submit(FunctionType f) {
-        _workQueue.push(std::function<void()>(f));
+        _workQueue.push(std::function<void()>(_tracer.wrap(f)));
     }
 
+    /// @brief 带完成计数的提交, 任务结束(含异常退出)时调用 group_.done()
+    /// @tparam FunctionType
+    /// @param f
+    /// @param group_ 调用方持有, 需活到 group_.wait() 返回
+    template <typename FunctionType>
+    void submit(FunctionType f, WaitGroup &group_) {
+        struct DoneGuard {
+            WaitGroup &group;
+            ~DoneGuard() { group.done(); }
+        };
+        group_.add();
+        _workQueue.push(std::function<void()>(_tracer.wrap([f, &group_]() mutable {
+            DoneGuard guard{group_};
+            f();
+        })));
+    }
+
+    /// @brief 在调用线程上执行一个排队任务, 供等待方帮忙
+    /// @return 是否执行了任务
+    bool run_pending_task() {
+        std::function<void()> task;
+        if (!_workQueue.try_pop(task)) return false;
+        task();
+        return true;
+    }
+
+    /// @brief 逐任务调度记录, 需定义 POOL_TASK_TRACING
+    trace::TaskTracer &tracer() { return _tracer; }
+
 private:
     SimpleThreadPool()
         : _doneFlag(false)
-        , _joiner(_threads) {
+        , _joiner(_threads)
+        , _tracer(std::thread::hardware_concurrency()) {
         unsigned const threadCount = std::thread::hardware_concurrency();
         try {
             for (size_t i = 0; i < threadCount; ++i) {
-                _threads.push_back(std::thread(&SimpleThreadPool::worker_thread, this));
+                _threads.push_back(std::thread(&SimpleThreadPool::worker_thread, this, i));
             }
         } catch (...) {
             _doneFlag = true;
@@ -46,7 +78,8 @@ private:
         }
     }
 
-    void worker_thread() {
+    void worker_thread(size_t index_) {
+        _tracer.bind_worker(index_);
         while (!_doneFlag) {
             std::function<void()> task;
             if (_workQueue.try_pop(task)) {
@@ -62,6 +95,7 @@ private:
     ThreadSafeQueue<std::function<void()>> _workQueue;
     std::vector<std::thread>               _threads;
     JoinThread                             _joiner;
+    trace::TaskTracer                      _tracer;
 };
 
 #endif //__SIMPLE__THREAD_POOL__
\ No newline at end of file
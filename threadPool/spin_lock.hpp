@@ -0,0 +1,257 @@
+#ifndef __SPIN_LOCK__
+#define __SPIN_LOCK__
+
+#include "cache_padded.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// 自旋锁: 均满足 BasicLockable (lock / unlock), 另提供 try_lock, 可直接用于 std::lock_guard / std::unique_lock.
+///     TTASLock         先读后写 + 指数退避, 无竞争时最快, 不保证公平
+///     TicketLock       排号, 先到先得; 等待者都读同一个计数, 线程多时释放会让所有等待者的缓存行失效
+///     MCSLock          排队锁, 每个等待者只在自己的结点上自旋, 释放只唤醒后继, 线程多时缓存行不会来回搬
+///     SpinThenParkLock 先自旋一段, 拿不到再睡眠, 临界区长短不定或线程数超过核数时使用
+/// 前三种的等待循环在退避到上限后改为让出 CPU, 线程数超过核数时不会空转一整个时间片;
+/// 但 TicketLock / MCSLock 按顺序交接, 可能交给一个没在运行的等待者, 线程数超过核数时尾延迟明显变差.
+
+/// @brief 告诉 CPU 正在自旋: x86 上是 pause, 降低功耗并减少退出循环时的流水线清空
+inline void cpu_relax() {
+#if defined(__SSE2__)
+    _mm_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+    __asm__ __volatile__("yield");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/// @brief 指数退避: 每次 pause 的次数翻倍, 到达上限后改为 yield
+class Backoff {
+public:
+    static constexpr unsigned kMaxSpins = 64;
+
+    Backoff()
+        : _spins(1) {}
+
+    void pause() {
+        if (_spins <= kMaxSpins) {
+            for (unsigned i = 0; i < _spins; ++i) cpu_relax();
+            _spins <<= 1;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    unsigned _spins;
+};
+
+/// @brief test-and-test-and-set: 锁被占用时只读不写, 看到释放才去抢, 抢失败再退避
+class TTASLock {
+public:
+    TTASLock()
+        : _locked(false) {}
+    TTASLock(const TTASLock &)            = delete;
+    TTASLock &operator=(const TTASLock &) = delete;
+
+    void lock() {
+        Backoff backoff;
+        while (_locked.exchange(true, std::memory_order_acquire)) {
+            do {
+                backoff.pause();
+            } while (_locked.load(std::memory_order_relaxed));
+        }
+    }
+
+    bool try_lock() {
+        return !_locked.load(std::memory_order_relaxed) && !_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() { _locked.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> _locked;
+};
+
+/// @brief 排号锁: 取号 fetch_add, 叫号到自己才进入, 严格先来先服务
+/// 取号与叫号分放两个缓存行, 新来的线程取号不会打扰正在读叫号的等待者
+class TicketLock {
+public:
+    TicketLock() {
+        _next.value.store(0, std::memory_order_relaxed);
+        _serving.value.store(0, std::memory_order_relaxed);
+    }
+    TicketLock(const TicketLock &)            = delete;
+    TicketLock &operator=(const TicketLock &) = delete;
+
+    void lock() {
+        std::uint32_t const ticket = _next.value.fetch_add(1, std::memory_order_relaxed);
+        Backoff             backoff;
+        // 排在下一个的等待者也要退避到 yield: 持有者被抢占时, 紧盯只会占住它需要的 CPU
+        while (_serving.value.load(std::memory_order_acquire) != ticket) backoff.pause();
+    }
+
+    bool try_lock() {
+        std::uint32_t serving = _serving.value.load(std::memory_order_relaxed);
+        std::uint32_t ticket  = serving;
+        return _next.value.compare_exchange_strong(ticket, serving + 1, std::memory_order_acquire,
+                                                   std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        // 只有持有者写 _serving
+        _serving.value.store(_serving.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    CachePadded<std::atomic<std::uint32_t>> _next;
+    CachePadded<std::atomic<std::uint32_t>> _serving;
+};
+
+/// @brief MCS 排队锁: 尾指针串起等待者, 每人在自己的结点上等前驱交接
+/// 结点取自线程本地的空闲链表, 一个线程可同时持有多把 MCSLock, 释放顺序不限
+class MCSLock {
+    struct Node {
+        std::atomic<Node *> next;
+        std::atomic<bool>   locked;
+        Node               *free; // 线程本地空闲链表
+        char                pad[kCacheLineSize]; // 不同线程的结点不共享缓存行
+    };
+
+    /// @brief 线程退出时释放空闲结点; 仍被持有的锁所用的结点不在链表中
+    struct NodeCache {
+        Node *head = nullptr;
+
+        ~NodeCache() {
+            while (head) {
+                Node *const node = head;
+                head             = node->free;
+                delete node;
+            }
+        }
+    };
+
+public:
+    MCSLock()
+        : _tail(nullptr)
+        , _holder(nullptr) {}
+    MCSLock(const MCSLock &)            = delete;
+    MCSLock &operator=(const MCSLock &) = delete;
+
+    void lock() {
+        Node *const node = acquire_node();
+        Node *const pred = _tail.exchange(node, std::memory_order_acq_rel);
+        if (pred) {
+            pred->next.store(node, std::memory_order_release);
+            Backoff backoff;
+            while (node->locked.load(std::memory_order_acquire)) backoff.pause();
+        }
+        _holder = node;
+    }
+
+    bool try_lock() {
+        Node *const node     = acquire_node();
+        Node       *expected = nullptr;
+        if (_tail.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed)) {
+            _holder = node;
+            return true;
+        }
+        release_node(node);
+        return false;
+    }
+
+    void unlock() {
+        Node *const node = _holder;
+        Node       *succ = node->next.load(std::memory_order_acquire);
+        if (!succ) {
+            Node *expected = node;
+            if (_tail.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+                release_node(node);
+                return;
+            }
+            // 后继已换上尾指针, 还没来得及挂到 next 上
+            Backoff backoff;
+            while (!(succ = node->next.load(std::memory_order_acquire))) backoff.pause();
+        }
+        succ->locked.store(false, std::memory_order_release);
+        release_node(node);
+    }
+
+private:
+    static NodeCache &node_cache() {
+        thread_local NodeCache cache;
+        return cache;
+    }
+
+    static Node *acquire_node() {
+        NodeCache &cache = node_cache();
+        Node      *node  = cache.head;
+        if (node) {
+            cache.head = node->free;
+        } else {
+            node = new Node;
+        }
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+        return node;
+    }
+
+    /// @brief 交接之后再没有别的线程访问该结点, 可放回本线程的空闲链表
+    static void release_node(Node *node_) {
+        NodeCache &cache = node_cache();
+        node_->free      = cache.head;
+        cache.head       = node_;
+    }
+
+    std::atomic<Node *> _tail;
+    Node               *_holder; // 只由持有者读写
+};
+
+/// @brief 先自旋后睡眠: 自旋 spins_ 次 (每次一个 pause) 仍拿不到就在条件变量上睡眠
+/// 状态 0 空闲, 1 持有, 2 持有且可能有人睡眠; 只有 2 时 unlock 才去唤醒, 无竞争时不碰互斥量
+class SpinThenParkLock {
+public:
+    explicit SpinThenParkLock(unsigned spins_ = 100)
+        : _state(0)
+        , _spins(spins_) {}
+    SpinThenParkLock(const SpinThenParkLock &)            = delete;
+    SpinThenParkLock &operator=(const SpinThenParkLock &) = delete;
+
+    void lock() {
+        for (unsigned i = 0; i < _spins; ++i) {
+            if (try_lock()) return;
+            cpu_relax();
+        }
+        if (_state.exchange(2, std::memory_order_acquire) == 0) return;
+        std::unique_lock<std::mutex> lock(_mtx);
+        // 持 _mtx 把状态置 2 再睡, unlock 看到 2 后要拿 _mtx 才能通知, 不会漏掉
+        while (_state.exchange(2, std::memory_order_acquire) != 0) _condv.wait(lock);
+    }
+
+    bool try_lock() {
+        std::uint32_t expected = 0;
+        return _state.load(std::memory_order_relaxed) == 0 &&
+               _state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (_state.exchange(0, std::memory_order_release) == 2) {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _condv.notify_one();
+        }
+    }
+
+private:
+    std::atomic<std::uint32_t> _state;
+    unsigned const             _spins;
+    std::mutex                 _mtx;
+    std::condition_variable    _condv;
+};
+
+#endif //__SPIN_LOCK__
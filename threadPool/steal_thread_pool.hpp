@@ -9,6 +9,7 @@
 #define __STEAL_THREAD_POOL_
 #include "future_thread_pool.hpp"
 #include "join_thread.hpp"
+#include "task_trace.hpp"
 #include "thread_safe_queue.hpp"
 #include <cstddef>
 #include <future>
@@ -17,6 +18,9 @@ class StealThreadPool {
 
 private:
     void work_thread(int index_) {
+        local_pool()  = this;
+        local_index() = index_;
+        _tracer.bind_worker(index_);
         while (!_doneFlag) {
             FunctionWrapper wrapper;
             bool            popRes = _threadWorkQueues[index_].try_pop(wrapper);
@@ -30,7 +34,7 @@ private:
 
                 stealRes = _threadWorkQueues[i].try_steal(wrapper);
                 if (stealRes) {
-                    wrapper();
+                    run_task(wrapper, true);
                     break;
                 }
             }
@@ -58,17 +62,54 @@ public:
         int index = (_atmIndex.load() + 1) % _threadWorkQueues.size();
         _atmIndex.store(index);
         using returnType = decltype(f());
-        std::packaged_task<returnType()> task(std::move(f));
+        std::packaged_task<returnType()> task(_tracer.wrap(std::move(f)));
         std::future<returnType>          res(task.get_future());
         _threadWorkQueues[index].push(std::move(task));
         return res;
     }
 
+    /// @brief 投递不需要返回值的任务, 省去packaged_task和future
+    /// 池内线程投递到自己的队列 (协程恢复、嵌套分治都留在本线程, 空闲线程再来窃取), 外部线程轮流投递
+    /// @tparam FunctionType
+    /// @param f
+    template <typename FunctionType>
+    void post(FunctionType f) {
+        if (local_pool() == this) {
+            _threadWorkQueues[local_index()].push(FunctionWrapper(_tracer.wrap(std::move(f))));
+            return;
+        }
+        int index = (_atmIndex.load() + 1) % _threadWorkQueues.size();
+        _atmIndex.store(index);
+        _threadWorkQueues[index].push(FunctionWrapper(_tracer.wrap(std::move(f))));
+    }
+
+    /// @brief 在调用线程上执行一个排队任务, 供等待结果的线程帮忙
+    /// @return 是否执行了任务
+    bool run_pending_task() {
+        FunctionWrapper wrapper;
+        size_t const    start = local_pool() == this ? local_index() : _atmIndex.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < _threadWorkQueues.size(); ++i) {
+            size_t const index = (start + i) % _threadWorkQueues.size();
+            if (_threadWorkQueues[index].try_pop(wrapper)) {
+                // 池内线程从别的线程的队列取到的任务也算窃取
+                run_task(wrapper, local_pool() == this && index != local_index());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t thread_count() const { return _threads.size(); }
+
+    /// @brief 逐任务调度记录, 需定义 POOL_TASK_TRACING
+    trace::TaskTracer &tracer() { return _tracer; }
+
 private:
     StealThreadPool()
         : _doneFlag(false)
         , _joiner(_threads)
-        , _atmIndex(0) {
+        , _atmIndex(0)
+        , _tracer(std::thread::hardware_concurrency()) {
 
         unsigned const threadCount = std::thread::hardware_concurrency();
         try {
@@ -86,11 +127,31 @@ private:
         }
     }
 
+    /// @brief 当前线程所属的池及其队列下标, 非池线程为 nullptr
+    static StealThreadPool *&local_pool() {
+        static thread_local StealThreadPool *pool = nullptr;
+        return pool;
+    }
+    static size_t &local_index() {
+        static thread_local size_t index = 0;
+        return index;
+    }
+
+    static void run_task(FunctionWrapper &wrapper_, bool stolen_) {
+        if (!stolen_) {
+            wrapper_();
+            return;
+        }
+        trace::StolenScope scope;
+        wrapper_();
+    }
+
 private:
     std::atomic_bool                              _doneFlag;
     std::vector<ThreadSafeQueue<FunctionWrapper>> _threadWorkQueues;
     std::vector<std::thread>                      _threads;
     JoinThread                                    _joiner;
     std::atomic<int>                              _atmIndex;
+    trace::TaskTracer                             _tracer;
 };
 #endif
\ No newline at end of file
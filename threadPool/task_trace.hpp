@@ -0,0 +1,362 @@
+#ifndef __TASK_TRACE__
+#define __TASK_TRACE__
+
+#include "cache_padded.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// 线程池的逐任务调度记录.
+/// 定义 POOL_TASK_TRACING (CMake: -DCONCURRENCY_POOL_TRACE=ON) 后, threadPool/ 下各线程池在提交时给任务记下时间,
+/// 执行时记下开始/结束时间、执行线程以及是否窃取而来, 写入每个工作线程一个的环形缓冲区 (写满后覆盖最旧的记录);
+/// write_chrome_trace() 把记录导出为 Chrome trace_event JSON, 可在 chrome://tracing 或 Perfetto 中按时间线查看.
+/// 未定义时 wrap() 原样返回任务, 其余钩子为空, 不分配缓冲区, 各池的行为与开销不变.
+namespace trace {
+
+inline std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/// @brief 一个任务的调度记录, 时间为 steady_clock 纳秒
+struct TaskRecord {
+    std::uint64_t submitNs = 0;
+    std::uint64_t startNs  = 0;
+    std::uint64_t endNs    = 0;
+    std::uint32_t worker   = 0; // 执行线程在池内的序号, 池外线程 (等待方帮忙执行) 为 TaskTracer::kExternalWorker
+    bool          stolen   = false;
+
+    std::uint64_t wait_ns() const { return startNs - submitNs; }
+    std::uint64_t run_ns() const { return endNs - startNs; }
+};
+
+class TaskTracer;
+
+namespace detail {
+
+/// @brief 当前线程在哪个池里当第几号工作线程, 以及正在执行的任务是否窃取而来
+struct WorkerContext {
+    TaskTracer const *tracer = nullptr;
+    std::uint32_t     worker = 0;
+    bool              stolen = false;
+};
+
+inline WorkerContext &worker_context() {
+    static thread_local WorkerContext context;
+    return context;
+}
+
+/// @brief 定长环形缓冲区, 每个槽位一把序列锁: 写入方把序号从偶数 CAS 成奇数才写字段, 读取方前后两次序号一致才采用
+/// 槽位由 fetch_add 领取, 多个线程写同一个缓冲区也安全. 绕满一圈时, 槽位上另一写入方尚未写完,
+/// 或已被更新的记录占用, 这条记录直接丢弃, 两个写入方不会交错写同一槽位
+class Ring {
+public:
+    explicit Ring(std::size_t capacity_)
+        : _mask(round_up_pow2(capacity_) - 1)
+        , _slots(new Slot[_mask + 1]) {
+        _next.value.store(0, std::memory_order_relaxed);
+    }
+
+    void push(TaskRecord const &record_) {
+        std::uint64_t const ticket = _next.value.fetch_add(1, std::memory_order_relaxed);
+        Slot               &slot   = _slots[ticket & _mask];
+        std::uint64_t       seq    = slot.seq.load(std::memory_order_relaxed);
+        do {
+            if ((seq & 1) || seq > 2 * ticket) return;
+        } while (!slot.seq.compare_exchange_weak(seq, 2 * ticket + 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.submitNs.store(record_.submitNs, std::memory_order_relaxed);
+        slot.startNs.store(record_.startNs, std::memory_order_relaxed);
+        slot.endNs.store(record_.endNs, std::memory_order_relaxed);
+        slot.info.store((std::uint64_t(record_.worker) << 1) | (record_.stolen ? 1u : 0u), std::memory_order_relaxed);
+        slot.seq.store(2 * ticket + 2, std::memory_order_release);
+    }
+
+    void collect(std::vector<TaskRecord> &out_) const {
+        for (std::size_t i = 0; i <= _mask; ++i) {
+            Slot const         &slot = _slots[i];
+            std::uint64_t const seq  = slot.seq.load(std::memory_order_acquire);
+            if (seq == 0 || (seq & 1)) continue;
+            TaskRecord record;
+            record.submitNs          = slot.submitNs.load(std::memory_order_relaxed);
+            record.startNs           = slot.startNs.load(std::memory_order_relaxed);
+            record.endNs             = slot.endNs.load(std::memory_order_relaxed);
+            std::uint64_t const info = slot.info.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue; // 读的过程中被改写
+            record.worker = static_cast<std::uint32_t>(info >> 1);
+            record.stolen = (info & 1) != 0;
+            out_.push_back(record);
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> seq{0};
+        std::atomic<std::uint64_t> submitNs{0};
+        std::atomic<std::uint64_t> startNs{0};
+        std::atomic<std::uint64_t> endNs{0};
+        std::atomic<std::uint64_t> info{0};
+    };
+
+    static std::size_t round_up_pow2(std::size_t n_) {
+        std::size_t size = 1;
+        while (size < n_) size <<= 1;
+        return size;
+    }
+
+    std::size_t const                       _mask;
+    std::unique_ptr<Slot[]>                 _slots;
+    CachePadded<std::atomic<std::uint64_t>> _next;
+};
+
+} // namespace detail
+
+#ifdef POOL_TASK_TRACING
+template <typename F>
+class TracedTask;
+#endif
+
+/// @brief 每个线程池持有一个: 工作线程启动时 bind_worker(序号), 提交时 wrap(任务)
+class TaskTracer {
+public:
+    static constexpr std::size_t   kDefaultCapacity = 4096; // 每个工作线程保留的最近记录数
+    static constexpr std::uint32_t kExternalWorker  = 0xffffffffu;
+
+    /// @param workers_  工作线程数, 另有一个缓冲区给池外帮忙执行任务的线程
+    /// @param capacity_ 每个缓冲区的记录数, 向上取 2 的幂
+    explicit TaskTracer(std::size_t workers_, std::size_t capacity_ = kDefaultCapacity)
+        : _workers(workers_) {
+#ifdef POOL_TASK_TRACING
+        _clearedNs.store(0, std::memory_order_relaxed);
+        for (std::size_t i = 0; i <= workers_; ++i) _rings.emplace_back(new detail::Ring(capacity_));
+#else
+        (void)capacity_;
+#endif
+    }
+    TaskTracer(const TaskTracer &)            = delete;
+    TaskTracer &operator=(const TaskTracer &) = delete;
+
+    static constexpr bool enabled() {
+#ifdef POOL_TASK_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::size_t workers() const { return _workers; }
+
+    /// @brief 由工作线程在开始取任务前调用
+    void bind_worker(std::size_t index_) const {
+#ifdef POOL_TASK_TRACING
+        detail::WorkerContext &context = detail::worker_context();
+        context.tracer                 = this;
+        context.worker                 = static_cast<std::uint32_t>(index_);
+#else
+        (void)index_;
+#endif
+    }
+
+    /// @brief 提交时包装任务: 记下提交时间, 执行时记录整个调度过程; 未开启时原样返回
+#ifdef POOL_TASK_TRACING
+    template <typename F>
+    TracedTask<F> wrap(F f_) {
+        return TracedTask<F>(this, std::move(f_));
+    }
+#else
+    template <typename F>
+    F wrap(F f_) {
+        return f_;
+    }
+#endif
+
+    /// @brief 各缓冲区中仍保留的记录 (跳过 clear() 之前提交的), 按开始时间排序; 可与任务执行并发调用
+    std::vector<TaskRecord> records() const {
+        std::vector<TaskRecord> records;
+#ifdef POOL_TASK_TRACING
+        for (auto const &ring : _rings) ring->collect(records);
+        std::uint64_t const cleared = _clearedNs.load(std::memory_order_relaxed);
+        records.erase(std::remove_if(records.begin(), records.end(),
+                                     [cleared](TaskRecord const &r_) { return r_.submitNs < cleared; }),
+                      records.end());
+        std::sort(records.begin(), records.end(),
+                  [](TaskRecord const &a_, TaskRecord const &b_) { return a_.startNs < b_.startNs; });
+#endif
+        return records;
+    }
+
+    /// @brief 丢弃此刻之前提交的任务的记录, 用于只看某一段时间
+    void clear() {
+#ifdef POOL_TASK_TRACING
+        _clearedNs.store(now_ns(), std::memory_order_relaxed);
+#endif
+    }
+
+private:
+#ifdef POOL_TASK_TRACING
+    template <typename F>
+    friend class TracedTask;
+
+    void push(TaskRecord const &record_) {
+        std::size_t const ring = record_.worker < _workers ? record_.worker : _workers;
+        _rings[ring]->push(record_);
+    }
+
+    std::vector<std::unique_ptr<detail::Ring>> _rings;
+    std::atomic<std::uint64_t>                 _clearedNs;
+#endif
+    std::size_t const _workers;
+};
+
+/// @brief 窃取来的任务在该作用域内执行, 由窃取方在调用任务前构造
+class StolenScope {
+public:
+#ifdef POOL_TASK_TRACING
+    StolenScope()
+        : _previous(detail::worker_context().stolen) {
+        detail::worker_context().stolen = true;
+    }
+    ~StolenScope() { detail::worker_context().stolen = _previous; }
+
+private:
+    bool _previous;
+#else
+    StolenScope() {}
+#endif
+    StolenScope(const StolenScope &)            = delete;
+    StolenScope &operator=(const StolenScope &) = delete;
+};
+
+#ifdef POOL_TASK_TRACING
+/// @brief wrap() 的结果: 执行时根据当前线程的上下文判断是哪个工作线程、是否窃取, 结束 (含异常退出) 时写一条记录
+/// 任务内部再执行的嵌套任务各自判断, 不继承外层的窃取标记
+template <typename F>
+class TracedTask {
+public:
+    TracedTask(TaskTracer *tracer_, F f_)
+        : _tracer(tracer_)
+        , _submitNs(now_ns())
+        , _f(std::move(f_)) {}
+
+    auto operator()() -> decltype(std::declval<F &>()()) {
+        Scope scope(*_tracer, _submitNs);
+        return _f();
+    }
+
+private:
+    class Scope {
+    public:
+        Scope(TaskTracer &tracer_, std::uint64_t submitNs_)
+            : _tracer(tracer_) {
+            detail::WorkerContext &context = detail::worker_context();
+            bool const             own     = context.tracer == &tracer_;
+            _record.submitNs               = submitNs_;
+            _record.worker                 = own ? context.worker : TaskTracer::kExternalWorker;
+            _record.stolen                 = own && context.stolen;
+            _outerStolen                   = context.stolen;
+            context.stolen                 = false;
+            _record.startNs                = now_ns();
+        }
+        ~Scope() {
+            _record.endNs                   = now_ns();
+            detail::worker_context().stolen = _outerStolen;
+            _tracer.push(_record);
+        }
+
+    private:
+        TaskTracer &_tracer;
+        TaskRecord  _record;
+        bool        _outerStolen;
+    };
+
+    TaskTracer   *_tracer;
+    std::uint64_t _submitNs;
+    F             _f;
+};
+#endif
+
+/// @brief 导出时一个池对应一个进程 (pid), 工作线程对应线程 (tid)
+struct NamedTracer {
+    std::string       name;
+    TaskTracer const *tracer;
+};
+
+namespace detail {
+
+inline void write_json_string(std::ostream &out_, std::string const &text_) {
+    out_ << '"';
+    for (char c : text_) {
+        if (c == '"' || c == '\\') out_ << '\\';
+        out_ << c;
+    }
+    out_ << '"';
+}
+
+/// @brief trace_event 的时间单位是微秒, 保留到纳秒
+inline void write_us(std::ostream &out_, std::uint64_t ns_) {
+    std::uint64_t const fraction = ns_ % 1000;
+    out_ << ns_ / 1000 << '.' << fraction / 100 << fraction / 10 % 10 << fraction % 10;
+}
+
+} // namespace detail
+
+/// @brief 写出 Chrome trace_event JSON: 每个任务一个 "X" 事件 (执行区间, 参数带排队时长与是否窃取),
+/// 排队区间用异步事件 ("b"/"e") 画在同一线程上, 便于看出调度空档
+inline void write_chrome_trace(std::ostream &out_, std::vector<NamedTracer> const &pools_) {
+    out_ << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool          first = true;
+    std::uint64_t id    = 0;
+    auto          next  = [&]() -> std::ostream & {
+        out_ << (first ? "\n" : ",\n");
+        first = false;
+        return out_;
+    };
+    for (std::size_t pid = 0; pid < pools_.size(); ++pid) {
+        TaskTracer const &tracer = *pools_[pid].tracer;
+        next() << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":";
+        detail::write_json_string(out_, pools_[pid].name);
+        out_ << "}}";
+        for (std::size_t worker = 0; worker <= tracer.workers(); ++worker) {
+            next() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << worker
+                   << ",\"args\":{\"name\":\""
+                   << (worker < tracer.workers() ? "worker " + std::to_string(worker) : std::string("external"))
+                   << "\"}}";
+        }
+        for (TaskRecord const &r : tracer.records()) {
+            std::size_t const tid = r.worker < tracer.workers() ? r.worker : tracer.workers();
+            next() << "{\"name\":\"task\",\"cat\":\"run\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid
+                   << ",\"ts\":";
+            detail::write_us(out_, r.startNs);
+            out_ << ",\"dur\":";
+            detail::write_us(out_, r.run_ns());
+            out_ << ",\"args\":{\"wait_us\":";
+            detail::write_us(out_, r.wait_ns());
+            out_ << ",\"stolen\":" << (r.stolen ? "true" : "false") << "}}";
+
+            ++id;
+            next() << "{\"name\":\"queued\",\"cat\":\"queue\",\"ph\":\"b\",\"id\":" << id << ",\"pid\":" << pid
+                   << ",\"tid\":" << tid << ",\"ts\":";
+            detail::write_us(out_, r.submitNs);
+            out_ << "}";
+            next() << "{\"name\":\"queued\",\"cat\":\"queue\",\"ph\":\"e\",\"id\":" << id << ",\"pid\":" << pid
+                   << ",\"tid\":" << tid << ",\"ts\":";
+            detail::write_us(out_, r.startNs);
+            out_ << "}";
+        }
+    }
+    out_ << "\n]}\n";
+}
+
+} // namespace trace
+
+#endif //__TASK_TRACE__
@@ -8,6 +8,7 @@
 
 #ifndef __THREAD_POOL__
 #define __THREAD_POOL__
+#include "task_trace.hpp"
 #include <future>
 #include <iostream>
 #include <mutex>
@@ -48,16 +49,20 @@ public:
         std::future<returnType> ret = task->get_future();
         {
             std::lock_guard<std::mutex> lockGuard(_mtx);
-            _tasks.emplace([task] { (*task)(); });
+            _tasks.emplace(_tracer.wrap([task] { (*task)(); }));
         }
         _condv.notify_one();
         return ret;
     }
     int idel_thrad_count() { return _threadNum; }
 
+    /// @brief 逐任务调度记录, 需定义 POOL_TASK_TRACING
+    trace::TaskTracer &tracer() { return _tracer; }
+
 private:
     ThreadPool(unsigned int num_ = std::thread::hardware_concurrency())
-        : _stopFlag(false) {
+        : _stopFlag(false)
+        , _tracer(num_ <= 1 ? 2 : num_) {
         {
             if (num_ <= 1)
                 _threadNum = 2;
@@ -69,7 +74,8 @@ private:
 
     void start() {
         for (size_t i = 0; i < _threadNum; ++i) {
-            _pools.emplace_back([this]() {
+            _pools.emplace_back([this, i]() {
+                _tracer.bind_worker(i);
                 while (!this->_stopFlag.load()) {
                     Task task;
                     {
@@ -105,6 +111,7 @@ private:
     std::atomic_int          _threadNum;
     std::queue<Task>         _tasks;
     std::vector<std::thread> _pools;
+    trace::TaskTracer        _tracer;
 };
 
 #endif //__THREAD_POOL__
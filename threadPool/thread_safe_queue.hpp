@@ -1,15 +1,27 @@
 #ifndef __THREAD_SAFE_QUEUE__
 #define __THREAD_SAFE_QUEUE__
+#include "profiled_mutex.hpp"
+#include "queue_latency.hpp"
 #include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <type_traits>
+#include <vector>
 
-template <typename T>
+/// @brief 头尾两把锁的队列
+/// @tparam T
+/// @tparam Mutex 互斥量类型, 换成 ProfiledMutex<> 可统计锁竞争
+template <typename T, typename Mutex = std::mutex>
 class ThreadSafeQueue {
 public:
     ThreadSafeQueue()
         : _unipHead(new node)
-        , _nodeTail(_unipHead.get()) {}
+        , _nodeTail(_unipHead.get())
+        , _stopFlag(false) {
+        name_lock(_mtxHead, "ThreadSafeQueue::head");
+        name_lock(_mtxTail, "ThreadSafeQueue::tail");
+    }
     ~ThreadSafeQueue() {}
     ThreadSafeQueue(const ThreadSafeQueue &)            = delete;
     ThreadSafeQueue &operator=(const ThreadSafeQueue &) = delete;
@@ -20,11 +32,12 @@ public:
     }
 
     bool wait_and_pop_timeout(T &value_) {
-        std::unique_lock<std::mutex> headLock(_mtxHead);
-        auto                         res = _condvData.wait_for(headLock, std::chrono::milliseconds(100),
-                                                               [&]() { return _unipHead.get() != get_tail() || _stopFlag.load() == true; });
+        std::unique_lock<Mutex> headLock(_mtxHead);
+        auto                    res = _condvData.wait_for(headLock, std::chrono::milliseconds(100),
+                                                          [&]() { return _unipHead.get() != get_tail() || _stopFlag.load() == true; });
         if (!res) return false;
         if (_stopFlag.load()) return false;
+        record_latency(*_unipHead);
         value_    = std::move(*_unipHead->_data);
         _unipHead = std::move(_unipHead->_next);
         return true;
@@ -37,14 +50,14 @@ public:
     }
 
     bool wait_and_pop(T &value_) {
-        std::unique_ptr<node> const oldHead = wait_and_pop(value_);
+        std::unique_ptr<node> const oldHead = wait_pop_head(value_);
         if (oldHead == nullptr) return false;
         return true;
     }
 
     std::shared_ptr<T> try_pop() {
         std::unique_ptr<node> oldHead = try_pop_head();
-        return oldHead ? oldHead->data : std::shared_ptr<T>();
+        return oldHead ? oldHead->_data : std::shared_ptr<T>();
     }
 
     bool try_pop(T &value_) {
@@ -54,18 +67,53 @@ public:
     }
 
     bool empty() {
-        std::lock_guard<std::mutex> headLock(_mtxHead);
+        std::lock_guard<Mutex> headLock(_mtxHead);
         return (_unipHead.get() == get_tail());
     }
 
+    /// @brief 一次加锁从头部切下至多 max_ 个元素, 解锁后依次移动写入 out_; 队列为空时不等待
+    /// @param out_ 输出迭代器
+    /// @param max_
+    /// @return 取出的个数
+    template <typename OutputIt>
+    std::size_t pop_n(OutputIt out_, std::size_t max_) {
+        std::size_t           count = 0;
+        std::unique_ptr<node> chain = pop_head_n(max_, count);
+        for (std::size_t i = 0; i < count; ++i, ++out_) {
+            record_latency(*chain);
+            *out_ = std::move(*chain->_data);
+            chain = std::move(chain->_next); // 逐个释放, 长链不会递归析构
+        }
+        return count;
+    }
+
+    /// @brief 一次加锁取走当前所有元素
+    /// @return std::vector<T>, 队列为空时为空
+    std::vector<T> pop_all() {
+        std::vector<T>        values;
+        std::unique_ptr<node> chain = pop_head_all();
+        while (chain) {
+            record_latency(*chain);
+            values.push_back(std::move(*chain->_data));
+            chain = std::move(chain->_next);
+        }
+        return values;
+    }
+
     /// @brief push node
     /// @param newValue_
     void push(T newValue_) {
         std::shared_ptr<T>    newData(std::make_shared<T>(std::move(newValue_)));
         std::unique_ptr<node> newNode(new node);
+#ifdef QUEUE_LATENCY_TRACKING
+        std::uint64_t const stamp = latency::now_ns();
+#endif
         {
-            std::lock_guard<std::mutex> tailLock(_mtxTail);
+            std::lock_guard<Mutex> tailLock(_mtxTail);
             _nodeTail->_data    = newData;
+#ifdef QUEUE_LATENCY_TRACKING
+            _nodeTail->_enqueueNs = stamp;
+#endif
             node *const newTail = newNode.get();
             newTail->_prev      = _nodeTail;
             _nodeTail->_next    = std::move(newNode);
@@ -78,44 +126,96 @@ public:
     /// @param value_
     /// @return
     bool try_steal(T &value_) {
-        std::unique_lock<std::mutex> tailLock(_mtxTail, std::defer_lock);
-        std::unique_lock<std::mutex> headLock(_mtxHead, std::defer_lock);
+        std::unique_lock<Mutex> tailLock(_mtxTail, std::defer_lock);
+        std::unique_lock<Mutex> headLock(_mtxHead, std::defer_lock);
         std::lock(tailLock, headLock);
-        if (_unipHead.get() == get_tail()) {
+        if (_unipHead.get() == _nodeTail) { // 已持有尾锁, 不能再调用get_tail()
             return false;
         }
         node *prevNode   = _nodeTail->_prev;
+        record_latency(*prevNode);
         value_           = std::move(*(prevNode->_data));
         _nodeTail        = prevNode;
         _nodeTail->_next = nullptr;
         return true;
     }
 
+#ifdef QUEUE_LATENCY_TRACKING
+    /// @brief 元素从 push 到被取出的等待时间分布 (纳秒)
+    latency::Snapshot latency_snapshot() const { return _latency.snapshot(); }
+    void              reset_latency() { _latency.reset(); }
+#endif
+
 private:
     struct node {
         std::shared_ptr<T>    _data;
         std::unique_ptr<node> _next;
         node                 *_prev;
+#ifdef QUEUE_LATENCY_TRACKING
+        std::uint64_t _enqueueNs;
+#endif
     };
 
+    /// @brief 记录结点的等待时间, 未开启统计时为空函数
+    void record_latency(node const &node_) {
+#ifdef QUEUE_LATENCY_TRACKING
+        _latency.record_since(node_._enqueueNs);
+#else
+        (void)node_;
+#endif
+    }
+
     /// @brief  get tail ptr
     /// @return node *_nodeTail;
     node *get_tail() {
-        std::lock_guard<std::mutex> lock(_mtxTail);
+        std::lock_guard<Mutex> lock(_mtxTail);
         return _nodeTail;
     }
 
     /// @brief pop head unip
     /// @return  std::unique_ptr<node> oldHead
     std::unique_ptr<node> pop_head() {
+        record_latency(*_unipHead);
         std::unique_ptr<node> oldHead = std::move(_unipHead);
         _unipHead                     = std::move(oldHead->_next);
         return oldHead;
     }
+    /// @brief 持头锁, 只取一次尾指针, 从头部切下至多 max_ 个结点
+    /// 尾指针之前的结点 push 不会再改, 遍历无需尾锁
+    /// @return 切下的链, count_ 为结点数
+    std::unique_ptr<node> pop_head_n(std::size_t max_, std::size_t &count_) {
+        std::lock_guard<Mutex> headLock(_mtxHead);
+        node *const            tail = get_tail();
+        node                  *last = nullptr;
+        count_                      = 0;
+        for (node *p = _unipHead.get(); p != tail && count_ < max_; p = p->_next.get()) {
+            last = p;
+            ++count_;
+        }
+        if (!last) return std::unique_ptr<node>();
+        std::unique_ptr<node> chain = std::move(_unipHead);
+        _unipHead                   = std::move(last->_next);
+        _unipHead->_prev            = nullptr;
+        return chain;
+    }
+
+    /// @brief 持头锁, 借尾结点的 _prev 直接在尾部之前断开, O(1) 切下全部结点
+    /// @return 切下的链, 末结点 _next 为空
+    std::unique_ptr<node> pop_head_all() {
+        std::lock_guard<Mutex> headLock(_mtxHead);
+        node *const            tail = get_tail();
+        if (_unipHead.get() == tail) return std::unique_ptr<node>();
+        node *const           last  = tail->_prev;
+        std::unique_ptr<node> chain = std::move(_unipHead);
+        _unipHead                   = std::move(last->_next);
+        _unipHead->_prev            = nullptr;
+        return chain;
+    }
+
     /// @brief wait data
     /// @return std::move(headLock)
-    std::unique_lock<std::mutex> wait_for_data() {
-        std::unique_lock<std::mutex> headLock(_mtxHead);
+    std::unique_lock<Mutex> wait_for_data() {
+        std::unique_lock<Mutex> headLock(_mtxHead);
         _condvData.wait(headLock, [&]() { return _unipHead.get() != get_tail() || _stopFlag.load() == true; });
         return std::move(headLock);
     }
@@ -123,7 +223,7 @@ private:
     /// @brief wait and pop head node
     /// @return pop_head() or nullptr
     std::unique_ptr<node> wait_pop_head() {
-        std::unique_lock<std::mutex> headLock(wait_for_data());
+        std::unique_lock<Mutex> headLock(wait_for_data());
         if (_stopFlag.load()) return nullptr;
         return pop_head();
     }
@@ -132,7 +232,7 @@ private:
     /// @param value_
     /// @return pop_head() or nullptr
     std::unique_ptr<node> wait_pop_head(T &value_) {
-        std::unique_lock<std::mutex> headLock(wait_for_data());
+        std::unique_lock<Mutex> headLock(wait_for_data());
         if (_stopFlag.load()) return nullptr;
         value_ = std::move(*_unipHead->_data);
         return pop_head();
@@ -141,7 +241,7 @@ private:
     /// @brief try to pop
     /// @return  pop_head() or std::unique_ptr<node>()
     std::unique_ptr<node> try_pop_head() {
-        std::lock_guard<std::mutex> headLock(_mtxHead);
+        std::lock_guard<Mutex> headLock(_mtxHead);
         if (_unipHead.get() == get_tail()) {
             return std::unique_ptr<node>(); // queue is empty
         }
@@ -152,7 +252,7 @@ private:
     /// @param value
     /// @return pop_head() or std::unique_ptr<node>()
     std::unique_ptr<node> try_pop_head(T &value) {
-        std::lock_guard<std::mutex> headLock(_mtxHead);
+        std::lock_guard<Mutex> headLock(_mtxHead);
         if (_unipHead.get() == get_tail()) {
             return std::unique_ptr<node>();
         }
@@ -161,12 +261,19 @@ private:
     }
 
 private:
-    std::mutex              _mtxHead;
-    std::mutex              _mtxTail;
-    std::unique_ptr<node>   _unipHead;
-    node                   *_nodeTail;
-    std::condition_variable _condvData;
-    std::atomic_bool        _stopFlag;
+    /// @brief std::mutex 用 condition_variable, 其他互斥量用 condition_variable_any
+    using CondVar = typename std::conditional<std::is_same<Mutex, std::mutex>::value, std::condition_variable,
+                                              std::condition_variable_any>::type;
+
+    Mutex                 _mtxHead;
+    Mutex                 _mtxTail;
+    std::unique_ptr<node> _unipHead;
+    node                 *_nodeTail;
+    CondVar               _condvData;
+    std::atomic_bool      _stopFlag;
+#ifdef QUEUE_LATENCY_TRACKING
+    latency::Histogram _latency;
+#endif
 };
 
 #endif //__THREAD_SAFE_QUEUE__
\ No newline at end of file
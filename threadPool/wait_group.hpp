@@ -0,0 +1,66 @@
+#ifndef __WAIT_GROUP__
+#define __WAIT_GROUP__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/// @brief 等待一组任务完成的计数器
+/// add(n) 登记任务, 每个任务结束时 done(), wait() 阻塞到计数归零.
+/// _count 的增减都在 _mtx 内完成, wait() 在锁内确认计数为0才返回;
+/// 此时最后一个 done() 已经释放锁且不再访问成员, 只要之后没有新的 add(),
+/// wait() 返回后即可安全析构. _count 仍是原子量, 供 finished() 无锁读取.
+class WaitGroup {
+public:
+    WaitGroup()
+        : _count(0) {}
+    WaitGroup(const WaitGroup &)            = delete;
+    WaitGroup &operator=(const WaitGroup &) = delete;
+
+    void add(long n_ = 1) {
+        if (n_ <= 0) return;
+        std::lock_guard<std::mutex> lock(_mtx);
+        _count.fetch_add(n_, std::memory_order_relaxed);
+    }
+
+    void done() {
+        std::lock_guard<std::mutex> lock(_mtx);
+        if (_count.fetch_sub(1, std::memory_order_acq_rel) == 1) _condv.notify_all();
+    }
+
+    bool finished() const { return _count.load(std::memory_order_acquire) == 0; }
+
+    /// @brief 先自旋一小段, 仍未完成再进入条件变量等待
+    void wait() {
+        for (int spin = 0; spin < kSpinCount && !finished(); ++spin) {
+            std::this_thread::yield();
+        }
+        wait_locked();
+    }
+
+    /// @brief 等待期间调用 help_() 帮忙执行其他任务, help_ 返回false表示无事可做
+    /// @tparam Helper
+    /// @param help_
+    template <typename Helper>
+    void wait(Helper help_) {
+        while (!finished()) {
+            if (!help_()) std::this_thread::yield();
+        }
+        wait_locked();
+    }
+
+private:
+    void wait_locked() {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _condv.wait(lock, [this]() { return _count.load(std::memory_order_relaxed) == 0; });
+    }
+
+    static constexpr int kSpinCount = 64;
+
+    std::atomic<long>       _count;
+    std::mutex              _mtx;
+    std::condition_variable _condv;
+};
+
+#endif //__WAIT_GROUP__
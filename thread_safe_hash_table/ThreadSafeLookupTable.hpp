@@ -1,6 +1,7 @@
 #ifndef __THREAD_SAFE_LOOKUP_TABLE__
 #define __THREAD_SAFE_LOOKUP_TABLE__
 
+#include "threadPool/profiled_mutex.hpp"
 #include <algorithm>
 #include <list>
 #include <map>
@@ -9,7 +10,11 @@
 #include <shared_mutex>
 #include <vector>
 
-template <typename Key, typename Value, typename Hash = std::hash<Key>>
+/// @brief 分桶加读写锁的哈希表
+/// @tparam SharedMutex 每个桶的读写锁类型, 换成 ProfiledMutex<std::shared_mutex> 可统计锁竞争,
+/// 热点桶读多写少时换成 DistributedSharedMutex
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename SharedMutex = std::shared_mutex>
 class ThreadSafeLookUpTable {
 public:
     ThreadSafeLookUpTable(unsigned    num_buckets_ = 23,
@@ -47,10 +52,10 @@ public:
     }
 
     std::map<Key, Value> get_map() {
-        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        std::vector<std::unique_lock<SharedMutex>> locks;
         for (unsigned i = 0; i < _vecBuckets.size(); ++i) {
             locks.push_back(
-                std::unique_lock<std::shared_mutex>(_vecBuckets[i]->_smtx));
+                std::unique_lock<SharedMutex>(_vecBuckets[i]->_smtx));
         }
         std::map<Key, Value> res;
         for (unsigned i = 0; i < _vecBuckets.size(); ++i) {
@@ -74,8 +79,11 @@ private:
         using bucket_value    = std::pair<Key, Value>;   // 存储元素类型
         using bucket_lst_data = std::list<bucket_value>; // 链表
         using bucket_iterator = typename bucket_lst_data::iterator; // 迭代器
-        bucket_lst_data           _data; // 链表构成的数据内容
-        mutable std::shared_mutex _smtx;
+        bucket_lst_data     _data; // 链表构成的数据内容
+        mutable SharedMutex _smtx;
+
+    public:
+        Bucket_type() { name_lock(_smtx, "ThreadSafeLookUpTable::bucket"); }
 
     private:
         bucket_iterator find_entry_for(const Key &key) {
@@ -88,8 +96,8 @@ private:
         /// @brief //查找key值，找到返回对应的value，未找到则返回默认值
         /// @return Value
         Value value_for(const Key &key, const Value &default_value) {
-            std::shared_lock<std::shared_mutex> shard_lock(_smtx);
-            bucket_iterator const               find_iter = find_entry_for(key);
+            std::shared_lock<SharedMutex> shard_lock(_smtx);
+            bucket_iterator const         find_iter = find_entry_for(key);
             return find_iter == _data.end() ? default_value : find_iter->second;
         }
 
@@ -97,8 +105,8 @@ private:
         /// @param key
         /// @param value
         void add_or_update(const Key &key, const Value &value) {
-            std::unique_lock<std::shared_mutex> unique_lock(_smtx);
-            bucket_iterator const               find_iter = find_entry_for(key);
+            std::unique_lock<SharedMutex> unique_lock(_smtx);
+            bucket_iterator const         find_iter = find_entry_for(key);
             if (find_iter == _data.end()) { // add
                 _data.push_back(bucket_value(key, value));
             } else {
@@ -110,8 +118,8 @@ private:
         /// @param key
         /// @return bool
         bool delete_elem(const Key &key) {
-            std::unique_lock<std::shared_mutex> unique_lock(_smtx);
-            bucket_iterator const               find_iter = find_entry_for(key);
+            std::unique_lock<SharedMutex> unique_lock(_smtx);
+            bucket_iterator const         find_iter = find_entry_for(key);
             if (find_iter != _data.end()) {
                 _data.erase(find_iter);
                 return true;
@@ -6,14 +6,24 @@
  * @LastEditors: Ye Guosheng
  * @Description: thread safe list
  */
+#ifndef __THREAD_SAFE_LIST__
+#define __THREAD_SAFE_LIST__
+
+#include "threadPool/profiled_mutex.hpp"
 #include <iostream>
 #include <memory>
 #include <mutex>
 
-template <typename T>
+/// @brief 每个结点一把锁的链表, 遍历时交替加锁
+/// @tparam T
+/// @tparam Mutex 互斥量类型, 换成 ProfiledMutex<> 可统计锁竞争
+template <typename T, typename Mutex = std::mutex>
 class ThraedSafeList {
 public:
-    ThraedSafeList() { _lstNodePtr = &_headNode; }
+    ThraedSafeList() {
+        _lstNodePtr = &_headNode;
+        name_lock(_lstNodeMtx, "ThraedSafeList::tail");
+    }
     ~ThraedSafeList() {
         remove_if([](listNode const &) { return true; });
     }
@@ -25,11 +35,11 @@ public:
     /// @param f_
     template <typename Fun>
     void for_each(Fun f_) {
-        listNode                    *current = &_headNode;
-        std::unique_lock<std::mutex> cur_lock(_headNode.nodeMtx);
+        listNode               *current = &_headNode;
+        std::unique_lock<Mutex> cur_lock(_headNode.nodeMtx);
 
         while (listNode *const next = current->next.get()) {
-            std::unique_lock<std::mutex> next_lock(next->nodeMtx);
+            std::unique_lock<Mutex> next_lock(next->nodeMtx);
             cur_lock.unlock();
             f_(*(next->data)); // for each data
             current  = next;
@@ -43,10 +53,10 @@ public:
     /// @return shared_ptr
     template <typename Pred>
     std::shared_ptr<T> find_first_if(Pred p_) {
-        listNode                    *current = &_headNode;
-        std::unique_lock<std::mutex> cur_lock(_headNode.nodeMtx);
+        listNode               *current = &_headNode;
+        std::unique_lock<Mutex> cur_lock(_headNode.nodeMtx);
         while (listNode *const next = current->next.get()) {
-            std::unique_lock<std::mutex> next_lock(next->nodeMtx);
+            std::unique_lock<Mutex> next_lock(next->nodeMtx);
             cur_lock.unlock();
             if (p_(*(next->data))) {
                 return next->data;
@@ -62,11 +72,11 @@ public:
     /// @param p_
     template <typename Pred>
     void remove_if(Pred p_) {
-        listNode                    *current = &_headNode;
-        std::unique_lock<std::mutex> cur_lock(_headNode.nodeMtx);
+        listNode               *current = &_headNode;
+        std::unique_lock<Mutex> cur_lock(_headNode.nodeMtx);
 
         while (listNode *const next = current->next.get()) {
-            std::unique_lock<std::mutex> next_lock(next->nodeMtx);
+            std::unique_lock<Mutex> next_lock(next->nodeMtx);
 
             if (p_(*(next->data))) {
                 std::unique_ptr<listNode> oldNode = std::move(current->next);
@@ -74,7 +84,7 @@ public:
 
                 // if delete the last node
                 if (current->next == nullptr) {
-                    std::lock_guard<std::mutex> lst_lock(_lstNodeMtx);
+                    std::lock_guard<Mutex> lst_lock(_lstNodeMtx);
                     _lstNodePtr = current;
                 }
                 next_lock.unlock();
@@ -92,16 +102,16 @@ public:
     /// @return
     template <typename Pred>
     bool remove_fist(Pred p_) {
-        listNode                    *current = &_headNode;
-        std::unique_lock<std::mutex> cur_lock(_headNode.nodeMtx);
+        listNode               *current = &_headNode;
+        std::unique_lock<Mutex> cur_lock(_headNode.nodeMtx);
         while (listNode *const next = current->next.get()) {
-            std::unique_lock<std::mutex> next_lock(next->nodeMtx);
+            std::unique_lock<Mutex> next_lock(next->nodeMtx);
             if (p_(*(next->data))) {
                 std::unique_ptr<listNode> oldNode = std::move(current->next);
                 current->next                     = std::move(next->next);
                 // if delete lst node
                 if (current->next == nullptr) {
-                    std::lock_guard<std::mutex> lst_lock(_lstNodeMtx);
+                    std::lock_guard<Mutex> lst_lock(_lstNodeMtx);
                     _lstNodePtr = current;
                 }
                 next_lock.unlock();
@@ -117,13 +127,13 @@ public:
     /// @brief push new node by front insert
     /// @param value
     void push_front(T const &value) {
-        std::unique_ptr<listNode>   newNode(new listNode(value));
-        std::lock_guard<std::mutex> cur_lock(_headNode.nodeMtx);
+        std::unique_ptr<listNode> newNode(new listNode(value));
+        std::lock_guard<Mutex>    cur_lock(_headNode.nodeMtx);
         newNode->next  = std::move(_headNode.next);
         _headNode.next = std::move(newNode);
 
         if (_headNode.next->next == nullptr) { // update tail point
-            std::lock_guard<std::mutex> lskMtx(_lstNodeMtx);
+            std::lock_guard<Mutex> lskMtx(_lstNodeMtx);
             _lstNodePtr = _headNode.next.get();
         }
     }
@@ -133,9 +143,8 @@ public:
     void push_back(T const &value) {
         std::unique_ptr<listNode> newNode(new listNode(value));
         std::lock(_lstNodePtr->nodeMtx, _lstNodeMtx);
-        std::unique_lock<std::mutex> lock(_lstNodePtr->nodeMtx,
-                                          std::adopt_lock);
-        std::unique_lock<std::mutex> lst_lock(_lstNodeMtx, std::adopt_lock);
+        std::unique_lock<Mutex> lock(_lstNodePtr->nodeMtx, std::adopt_lock);
+        std::unique_lock<Mutex> lst_lock(_lstNodeMtx, std::adopt_lock);
 
         _lstNodePtr->next = std::move(newNode);
         _lstNodePtr       = _lstNodePtr->next.get();
@@ -143,10 +152,10 @@ public:
 
     template <typename Pred>
     void insert_if(Pred p_, T const &value) {
-        listNode                    *current = &_headNode;
-        std::unique_lock<std::mutex> cur_lock(_headNode.nodeMtx);
+        listNode               *current = &_headNode;
+        std::unique_lock<Mutex> cur_lock(_headNode.nodeMtx);
         while (listNode *const next = current->next.get()) {
-            std::unique_lock<std::mutex> next_lock(next->nodeMtx);
+            std::unique_lock<Mutex> next_lock(next->nodeMtx);
             if (p_(*(next->data))) { // find location
                 std::unique_ptr<listNode> new_node(new listNode(value));
 
@@ -164,17 +173,30 @@ public:
 
 private:
     struct listNode {
-        std::mutex                nodeMtx;
+        Mutex                     nodeMtx;
         std::shared_ptr<T>        data;
         std::unique_ptr<listNode> next;
 
         listNode()
-            : next() {}
+            : next() {
+            name_lock(nodeMtx, &lock_stats);
+        }
         listNode(const T &value)
-            : data(std::make_unique<T>(value)) {}
+            : data(std::make_unique<T>(value)) {
+            name_lock(nodeMtx, &lock_stats);
+        }
+
+        /// @brief 每插入一个结点就建一把锁, 只在第一次查统计登记表
+        static lock_profile::LockStats &lock_stats() {
+            static lock_profile::LockStats &stats =
+                lock_profile::Registry::instance().stats_for("ThraedSafeList::node");
+            return stats;
+        }
     };
 
-    listNode   _headNode;
-    listNode  *_lstNodePtr;
-    std::mutex _lstNodeMtx;
+    listNode  _headNode;
+    listNode *_lstNodePtr;
+    Mutex     _lstNodeMtx;
 };
+
+#endif //__THREAD_SAFE_LIST__
@@ -6,16 +6,20 @@
  * @Description:
  */
 
+#ifndef __THREAD_SAFE_QUEUE_MUTEX__
+#define __THREAD_SAFE_QUEUE_MUTEX__
+
+#include "threadPool/lock_free_thread_safe_queue.hpp"
 #include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <queue>
-#include <winnt.h>
 
+/// @brief 一把互斥锁保护 std::queue, 每次 push 都 notify; 保留作对照基准
 template <typename T>
-class ThreadSafeQueue {
+class MutexThreadSafeQueue {
 public:
-    ThreadSafeQueue() {}
+    MutexThreadSafeQueue() {}
     void               push(T new_value);
     void               wait_and_pop(T &value);
     std::shared_ptr<T> wait_and_pop();
@@ -30,7 +34,7 @@ private:
 };
 
 template <typename T>
-void ThreadSafeQueue<T>::push(T new_value) {
+void MutexThreadSafeQueue<T>::push(T new_value) {
     std::shared_ptr<T>          data(std::make_shared<T>(std::move(new_value)));
     std::lock_guard<std::mutex> lock(_mtx);
     _data_queue.push(data);
@@ -38,7 +42,7 @@ void ThreadSafeQueue<T>::push(T new_value) {
 }
 
 template <typename T>
-void ThreadSafeQueue<T>::wait_and_pop(T &value) {
+void MutexThreadSafeQueue<T>::wait_and_pop(T &value) {
     std::unique_lock<std::mutex> lock(_mtx);
     _cv.wait(lock, [this]() { return !_data_queue.empty(); });
     value = std::move(*_data_queue.front());
@@ -46,16 +50,16 @@ void ThreadSafeQueue<T>::wait_and_pop(T &value) {
 }
 
 template <typename T>
-std::shared_ptr<T> ThreadSafeQueue<T>::wait_and_pop() {
+std::shared_ptr<T> MutexThreadSafeQueue<T>::wait_and_pop() {
     std::unique_lock<std::mutex> lock(_mtx);
     _cv.wait(lock, [this]() { return !_data_queue.empty(); });
     std::shared_ptr<T> res = _data_queue.front();
     _data_queue.pop();
     return res;
-} 
+}
 
 template <typename T>
-bool ThreadSafeQueue<T>::try_pop(T &value) {
+bool MutexThreadSafeQueue<T>::try_pop(T &value) {
     std::lock_guard<std::mutex> lock(_mtx);
     if (_data_queue.empty()) return false;
     value = std::move(*_data_queue.front());
@@ -64,16 +68,22 @@ bool ThreadSafeQueue<T>::try_pop(T &value) {
 }
 
 template <typename T>
-std::shared_ptr<T> ThreadSafeQueue<T>::try_pop() {
+std::shared_ptr<T> MutexThreadSafeQueue<T>::try_pop() {
     std::unique_lock<std::mutex> lock(_mtx);
-    if (_data_queue.empty()) return false;
+    if (_data_queue.empty()) return std::shared_ptr<T>();
     std::shared_ptr<T> res = _data_queue.front();
     _data_queue.pop();
     return res;
 }
 
 template <typename T>
-bool ThreadSafeQueue<T>::empty() const {
+bool MutexThreadSafeQueue<T>::empty() const {
     std::lock_guard<std::mutex> lock(_mtx);
     return _data_queue.empty();
-}
\ No newline at end of file
+}
+
+/// @brief 调用方使用的 ThreadSafeQueue 换成无锁实现, 接口不变
+template <typename T>
+using ThreadSafeQueue = LockFreeThreadSafeQueue<T>;
+
+#endif //__THREAD_SAFE_QUEUE_MUTEX__
@@ -8,6 +8,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 template <typename T>
 class ThreadSafeQueueHT {
@@ -28,13 +29,13 @@ public:
     }
 
     std::shared_ptr<T> try_pop() {
-        std::unique_lock<node> old_head = try_pop_head();
+        std::unique_ptr<node> old_head = try_pop_head();
         return old_head ? old_head->data : std::shared_ptr<T>();
     }
 
     bool try_pop(T &value) {
-        std::unique_lock<node> const old_head = try_pop_head(value);
-        return old_head;
+        std::unique_ptr<node> const old_head = try_pop_head(value);
+        return static_cast<bool>(old_head);
     }
 
     bool empty() {
@@ -42,6 +43,29 @@ public:
         return (_upHead.get() == get_tail());
     }
 
+    /// @brief 一次加锁从头部切下至多 max_ 个元素, 解锁后依次移动写入 out_; 队列为空时不等待
+    /// @return 取出的个数
+    template <typename OutputIt>
+    std::size_t pop_n(OutputIt out_, std::size_t max_) {
+        std::size_t           count = 0;
+        std::unique_ptr<node> chain = pop_head_n(max_, count);
+        for (std::size_t i = 0; i < count; ++i, ++out_) {
+            *out_ = std::move(*chain->data);
+            chain = std::move(chain->next); // 逐个释放, 长链不会递归析构
+        }
+        return count;
+    }
+
+    /// @brief 一次加锁取走当前所有元素
+    std::vector<T> pop_all() {
+        std::vector<T>        values;
+        std::unique_ptr<node> chain = pop_head_all();
+        for (; chain && chain->next; chain = std::move(chain->next)) {
+            values.push_back(std::move(*chain->data));
+        }
+        return values;
+    }
+
 
     /// @param new_value 
     void push(T new_value) {
@@ -74,6 +98,37 @@ private:
         return _pTail;
     }
 
+    /// @brief 持头锁, 只取一次尾指针, 从头部切下至多 max_ 个结点
+    /// 尾指针之前的结点 push 不会再改, 遍历无需尾锁
+    std::unique_ptr<node> pop_head_n(std::size_t max_, std::size_t &count_) {
+        std::lock_guard<std::mutex> head_lock(_headMtx);
+        node *const                 tail = get_tail();
+        node                       *last = nullptr;
+        count_                           = 0;
+        for (node *p = _upHead.get(); p != tail && count_ < max_; p = p->next.get()) {
+            last = p;
+            ++count_;
+        }
+        if (!last) return std::unique_ptr<node>();
+        std::unique_ptr<node> chain = std::move(_upHead);
+        _upHead                     = std::move(last->next);
+        return chain;
+    }
+
+    /// @brief 头尾锁各加一次: 整条链连同尾部虚位结点一起切下, 换上新的虚位结点
+    /// @return 切下的链, 末结点是旧的虚位结点 (无数据); 队列为空时返回空
+    std::unique_ptr<node> pop_head_all() {
+        std::unique_ptr<node>        dummy(new node);
+        std::unique_lock<std::mutex> head_lock(_headMtx, std::defer_lock);
+        std::unique_lock<std::mutex> tail_lock(_tailMtx, std::defer_lock);
+        std::lock(head_lock, tail_lock);
+        if (_upHead.get() == _pTail) return std::unique_ptr<node>(); // 已持有尾锁, 不能再调用get_tail()
+        _pTail                      = dummy.get();
+        std::unique_ptr<node> chain = std::move(_upHead);
+        _upHead                     = std::move(dummy);
+        return chain;
+    }
+
     std::unique_ptr<node> pop_head() {
         std::unique_ptr<node> old_node = std::move(_upHead);
         _upHead                        = std::move(old_node->next);
@@ -93,6 +148,7 @@ private:
     }
     std::unique_ptr<node> wait_pop_head(T &value) {
         std::unique_lock<std::mutex> head_lock(wait_for_data());
+        value = std::move(*_upHead->data);
         return pop_head();
     }
 
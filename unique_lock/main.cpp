@@ -6,6 +6,9 @@
  * @Description: ref:
  * https://gitee.com/secondtonone1/boostasio-learn/blob/master/concurrent/day03-uniquelock/unique_lock/unique_lock.cpp
  */
+#include "threadPool/distributed_shared_mutex.hpp"
+#include "threadPool/profiled_mutex.hpp"
+#include "threadPool/rcu_map.hpp"
 #include <iostream>
 #include <map>
 #include <mutex>
@@ -174,14 +177,17 @@ void precision_lock() {
 // C++ 17 标准shared_mutex
 // C++14  提供了shared_time_mutex
 // C++11 无上述互斥，想使用可以利用boost库
+// SharedMutex 换成 ProfiledMutex<std::shared_mutex> 可统计读写锁的竞争情况;
+// 查询远多于更新时换成 DistributedSharedMutex, 读者各写各的缓存行, 读吞吐随核数增长
+template <typename SharedMutex = std::shared_mutex>
 class DNService {
 public:
-    DNService() {}
+    DNService() { name_lock(_shared_mtx, "DNService"); }
     // 读操作采用共享锁
     std::string QueryDNS(std::string dnsname) {
         // 读操作使用shared_lock管理shared_mtx
-        std::shared_lock<std::shared_mutex> shared_locks(_shared_mtx);
-        auto                                iter = _dns_info.find(dnsname);
+        std::shared_lock<SharedMutex> shared_locks(_shared_mtx);
+        auto                          iter = _dns_info.find(dnsname);
         if (iter != _dns_info.end()) {
             return iter->second;
         }
@@ -191,16 +197,62 @@ public:
 
     // 写操作采用独占锁
     void AddDNSInfo(std::string dnsname, std::string dnsentry) {
-        std::lock_guard<std::shared_mutex> guard_locks(
+        std::lock_guard<SharedMutex> guard_locks(
             _shared_mtx); // or unique_lock
         _dns_info.insert(std::make_pair(dnsname, dnsentry));
     }
 
 private:
     std::map<std::string, std::string> _dns_info;
-    mutable std::shared_mutex          _shared_mtx;
+    mutable SharedMutex                _shared_mtx;
 };
 
+// 更新极少 (约百万次查询一次更新) 时不用锁: 查询读当前的不可变快照, 更新复制一份再整体发布,
+// 旧快照延迟回收, 查询延迟不受更新影响
+class DNServiceRcu {
+public:
+    std::string QueryDNS(std::string const &dnsname) const { return _dns_info.value_for(dnsname); }
+
+    void AddDNSInfo(std::string const &dnsname, std::string const &dnsentry) {
+        _dns_info.update([&](std::map<std::string, std::string> &info_) { info_.emplace(dnsname, dnsentry); });
+    }
+
+    /// @brief 整表遍历用快照, 不阻塞更新
+    RcuMap<std::string, std::string, std::map<std::string, std::string>>::Snapshot Entries() const {
+        return _dns_info.snapshot();
+    }
+
+private:
+    RcuMap<std::string, std::string, std::map<std::string, std::string>> _dns_info;
+};
+
+void use_dns_service_rcu() {
+    DNServiceRcu service;
+    service.AddDNSInfo("localhost", "127.0.0.1");
+    auto const  entries = service.Entries();
+    std::thread writer([&service]() { service.AddDNSInfo("example.com", "93.184.216.34"); });
+    writer.join();
+    std::cout << "localhost -> " << service.QueryDNS("localhost") << ", example.com -> "
+              << service.QueryDNS("example.com") << ", entries in old snapshot: " << entries->size() << std::endl;
+}
+
+// 读多写少时统计 DNService 的锁竞争, 可对比 std::shared_mutex 与 DistributedSharedMutex
+template <typename SharedMutex = std::shared_mutex>
+void profile_dns_service() {
+    DNService<ProfiledMutex<SharedMutex>> service;
+    std::thread writer([&service]() {
+        for (int i = 0; i < 1000; ++i) {
+            service.AddDNSInfo("host" + std::to_string(i), "10.0.0." + std::to_string(i % 256));
+        }
+    });
+    std::thread reader([&service]() {
+        for (int i = 0; i < 10000; ++i) service.QueryDNS("host" + std::to_string(i % 1000));
+    });
+    writer.join();
+    reader.join();
+    lock_profile::write_report(std::cout);
+}
+
 // 利用递归锁
 class RecursiveDemo {
 public:
@@ -254,4 +306,7 @@ int main() {
     // safe_swap();
     // safe_swap2();
     use_return();
+    // profile_dns_service();
+    // profile_dns_service<DistributedSharedMutex>();
+    // use_dns_service_rcu();
 }